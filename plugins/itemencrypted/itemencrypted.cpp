@@ -591,7 +591,10 @@ ItemSaverPtr ItemEncryptedLoader::initializeTab(QAbstractItemModel *)
 QObject *ItemEncryptedLoader::tests(const TestInterfacePtr &test) const
 {
 #ifdef HAS_TESTS
+    QVariantMap settings;
+    settings["encrypt_tabs"] = QStringList() << ItemEncryptedTests::testTab(1);
     QObject *tests = new ItemEncryptedTests(test);
+    tests->setProperty("CopyQ_test_settings", settings);
     return tests;
 #else
     Q_UNUSED(test);
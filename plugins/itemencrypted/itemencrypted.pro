@@ -10,6 +10,7 @@ SOURCES += \
     ../../src/common/mimetypes.cpp \
     ../../src/gui/iconfont.cpp \
     ../../src/gui/iconwidget.cpp \
+    ../../src/item/itemcodec.cpp \
     ../../src/item/serialize.cpp
 FORMS   += itemencryptedsettings.ui
 
@@ -27,6 +27,11 @@ ItemEncryptedTests::ItemEncryptedTests(const TestInterfacePtr &test, QObject *pa
 {
 }
 
+QString ItemEncryptedTests::testTab(int i)
+{
+    return ::testTab(i);
+}
+
 void ItemEncryptedTests::initTestCase()
 {
     if ( qgetenv("COPYQ_TESTS_SKIP_ITEMENCRYPT") == "1" )
@@ -73,6 +78,53 @@ void ItemEncryptedTests::encryptDecryptData()
     QCOMPARE(stdoutActual, input);
 }
 
+void ItemEncryptedTests::noSearchIndexForEncryptedTab()
+{
+    if ( !isGpgInstalled() )
+        SKIP("gpg2 is required to run the test");
+
+#if !defined(Q_OS_UNIX) || defined(Q_OS_MAC)
+    SKIP("Tab data files are looked up next to configuration file only on Linux");
+#endif
+
+    RUN("-e" << "plugins.itemencrypted.generateTestKeys()", "");
+
+    // Only the first test tab is encrypted (see ItemEncryptedLoader::tests()).
+    const QString encryptedTab = testTab(1);
+    const QString plainTab = testTab(2);
+    RUN("tab" << encryptedTab << "add" << "secret", "");
+    RUN("tab" << plainTab << "add" << "public", "");
+
+    // Changing configuration saves and unloads all tabs.
+    RUN("config" << "maxitems" << "99", "99\n");
+
+    WAIT_ON_OUTPUT("-e" << tabFilesExist(plainTab), "true true\n");
+    RUN("-e" << tabFilesExist(encryptedTab), "true false\n");
+}
+
+void ItemEncryptedTests::noArchiveForEncryptedTab()
+{
+    if ( !isGpgInstalled() )
+        SKIP("gpg2 is required to run the test");
+
+    RUN("-e" << "plugins.itemencrypted.generateTestKeys()", "");
+
+    RUN("config" << "archive_items" << "true", "true\n");
+    RUN("config" << "maxitems" << "2", "2\n");
+
+    const QString encryptedTab = testTab(1);
+    const QString plainTab = testTab(2);
+    for ( const auto &tab : {encryptedTab, plainTab} ) {
+        RUN("tab" << tab << "add" << "C" << "B", "");
+        RUN("tab" << tab << "add" << "A", "");
+        RUN("tab" << tab << "read" << "0" << "1", "A\nB");
+    }
+
+    // Oldest item is removed from both tabs but archived only from the plain one.
+    RUN("tab" << encryptedTab << "archiveSize", "0\n");
+    RUN("tab" << plainTab << "archiveSize", "1\n");
+}
+
 bool ItemEncryptedTests::isGpgInstalled() const
 {
     QByteArray actualStdout;
@@ -81,3 +133,13 @@ bool ItemEncryptedTests::isGpgInstalled() const
     Q_ASSERT(actualStdout == "true\n" || actualStdout == "false\n");
     return actualStdout == "true\n";
 }
+
+QString ItemEncryptedTests::tabFilesExist(const QString &tabName) const
+{
+    // Same as itemFileName() in "item/itemstore.cpp".
+    return QString(
+        "var fileName = info('config').replace(/\\.[^./]*$/, '_tab_')"
+        "    + str(tobase64('%1')).replace(/\\//g, '-') + '.dat'"
+        "; print(new File(fileName).exists() + ' ' + new File(fileName + '.search').exists() + '\\n')"
+        ).arg(tabName);
+}
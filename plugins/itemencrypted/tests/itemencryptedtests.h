@@ -30,6 +30,8 @@ class ItemEncryptedTests : public QObject
 public:
     explicit ItemEncryptedTests(const TestInterfacePtr &test, QObject *parent = nullptr);
 
+    static QString testTab(int i);
+
 private slots:
     void initTestCase();
     void cleanupTestCase();
@@ -38,9 +40,16 @@ private slots:
 
     void encryptDecryptData();
 
+    void noSearchIndexForEncryptedTab();
+
+    void noArchiveForEncryptedTab();
+
 private:
     bool isGpgInstalled() const;
 
+    /// Return script printing "<tab file exists> <search index exists>" for a tab.
+    QString tabFilesExist(const QString &tabName) const;
+
     TestInterfacePtr m_test;
 };
 
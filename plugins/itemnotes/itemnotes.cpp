@@ -334,10 +334,9 @@ ItemWidget *ItemNotesLoader::transform(ItemWidget *itemWidget, const QModelIndex
             m_settings["show_tooltip"].toBool() );
 }
 
-bool ItemNotesLoader::matches(const QModelIndex &index, const QRegExp &re) const
+QString ItemNotesLoader::searchableText(const QModelIndex &index) const
 {
-    const QString text = index.data(contentType::notes).toString();
-    return re.indexIn(text) != -1;
+    return index.data(contentType::notes).toString();
 }
 
 Q_EXPORT_PLUGIN2(itemnotes, ItemNotesLoader)
@@ -184,6 +184,26 @@ bool ItemPinnedSaver::saveItems(const QAbstractItemModel &model, QIODevice *file
     return m_saver->saveItems(model, file);
 }
 
+bool ItemPinnedSaver::prepareSaveItemsInBackground()
+{
+    return m_saver->prepareSaveItemsInBackground();
+}
+
+bool ItemPinnedSaver::storesPlainData() const
+{
+    return m_saver->storesPlainData();
+}
+
+bool ItemPinnedSaver::saveChanges(const QAbstractItemModel &model, QIODevice *file)
+{
+    return m_saver->saveChanges(model, file);
+}
+
+bool ItemPinnedSaver::loadChanges(QAbstractItemModel *model, QIODevice *file)
+{
+    return m_saver->loadChanges(model, file);
+}
+
 bool ItemPinnedSaver::canRemoveItems(const QList<QModelIndex> &indexList, QString *error)
 {
     const bool containsPinnedItems = std::any_of(
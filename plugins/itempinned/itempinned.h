@@ -85,6 +85,14 @@ public:
 
     bool saveItems(const QAbstractItemModel &model, QIODevice *file) override;
 
+    bool prepareSaveItemsInBackground() override;
+
+    bool storesPlainData() const override;
+
+    bool saveChanges(const QAbstractItemModel &model, QIODevice *file) override;
+
+    bool loadChanges(QAbstractItemModel *model, QIODevice *file) override;
+
     bool canRemoveItems(const QList<QModelIndex> &indexList, QString *error) override;
 
     bool canMoveItems(const QList<QModelIndex> &indexList) override;
@@ -360,17 +360,8 @@ void FileWatcher::unlock()
 bool FileWatcher::createItemFromFiles(const QDir &dir, const BaseNameExtensions &baseNameWithExts, int targetRow)
 {
     QVariantMap dataMap;
-    QVariantMap mimeToExtension;
-
-    updateDataAndWatchFile(dir, baseNameWithExts, &dataMap, &mimeToExtension);
-
-    if ( !mimeToExtension.isEmpty() ) {
-        dataMap.insert( mimeBaseName, QFileInfo(baseNameWithExts.baseName).fileName() );
-        dataMap.insert(mimeExtensionMap, mimeToExtension);
-
-        if ( !createItem(dataMap, targetRow) )
-            return false;
-    }
+    if ( itemDataFromFiles(dir, baseNameWithExts, &dataMap) )
+        return createItems(QVector<QVariantMap>() << dataMap, targetRow);
 
     return true;
 }
@@ -378,13 +369,20 @@ bool FileWatcher::createItemFromFiles(const QDir &dir, const BaseNameExtensions
 void FileWatcher::createItemsFromFiles(const QDir &dir, const BaseNameExtensionsList &fileList)
 {
     const int maxItems = m_model->property("maxItems").toInt();
+    const int maxNewItems = maxItems - m_model->rowCount();
 
+    // Items are added at once with the last file at the top.
+    QVector<QVariantMap> dataList;
     for (const auto &baseNameWithExts : fileList) {
-        if ( !createItemFromFiles(dir, baseNameWithExts, 0) )
-            return;
-        if ( m_model->rowCount() >= maxItems )
+        if ( dataList.size() >= maxNewItems )
             break;
+
+        QVariantMap dataMap;
+        if ( itemDataFromFiles(dir, baseNameWithExts, &dataMap) )
+            dataList.prepend(dataMap);
     }
+
+    createItems(dataList, 0);
 }
 
 void FileWatcher::updateItems()
@@ -464,16 +462,36 @@ FileWatcher::IndexData &FileWatcher::indexData(const QModelIndex &index)
     return *it;
 }
 
-bool FileWatcher::createItem(const QVariantMap &dataMap, int targetRow)
+bool FileWatcher::createItems(const QVector<QVariantMap> &dataList, int targetRow)
 {
-    const int row = qMax( 0, qMin(targetRow, m_model->rowCount()) );
-    if ( m_model->insertRow(row) ) {
-        const QModelIndex &index = m_model->index(row, 0);
-        updateIndexData(index, dataMap);
+    if ( dataList.isEmpty() )
         return true;
+
+    const int row = qMax( 0, qMin(targetRow, m_model->rowCount()) );
+    if ( !m_model->insertRows(row, dataList.size()) )
+        return false;
+
+    for (int i = 0; i < dataList.size(); ++i) {
+        const QModelIndex &index = m_model->index(row + i, 0);
+        updateIndexData(index, dataList[i]);
     }
 
-    return false;
+    return true;
+}
+
+bool FileWatcher::itemDataFromFiles(
+        const QDir &dir, const BaseNameExtensions &baseNameWithExts, QVariantMap *dataMap)
+{
+    QVariantMap mimeToExtension;
+
+    updateDataAndWatchFile(dir, baseNameWithExts, dataMap, &mimeToExtension);
+
+    if ( mimeToExtension.isEmpty() )
+        return false;
+
+    dataMap->insert( mimeBaseName, QFileInfo(baseNameWithExts.baseName).fileName() );
+    dataMap->insert(mimeExtensionMap, mimeToExtension);
+    return true;
 }
 
 void FileWatcher::updateIndexData(const QModelIndex &index, const QVariantMap &itemData)
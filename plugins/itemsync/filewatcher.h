@@ -111,7 +111,12 @@ private:
 
     IndexData &indexData(const QModelIndex &index);
 
-    bool createItem(const QVariantMap &dataMap, int targetRow);
+    /** Insert rows for new items at once and set their data. */
+    bool createItems(const QVector<QVariantMap> &dataList, int targetRow);
+
+    /** Return false if none of the files can be used as item data. */
+    bool itemDataFromFiles(
+            const QDir &dir, const BaseNameExtensions &baseNameWithExts, QVariantMap *dataMap);
 
     void updateIndexData(const QModelIndex &index, const QVariantMap &itemData);
 
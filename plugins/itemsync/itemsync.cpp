@@ -787,11 +787,10 @@ ItemWidget *ItemSyncLoader::transform(ItemWidget *itemWidget, const QModelIndex
     return new ItemSync(baseName, iconForItem(index, m_formatSettings), itemWidget);
 }
 
-bool ItemSyncLoader::matches(const QModelIndex &index, const QRegExp &re) const
+QString ItemSyncLoader::searchableText(const QModelIndex &index) const
 {
     const QVariantMap dataMap = index.data(contentType::data).toMap();
-    const QString text = dataMap.value(mimeBaseName).toString();
-    return re.indexIn(text) != -1;
+    return dataMap.value(mimeBaseName).toString();
 }
 
 QObject *ItemSyncLoader::tests(const TestInterfacePtr &test) const
@@ -18,6 +18,7 @@ SOURCES += \
     ../../src/gui/iconselectbutton.cpp \
     ../../src/gui/iconselectdialog.cpp \
     ../../src/gui/iconwidget.cpp \
+    ../../src/item/itemcodec.cpp \
     ../../src/item/serialize.cpp
 
 FORMS += itemsyncsettings.ui
@@ -619,9 +619,9 @@ ItemWidget *ItemTagsLoader::transform(ItemWidget *itemWidget, const QModelIndex
     return new ItemTags(itemWidget, tags);
 }
 
-bool ItemTagsLoader::matches(const QModelIndex &index, const QRegExp &re) const
+QString ItemTagsLoader::searchableText(const QModelIndex &index) const
 {
-    return re.indexIn(tags(index)) != -1;
+    return tags(index);
 }
 
 QObject *ItemTagsLoader::tests(const TestInterfacePtr &test) const
@@ -133,7 +133,7 @@ public:
 
     ItemWidget *transform(ItemWidget *itemWidget, const QModelIndex &index) override;
 
-    bool matches(const QModelIndex &index, const QRegExp &re) const override;
+    QString searchableText(const QModelIndex &index) const override;
 
     QObject *tests(const TestInterfacePtr &test) const override;
 
@@ -45,7 +45,7 @@ struct autostart : Config<bool> {
 struct maxitems : Config<int> {
     static QString name() { return "maxitems"; }
     static Value defaultValue() { return 200; }
-    static Value value(Value v) { return qBound(0, v, 10000); }
+    static Value value(Value v) { return qBound(0, v, 1000000); }
 };
 
 struct clipboard_tab : Config<QString> {
@@ -236,6 +236,25 @@ struct command_history_size : Config<int> {
     static Value defaultValue() { return 100; }
 };
 
+struct map_item_data : Config<bool> {
+    static QString name() { return "map_item_data"; }
+    static Value defaultValue() { return false; }
+};
+
+struct tab_memory_limit : Config<int> {
+    static QString name() { return "tab_memory_limit"; }
+    static Value value(Value v) { return qMax(0, v); }
+};
+
+struct total_memory_limit : Config<int> {
+    static QString name() { return "total_memory_limit"; }
+    static Value value(Value v) { return qMax(0, v); }
+};
+
+struct archive_items : Config<bool> {
+    static QString name() { return "archive_items"; }
+};
+
 struct check_selection : Config<bool> {
     static QString name() { return "check_selection"; }
 };
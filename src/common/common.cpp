@@ -42,6 +42,7 @@
 #include <QTextCodec>
 #include <QThread>
 #include <QTimer>
+#include <QtEndian>
 #include <QUrl>
 #include <QWidget>
 #if QT_VERSION < 0x050000
@@ -57,6 +58,103 @@
 
 namespace {
 
+/*
+ * 64-bit hash for item data (XXH64 algorithm).
+ *
+ * Fast enough to hash big images and strong enough to identify items.
+ * Values are saved in tab files so the algorithm must not change.
+ */
+const quint64 hashPrime1 = Q_UINT64_C(11400714785074694791);
+const quint64 hashPrime2 = Q_UINT64_C(14029467366897019727);
+const quint64 hashPrime3 = Q_UINT64_C(1609587929392839161);
+const quint64 hashPrime4 = Q_UINT64_C(9650029242287828579);
+const quint64 hashPrime5 = Q_UINT64_C(2870177450012600261);
+
+quint64 hashRotateLeft(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+quint64 hashRead64(const uchar *data)
+{
+    return qFromLittleEndian<quint64>(data);
+}
+
+quint64 hashRead32(const uchar *data)
+{
+    return qFromLittleEndian<quint32>(data);
+}
+
+quint64 hashRound(quint64 acc, quint64 input)
+{
+    acc += input * hashPrime2;
+    acc = hashRotateLeft(acc, 31);
+    return acc * hashPrime1;
+}
+
+quint64 hashMergeRound(quint64 acc, quint64 value)
+{
+    acc ^= hashRound(0, value);
+    return acc * hashPrime1 + hashPrime4;
+}
+
+quint64 hash64(const uchar *data, size_t size, quint64 seed)
+{
+    const uchar *end = data + size;
+    quint64 h;
+
+    if (size >= 32) {
+        const uchar *limit = end - 32;
+        quint64 v1 = seed + hashPrime1 + hashPrime2;
+        quint64 v2 = seed + hashPrime2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - hashPrime1;
+
+        do {
+            v1 = hashRound(v1, hashRead64(data));
+            v2 = hashRound(v2, hashRead64(data + 8));
+            v3 = hashRound(v3, hashRead64(data + 16));
+            v4 = hashRound(v4, hashRead64(data + 24));
+            data += 32;
+        } while (data <= limit);
+
+        h = hashRotateLeft(v1, 1) + hashRotateLeft(v2, 7)
+          + hashRotateLeft(v3, 12) + hashRotateLeft(v4, 18);
+        h = hashMergeRound(h, v1);
+        h = hashMergeRound(h, v2);
+        h = hashMergeRound(h, v3);
+        h = hashMergeRound(h, v4);
+    } else {
+        h = seed + hashPrime5;
+    }
+
+    h += static_cast<quint64>(size);
+
+    for ( ; data + 8 <= end; data += 8 ) {
+        h ^= hashRound(0, hashRead64(data));
+        h = hashRotateLeft(h, 27) * hashPrime1 + hashPrime4;
+    }
+
+    if (data + 4 <= end) {
+        h ^= hashRead32(data) * hashPrime1;
+        h = hashRotateLeft(h, 23) * hashPrime2 + hashPrime3;
+        data += 4;
+    }
+
+    for ( ; data < end; ++data ) {
+        h ^= *data * hashPrime5;
+        h = hashRotateLeft(h, 11) * hashPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= hashPrime2;
+    h ^= h >> 29;
+    h *= hashPrime3;
+    h ^= h >> 32;
+
+    return h;
+}
+
 QString getImageFormatFromMime(const QString &mime)
 {
     const auto imageMimePrefix = "image/";
@@ -223,18 +321,38 @@ const QMimeData *clipboardData(QClipboard::Mode mode)
     return data;
 }
 
-uint hash(const QVariantMap &data)
+quint64 hash(const QVariantMap &data)
 {
-    uint hash = 0;
+    QMap<QString, quint64> formatHashes;
+    for ( auto it = data.constBegin(); it != data.constEnd(); ++it )
+        formatHashes.insert( it.key(), hashFormatData(it.value().toByteArray()) );
+
+    return hashItemFormats(formatHashes);
+}
+
+quint64 hashFormatData(const QByteArray &bytes)
+{
+    const auto data = reinterpret_cast<const uchar*>( bytes.constData() );
+    return hash64( data, static_cast<size_t>(bytes.size()), 0 );
+}
+
+quint64 hashItemFormats(const QMap<QString, quint64> &formatHashes)
+{
+    quint64 result = hashPrime5;
+
+    for ( auto it = formatHashes.constBegin(); it != formatHashes.constEnd(); ++it ) {
+        const QString &mime = it.key();
 
-    for ( const auto &mime : data.keys() ) {
         // Skip some special data.
         if (mime == mimeWindowTitle || mime == mimeOwner || mime == mimeClipboardMode)
             continue;
-        hash ^= qHash(data[mime].toByteArray()) + qHash(mime);
+
+        const auto mimeData = reinterpret_cast<const uchar*>( mime.constData() );
+        const quint64 mimeHash = hash64( mimeData, static_cast<size_t>(mime.size()) * sizeof(QChar), 0 );
+        result = hashMergeRound( hashMergeRound(result, mimeHash), it.value() );
     }
 
-    return hash;
+    return result;
 }
 
 QString getTextData(const QByteArray &bytes)
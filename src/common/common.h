@@ -76,7 +76,19 @@ bool isMainThread();
 
 const QMimeData *clipboardData(QClipboard::Mode mode = QClipboard::Clipboard);
 
-uint hash(const QVariantMap &data);
+/** Return 64-bit hash of item data. */
+quint64 hash(const QVariantMap &data);
+
+/** Return 64-bit hash of data in single format. */
+quint64 hashFormatData(const QByteArray &bytes);
+
+/**
+ * Return hash of item from hashes of data in each format (see hashFormatData()).
+ *
+ * Hashes are combined in order of format names so the result doesn't depend
+ * on how item data are stored. Some special formats are ignored.
+ */
+quint64 hashItemFormats(const QMap<QString, quint64> &formatHashes);
 
 QString getTextData(const QByteArray &data);
 
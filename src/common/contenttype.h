@@ -60,7 +60,15 @@ enum {
     color,
 
     /// If true, hide content of item (not notes, tags etc.).
-    isHidden
+    isHidden,
+
+    /**
+     * Texts to search in (QStringList).
+     *
+     * Texts are cached in item until its data change.
+     * @see ClipboardModel::setSearchableTextsFunction()
+     */
+    searchableTexts
 };
 
 }
@@ -0,0 +1,203 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "fuzzymatcher.h"
+
+namespace {
+
+// Scores are the same as in fzf.
+const int scoreMatch = 16;
+const int scoreGapStart = -3;
+const int scoreGapExtension = -1;
+const int bonusBoundary = scoreMatch / 2;
+const int bonusCamelCase = bonusBoundary - 1;
+const int bonusConsecutive = -(scoreGapStart + scoreGapExtension);
+const int bonusFirstCharMultiplier = 2;
+const int bonusCase = 1;
+
+/// Bonus for matching character at @a i (start of word or number, camel case).
+int bonusAt(const QString &text, int i)
+{
+    const QChar c = text[i];
+    if ( !c.isLetterOrNumber() )
+        return 0;
+
+    if (i == 0)
+        return bonusBoundary;
+
+    const QChar previous = text[i - 1];
+    if ( !previous.isLetterOrNumber() )
+        return bonusBoundary;
+
+    if ( (previous.isLower() && c.isUpper()) || (!previous.isDigit() && c.isDigit()) )
+        return bonusCamelCase;
+
+    return 0;
+}
+
+} // namespace
+
+FuzzyMatcher::FuzzyMatcher(const QString &query, Qt::CaseSensitivity cs)
+    : m_query()
+    , m_foldedQuery()
+    , m_cs(cs)
+{
+    for (const auto &c : query) {
+        if ( !c.isSpace() ) {
+            m_query.append(c);
+            m_foldedQuery.append(cs == Qt::CaseSensitive ? c : c.toLower());
+        }
+    }
+}
+
+FuzzyMatcher FuzzyMatcher::fromRegExp(const QRegExp &re)
+{
+    const QString pattern = re.pattern();
+    QString query;
+
+    // Pattern is escaped characters separated by ".*".
+    for (int i = 0; i < pattern.size(); ++i) {
+        if ( !query.isEmpty() ) {
+            if ( pattern.mid(i, 2) != ".*" || i + 2 >= pattern.size() )
+                return FuzzyMatcher(QString(), re.caseSensitivity());
+            i += 2;
+        }
+
+        if (pattern[i] == '\\') {
+            if (++i == pattern.size())
+                return FuzzyMatcher(QString(), re.caseSensitivity());
+        }
+
+        query.append(pattern[i]);
+    }
+
+    FuzzyMatcher matcher(query, re.caseSensitivity());
+    if ( matcher.regExp().pattern() != pattern )
+        return FuzzyMatcher(QString(), re.caseSensitivity());
+
+    return matcher;
+}
+
+bool FuzzyMatcher::matchesAny(const QStringList &texts) const
+{
+    for (const auto &text : texts) {
+        if ( matches(text) )
+            return true;
+    }
+
+    return false;
+}
+
+int FuzzyMatcher::score(const QString &text) const
+{
+    const int queryLength = m_foldedQuery.size();
+    if (queryLength == 0)
+        return 0;
+
+    const int end = matchEnd(text);
+    if (end == -1)
+        return -1;
+
+    // Find shortest match ending at the same character.
+    const bool caseSensitive = m_cs == Qt::CaseSensitive;
+    int start = end;
+    int q = queryLength - 1;
+    for (int i = end; i >= 0; --i) {
+        if ( matchesAt(text, i, q) && --q < 0 ) {
+            start = i;
+            break;
+        }
+    }
+
+    int score = 0;
+    int consecutive = 0;
+    int firstBonus = 0;
+    bool inGap = false;
+    q = 0;
+    for (int i = start; i <= end; ++i) {
+        if ( q < queryLength && matchesAt(text, i, q) ) {
+            int bonus = bonusAt(text, i);
+            if (consecutive == 0) {
+                firstBonus = bonus;
+            } else {
+                // Keep bonus of the first character for the whole chunk.
+                if (bonus == bonusBoundary)
+                    firstBonus = bonus;
+                bonus = qMax( bonus, qMax(firstBonus, bonusConsecutive) );
+            }
+
+            score += scoreMatch + (q == 0 ? bonus * bonusFirstCharMultiplier : bonus);
+            if ( !caseSensitive && text[i] == m_query[q] )
+                score += bonusCase;
+
+            ++consecutive;
+            inGap = false;
+            ++q;
+        } else {
+            score += inGap ? scoreGapExtension : scoreGapStart;
+            consecutive = 0;
+            firstBonus = 0;
+            inGap = true;
+        }
+    }
+
+    return qMax(0, score);
+}
+
+int FuzzyMatcher::score(const QStringList &texts) const
+{
+    int bestScore = -1;
+    for (const auto &text : texts)
+        bestScore = qMax( bestScore, score(text) );
+    return bestScore;
+}
+
+int FuzzyMatcher::matchEnd(const QString &text) const
+{
+    const int queryLength = m_foldedQuery.size();
+    if (queryLength == 0)
+        return 0;
+
+    // Find first occurrence of all characters.
+    int q = 0;
+    for (int i = 0; i < text.size(); ++i) {
+        if ( matchesAt(text, i, q) && ++q == queryLength )
+            return i;
+    }
+
+    return -1;
+}
+
+bool FuzzyMatcher::matchesAt(const QString &text, int i, int q) const
+{
+    const QChar c = text[i];
+    return (m_cs == Qt::CaseSensitive ? c : c.toLower()) == m_foldedQuery[q];
+}
+
+QRegExp FuzzyMatcher::regExp() const
+{
+    QString pattern;
+    for (const auto &c : m_query) {
+        if ( !pattern.isEmpty() )
+            pattern.append(".*");
+        pattern.append( QRegExp::escape(QString(c)) );
+    }
+
+    return QRegExp(pattern, m_cs, QRegExp::RegExp2);
+}
@@ -0,0 +1,75 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FUZZYMATCHER_H
+#define FUZZYMATCHER_H
+
+#include <QRegExp>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Matches texts containing all characters of query in the same order.
+ *
+ * Matching texts are scored similarly to fzf: matched characters at word
+ * starts, consecutive matched characters and matching case increase score,
+ * gaps between matched characters decrease it.
+ *
+ * Whitespace in query is ignored.
+ */
+class FuzzyMatcher
+{
+public:
+    FuzzyMatcher(const QString &query, Qt::CaseSensitivity cs);
+
+    /** Create matcher for filter returned by regExp() (query is empty for other expressions). */
+    static FuzzyMatcher fromRegExp(const QRegExp &re);
+
+    bool isEmpty() const { return m_query.isEmpty(); }
+
+    /** Return true if @a text contains all characters of query in order (single pass over text). */
+    bool matches(const QString &text) const { return matchEnd(text) != -1; }
+
+    /** Return true if any of @a texts matches. */
+    bool matchesAny(const QStringList &texts) const;
+
+    /**
+     * Return score of @a text (higher is better).
+     * @return -1 if text doesn't match
+     */
+    int score(const QString &text) const;
+
+    /** Return best score of @a texts (-1 if none matches). */
+    int score(const QStringList &texts) const;
+
+    /** Return regular expression matching the same texts as the matcher. */
+    QRegExp regExp() const;
+
+private:
+    /** Return index of character in @a text which completes the first match (-1 if none). */
+    int matchEnd(const QString &text) const;
+
+    bool matchesAt(const QString &text, int i, int q) const;
+
+    QString m_query;
+    QString m_foldedQuery;
+    Qt::CaseSensitivity m_cs;
+};
+
+#endif // FUZZYMATCHER_H
@@ -0,0 +1,89 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "textmatcher.h"
+
+namespace {
+
+bool isLiteralPattern(const QRegExp &re)
+{
+    if ( !re.isValid() )
+        return false;
+
+    switch ( re.patternSyntax() ) {
+    case QRegExp::FixedString:
+        return true;
+    case QRegExp::RegExp:
+    case QRegExp::RegExp2:
+        break;
+    default:
+        return false;
+    }
+
+    const QString specialCharacters("\\^$.|?*+()[]{}");
+    for ( const auto &c : re.pattern() ) {
+        if ( specialCharacters.contains(c) )
+            return false;
+    }
+
+    return true;
+}
+
+FuzzyMatcher fuzzyMatcher(const QRegExp &re, bool isLiteral)
+{
+    // Only regular expressions created by FuzzyMatcher::regExp() are converted.
+    const bool isRegExp = re.isValid()
+            && (re.patternSyntax() == QRegExp::RegExp || re.patternSyntax() == QRegExp::RegExp2);
+    return FuzzyMatcher::fromRegExp( isRegExp && !isLiteral ? re : QRegExp() );
+}
+
+} // namespace
+
+TextMatcher::TextMatcher(const QRegExp &re)
+    : m_re(re)
+    , m_literal()
+    , m_isLiteral( isLiteralPattern(re) )
+    , m_fuzzy( fuzzyMatcher(re, m_isLiteral) )
+{
+    if (m_isLiteral) {
+        m_literal.setPattern( re.pattern() );
+        m_literal.setCaseSensitivity( re.caseSensitivity() );
+    }
+}
+
+bool TextMatcher::matches(const QString &text) const
+{
+    if (m_isLiteral)
+        return m_literal.pattern().isEmpty() || m_literal.indexIn(text) != -1;
+
+    if ( isFuzzy() )
+        return m_fuzzy.matches(text);
+
+    return m_re.indexIn(text) != -1;
+}
+
+bool TextMatcher::matchesAny(const QStringList &texts) const
+{
+    for (const auto &text : texts) {
+        if ( matches(text) )
+            return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,67 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TEXTMATCHER_H
+#define TEXTMATCHER_H
+
+#include "common/fuzzymatcher.h"
+
+#include <QRegExp>
+#include <QStringList>
+#include <QStringMatcher>
+
+/**
+ * Matches texts with filter expression.
+ *
+ * Matcher is prepared once for a filter and used for all items and texts
+ * from all plugins. Expressions without special characters are searched
+ * as plain text (using Boyer-Moore algorithm) instead of running regular
+ * expression engine on each text. Expressions created by FuzzyMatcher::regExp()
+ * are matched with FuzzyMatcher in single pass over the text.
+ *
+ * Copies of the matcher should be created in the thread which uses them
+ * (QRegExp is not safe to copy in multiple threads).
+ */
+class TextMatcher
+{
+public:
+    explicit TextMatcher(const QRegExp &re = QRegExp());
+
+    const QRegExp &regExp() const { return m_re; }
+
+    /** Return true if text is searched without regular expression engine. */
+    bool isLiteral() const { return m_isLiteral; }
+
+    /** Return true if text is matched with FuzzyMatcher. */
+    bool isFuzzy() const { return !m_fuzzy.isEmpty(); }
+
+    /** Return true if @a text contains a match. */
+    bool matches(const QString &text) const;
+
+    /** Return true if any of @a texts contains a match. */
+    bool matchesAny(const QStringList &texts) const;
+
+private:
+    QRegExp m_re;
+    QStringMatcher m_literal;
+    bool m_isLiteral;
+    FuzzyMatcher m_fuzzy;
+};
+
+#endif // TEXTMATCHER_H
@@ -177,8 +177,13 @@ void ActionHandler::actionDialogClosed(ActionDialog *dialog)
 void ActionHandler::addItems(const QStringList &items, const QString &format, const QString &tabName)
 {
     ClipboardBrowser *c = tabName.isEmpty() ? m_wnd->browser() : m_wnd->tab(tabName);
-    for (const auto &item : items)
-        c->add( createDataMap(format, item) );
+
+    // Last item is at the top.
+    QVector<QVariantMap> dataList;
+    dataList.reserve( items.size() );
+    for (int i = items.size() - 1; i >= 0; --i)
+        dataList.append( createDataMap(format, items[i]) );
+    c->add(dataList);
 
     if (m_lastAction) {
         if (m_lastAction == sender())
@@ -23,6 +23,7 @@
 #include "common/action.h"
 #include "common/common.h"
 #include "common/contenttype.h"
+#include "common/fuzzymatcher.h"
 #include "common/log.h"
 #include "common/mimetypes.h"
 #include "gui/clipboarddialog.h"
@@ -36,6 +37,7 @@
 #include "item/itemwidget.h"
 
 #include <QApplication>
+#include <QBitArray>
 #include <QDrag>
 #include <QKeyEvent>
 #include <QMimeData>
@@ -122,6 +124,12 @@ bool reverseSort(const QModelIndex &lhs, const QModelIndex &rhs)
     return lhs.row() > rhs.row();
 }
 
+/// Minimum number of items to filter for matching items in background.
+const int minRowCountToFilterInBackground = 2000;
+
+/// Number of items filtered immediately before the rest is filtered in background.
+const int rowCountToFilterImmediately = 200;
+
 QModelIndex indexNear(const QListView *view, int offset)
 {
     const int s = view->spacing();
@@ -167,6 +175,10 @@ ClipboardBrowserShared::ClipboardBrowserShared(ItemFactory *itemFactory)
     , moveItemOnReturnKey(false)
     , showSimpleItems(false)
     , minutesToExpire(0)
+    , mapItemData(false)
+    , tabMemoryLimit(0)
+    , totalMemoryLimit(0)
+    , archiveItems(false)
     , itemFactory(itemFactory)
 {
 }
@@ -182,6 +194,10 @@ void ClipboardBrowserShared::loadFromConfiguration()
     moveItemOnReturnKey = appConfig.option<Config::move>();
     showSimpleItems = appConfig.option<Config::show_simple_items>();
     minutesToExpire = appConfig.option<Config::expire_tab>();
+    mapItemData = appConfig.option<Config::map_item_data>();
+    tabMemoryLimit = appConfig.option<Config::tab_memory_limit>();
+    totalMemoryLimit = appConfig.option<Config::total_memory_limit>();
+    archiveItems = appConfig.option<Config::archive_items>();
 }
 
 ClipboardBrowser::ClipboardBrowser(const ClipboardBrowserSharedPtr &sharedData, QWidget *parent)
@@ -190,10 +206,19 @@ ClipboardBrowser::ClipboardBrowser(const ClipboardBrowserSharedPtr &sharedData,
     , m_tabName()
     , m(this)
     , d(this, sharedData->itemFactory)
+    , m_saveQueue()
     , m_invalidateCache(false)
     , m_expireAfterEditing(false)
     , m_editor(nullptr)
     , m_sharedData(sharedData)
+    , m_searchIndex(&m, [](const QModelIndex &index) {
+          return index.data(contentType::searchableTexts).toStringList().join("\n");
+      })
+    , m_filterRows()
+    , m_filterRowOffset(0)
+    , m_fuzzyFilter(false)
+    , m_bestFuzzyMatch()
+    , m_bestFuzzyScore(-1)
     , m_loadButton(nullptr)
     , m_dragTargetRow(-1)
     , m_dragStartPosition()
@@ -215,6 +240,16 @@ ClipboardBrowser::ClipboardBrowser(const ClipboardBrowserSharedPtr &sharedData,
     initSingleShotTimer( &m_timerExpire, 0, this, SLOT(expire()) );
     initSingleShotTimer( &m_timerEmitItemCount, 0, this, SLOT(emitItemCount()) );
 
+    connect( &m_saveQueue, SIGNAL(saved(bool)),
+             this, SLOT(onItemsSaved(bool)) );
+
+    connect( &m_filterRunner, SIGNAL(filtered(int,QBitArray)),
+             this, SLOT(onItemsFiltered(int,QBitArray)) );
+    connect( &m_filterRunner, SIGNAL(finished()),
+             this, SLOT(onItemFilteringFinished()) );
+    connect( &m_filterRunner, SIGNAL(bestMatchFound(int,int)),
+             this, SLOT(onBestFuzzyMatchFound(int,int)) );
+
     // ScrollPerItem doesn't work well with hidden items
     setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
 
@@ -222,6 +257,11 @@ ClipboardBrowser::ClipboardBrowser(const ClipboardBrowserSharedPtr &sharedData,
 
     setAcceptDrops(true);
 
+    m.setSearchableTextsFunction([this](const QModelIndex &index) {
+        return m_sharedData->itemFactory
+                ? m_sharedData->itemFactory->searchableTexts(index) : QStringList();
+    });
+
     connectModelAndDelegate();
 }
 
@@ -230,6 +270,7 @@ ClipboardBrowser::~ClipboardBrowser()
     d.invalidateCache();
     if ( m_timerSave.isActive() )
         saveItems();
+    m_saveQueue.waitForSaved();
 }
 
 
@@ -252,17 +293,21 @@ bool ClipboardBrowser::isFiltered(int row) const
         return false;
 
     const QModelIndex ind = m.index(row);
-    return m_sharedData->itemFactory && !m_sharedData->itemFactory->matches( ind, d.searchExpression() );
+    return m_sharedData->itemFactory && !m_sharedData->itemFactory->matches(ind, m_filterMatcher);
 }
 
-bool ClipboardBrowser::hideFiltered(int row)
+bool ClipboardBrowser::hideRow(int row, bool hide)
 {
-    const bool hide = isFiltered(row);
     setRowHidden(row, hide);
     d.setRowVisible(row, !hide);
     return hide;
 }
 
+bool ClipboardBrowser::hideFiltered(int row)
+{
+    return hideRow( row, isFiltered(row) );
+}
+
 bool ClipboardBrowser::hideFiltered(const QModelIndex &index)
 {
     return hideFiltered(index.row());
@@ -429,6 +474,8 @@ void ClipboardBrowser::connectModelAndDelegate()
              SLOT(onTabNameChanged(QString)) );
     connect( &m, SIGNAL(unloaded()),
              SLOT(onModelUnloaded()) );
+    connect( &m, SIGNAL(memoryUsageChanged(qint64,qint64)),
+             SLOT(onMemoryUsageChanged(qint64,qint64)) );
 
     // update on change
     connect( &m, SIGNAL(rowsInserted(QModelIndex, int, int)),
@@ -444,6 +491,17 @@ void ClipboardBrowser::connectModelAndDelegate()
     connect( &m, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
              SLOT(onModelDataChanged()) );
 
+    connect( &m, SIGNAL(rowsInserted(QModelIndex, int, int)),
+             SLOT(onRowsInsertedWhileFiltering(QModelIndex,int,int)) );
+    connect( &m, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+             SLOT(onRowsRemovedWhileFiltering(QModelIndex,int,int)) );
+    connect( &m, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+             SLOT(restartFiltering()) );
+    connect( &m, SIGNAL(modelReset()),
+             SLOT(restartFiltering()) );
+    connect( &m, SIGNAL(layoutChanged()),
+             SLOT(restartFiltering()) );
+
     connect( &m, SIGNAL(rowsInserted(QModelIndex, int, int)),
              &d, SLOT(rowsInserted(QModelIndex, int, int)) );
     connect( &m, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
@@ -491,8 +549,7 @@ int ClipboardBrowser::dropIndexes(const QModelIndexList &indexes)
 
     std::sort( rows.begin(), rows.end(), std::greater<int>() );
 
-    for (int row : rows)
-        m.removeRow(row);
+    m.removeItems(rows);
 
     delayedSaveItems();
 
@@ -628,7 +685,7 @@ int ClipboardBrowser::removeIndexes(const QModelIndexList &indexes, QString *err
 
 void ClipboardBrowser::paste(const QVariantMap &data, int destinationRow)
 {
-    int count = 0;
+    QVector<QVariantMap> dataList;
 
     // Insert items from clipboard or just clipboard content.
     if ( data.contains(mimeItems) ) {
@@ -638,14 +695,14 @@ void ClipboardBrowser::paste(const QVariantMap &data, int destinationRow)
         while ( !stream.atEnd() ) {
             QVariantMap dataMap;
             stream >> dataMap;
-            add(dataMap, destinationRow + count);
-            ++count;
+            dataList.append(dataMap);
         }
     } else {
-        add(data, destinationRow);
-        count = 1;
+        dataList.append(data);
     }
 
+    const int count = add(dataList, destinationRow) ? dataList.size() : 0;
+
     // Select new items.
     if (count > 0) {
         QItemSelection sel;
@@ -718,6 +775,15 @@ void ClipboardBrowser::onItemCountChanged()
         m_timerEmitItemCount.start();
 }
 
+void ClipboardBrowser::onMemoryUsageChanged(qint64 residentBytes, qint64 storedBytes)
+{
+    const double mib = 1024.0 * 1024.0;
+    const QString toolTip = tr("Item data in memory: %1 MiB\nItem data in files: %2 MiB")
+            .arg(residentBytes / mib, 0, 'f', 1)
+            .arg(storedBytes / mib, 0, 'f', 1);
+    emit tabToolTipChanged(tabName(), toolTip);
+}
+
 void ClipboardBrowser::onTabNameChanged(const QString &tabName)
 {
     if ( m_tabName.isEmpty() ) {
@@ -725,13 +791,11 @@ void ClipboardBrowser::onTabNameChanged(const QString &tabName)
         return;
     }
 
-    // Just move last saved file if tab is not loaded yet.
-    if ( isLoaded() ) {
-        m_timerSave.stop();
-        removeItems(m_tabName);
-    } else {
-        moveItems(m_tabName, tabName);
-    }
+    // Move last saved file even if tab is loaded since items can still
+    // reference data in the file. Unsaved changes are saved later to the new file.
+    m_saveQueue.waitForSaved();
+    moveItems(m_tabName, tabName);
+    m_archive.reset();
 
     m_tabName = tabName;
 }
@@ -745,6 +809,8 @@ void ClipboardBrowser::expire(bool force)
 
         if ( force || !isVisible() ) {
             saveUnsavedItems();
+            m_saveQueue.waitForSaved();
+            saveSearchIndex();
             m.unloadItems();
         }
     }
@@ -780,6 +846,13 @@ void ClipboardBrowser::onModelUnloaded()
     m_itemSaver = nullptr;
 }
 
+void ClipboardBrowser::onItemsSaved(bool ok)
+{
+    // Try again later.
+    if (!ok)
+        delayedSaveItems();
+}
+
 void ClipboardBrowser::onEditorNeedsChangeClipboard()
 {
     QModelIndex index = m_editor->index();
@@ -1100,9 +1173,12 @@ bool ClipboardBrowser::openEditor(const QModelIndex &index)
 
 void ClipboardBrowser::addItems(const QStringList &items)
 {
-    for(int i=items.count()-1; i>=0; --i) {
-        add(items[i]);
-    }
+    QVector<QVariantMap> dataList;
+    dataList.reserve( items.size() );
+    for (int i = items.size() - 1; i >= 0; --i)
+        dataList.append( createDataMap(mimeText, items[i]) );
+
+    add(dataList);
 }
 
 void ClipboardBrowser::showItemContent()
@@ -1142,24 +1218,180 @@ void ClipboardBrowser::itemModified(const QByteArray &bytes, const QString &mime
     }
 }
 
-void ClipboardBrowser::filterItems(const QRegExp &re)
+void ClipboardBrowser::filterItems(const QRegExp &re, bool fuzzy)
 {
     // Do nothing if same regexp was already set or both are empty (don't compare regexp options).
-    if ( (d.searchExpression().isEmpty() && re.isEmpty()) || d.searchExpression() == re )
+    if ( fuzzy == m_fuzzyFilter
+         && ((d.searchExpression().isEmpty() && re.isEmpty()) || d.searchExpression() == re) )
+    {
         return;
+    }
 
     if ( editing() )
         m_editor->search(re);
 
     d.setSearch(re);
+    m_filterMatcher = TextMatcher(re);
+    m_fuzzyFilter = fuzzy;
+
+    refilterItems();
+}
+
+void ClipboardBrowser::refilterItems()
+{
+    const QRegExp re = d.searchExpression();
+
+    m_filterRunner.cancel();
+    m_filterRows.clear();
+    m_filterRowOffset = 0;
+    m_bestFuzzyMatch = QPersistentModelIndex();
+    m_bestFuzzyScore = -1;
+
+    // Skip items which cannot match using the search index
+    // (index is not used if formats are matched for expression with single '/')
+    // and items filtered out by previous expression if the new one only narrows it.
+    const bool matchFormats = re.pattern().count('/') == 1;
+    QBitArray candidates;
+    bool hasCandidates = m_itemSaver && !re.isEmpty() && !matchFormats
+            && m_searchIndex.findCandidateRows(re, &candidates);
+
+    QBitArray previousMatches;
+    if ( m_filterMatches.findCandidateRows(&m, re, &previousMatches) ) {
+        if (hasCandidates)
+            candidates &= previousMatches;
+        else
+            candidates = previousMatches;
+        hasCandidates = true;
+    }
+
+    // Filter first items immediately and the rest in background if there are many.
+    const int rowCountToTest = hasCandidates ? candidates.count(true) : length();
+    const bool filterInBackground = m_itemSaver && m_sharedData->itemFactory
+            && !re.isEmpty() && !matchFormats
+            && rowCountToTest > minRowCountToFilterInBackground;
+    int testedRowCount = 0;
+
+    // Score fuzzy matches while filtering so the best one can be selected without another pass.
+    const FuzzyMatcher fuzzyMatcher = FuzzyMatcher::fromRegExp( m_fuzzyFilter ? re : QRegExp() );
+
+    QBitArray matches(length());
+    const auto hideFilteredRow = [&](int row) {
+        if ( hasCandidates && !candidates.testBit(row) )
+            return hideRow(row, true);
+
+        // Hide item until it's filtered in background.
+        if ( filterInBackground && ++testedRowCount > rowCountToFilterImmediately ) {
+            m_filterRows.append(row);
+            return hideRow(row, true);
+        }
+
+        const bool hide = hideFiltered(row);
+        if (!hide) {
+            matches.setBit(row);
+            if ( !fuzzyMatcher.isEmpty() ) {
+                const QModelIndex ind = index(row);
+                const int score = fuzzyMatcher.score( ind.data(contentType::searchableTexts).toStringList() );
+                if (score > m_bestFuzzyScore) {
+                    m_bestFuzzyScore = score;
+                    m_bestFuzzyMatch = ind;
+                }
+            }
+        }
+        return hide;
+    };
 
     int row = 0;
-    for ( ; row < length() && hideFiltered(row); ++row ) {}
+    for ( ; row < length() && hideFilteredRow(row); ++row ) {}
 
     setCurrentIndex(index(row));
 
     for ( ; row < length(); ++row )
-        hideFiltered(row);
+        hideFilteredRow(row);
+
+    if ( !m_filterRows.isEmpty() ) {
+        m_filterMatches.clear();
+        m_filterRunner.start( re, m.searchableTexts(m_filterRows), m_fuzzyFilter );
+        return;
+    }
+
+    if ( re.isEmpty() || !m_itemSaver ) {
+        m_filterMatches.clear();
+    } else {
+        m_filterMatches.setMatches(&m, re, matches);
+        if (m_fuzzyFilter)
+            selectBestFuzzyMatch();
+    }
+}
+
+void ClipboardBrowser::onItemsFiltered(int first, const QBitArray &matches)
+{
+    for (int i = 0; i < matches.size(); ++i) {
+        const int row = m_filterRows[first + i] + m_filterRowOffset;
+        const bool hide = hideRow( row, !matches.testBit(i) );
+
+        // Select first matching item if no item was matched immediately.
+        const QModelIndex current = currentIndex();
+        if ( !hide && (!current.isValid() || isRowHidden(current.row())) )
+            setCurrentIndex( index(row) );
+    }
+}
+
+void ClipboardBrowser::onItemFilteringFinished()
+{
+    m_filterRows.clear();
+
+    QBitArray matches(length());
+    for (int row = 0; row < length(); ++row) {
+        if ( !isRowHidden(row) )
+            matches.setBit(row);
+    }
+
+    m_filterMatches.setMatches( &m, d.searchExpression(), matches );
+
+    if (m_fuzzyFilter)
+        selectBestFuzzyMatch();
+}
+
+void ClipboardBrowser::onBestFuzzyMatchFound(int item, int score)
+{
+    if ( item < m_filterRows.size() && score > m_bestFuzzyScore ) {
+        m_bestFuzzyScore = score;
+        m_bestFuzzyMatch = index(m_filterRows[item] + m_filterRowOffset);
+    }
+}
+
+void ClipboardBrowser::onRowsInsertedWhileFiltering(const QModelIndex &, int first, int last)
+{
+    if ( m_filterRows.isEmpty() )
+        return;
+
+    // Rows filtered in background are tracked by offset if new items are added above them.
+    if ( first <= m_filterRows.first() + m_filterRowOffset )
+        m_filterRowOffset += last - first + 1;
+    else
+        restartFiltering();
+}
+
+void ClipboardBrowser::onRowsRemovedWhileFiltering(const QModelIndex &, int first, int last)
+{
+    if ( m_filterRows.isEmpty() )
+        return;
+
+    if ( last < m_filterRows.first() + m_filterRowOffset )
+        m_filterRowOffset -= last - first + 1;
+    else
+        restartFiltering();
+}
+
+void ClipboardBrowser::restartFiltering()
+{
+    if ( m_filterRows.isEmpty() )
+        return;
+
+    // Filter again later when the model change is fully processed (search index is updated).
+    m_filterRunner.cancel();
+    m_filterRows.clear();
+    QMetaObject::invokeMethod(this, "refilterItems", Qt::QueuedConnection);
 }
 
 void ClipboardBrowser::moveToClipboard(const QModelIndex &ind)
@@ -1259,7 +1491,7 @@ void ClipboardBrowser::remove()
         setCurrent(currentRow);
 }
 
-bool ClipboardBrowser::select(uint itemHash, SelectActions selectActions)
+bool ClipboardBrowser::select(quint64 itemHash, SelectActions selectActions)
 {
     int row = m.findItem(itemHash);
     if (row < 0)
@@ -1291,7 +1523,12 @@ void ClipboardBrowser::reverseItems(const QModelIndexList &indexes)
 
 bool ClipboardBrowser::allocateSpaceForNewItems(int newItemCount)
 {
-    const auto targetRowCount = m_sharedData->maxItems - newItemCount;
+    const auto maxItems = m_sharedData->maxItems;
+    if (maxItems <= 0)
+        return newItemCount <= 0;
+
+    // Only first items from bigger batch are added (see add()).
+    const auto targetRowCount = maxItems - qMin(newItemCount, maxItems);
     const auto toRemove = m.rowCount() - targetRowCount;
     if (toRemove <= 0)
         return true;
@@ -1307,16 +1544,134 @@ bool ClipboardBrowser::allocateSpaceForNewItems(int newItemCount)
     if (indexesToRemove.size() < toRemove)
         return false;
 
+    // Items are removed even if archiving fails as if archive is disabled.
+    // Archive is plain so items from encrypted tabs or tabs stored by other
+    // plugins are never archived.
+    if ( m_sharedData->archiveItems && !tabName().isEmpty() && m_itemSaver->storesPlainData() ) {
+        // Oldest item is archived first.
+        QVector<QVariantMap> items;
+        items.reserve( indexesToRemove.size() );
+        for (const auto &index : indexesToRemove)
+            items.append( m.readItemData(index.row()) );
+        archive()->append(items);
+    }
+
     dropIndexes(indexesToRemove);
     return true;
 }
 
+int ClipboardBrowser::archivedItemCount()
+{
+    return tabName().isEmpty() ? 0 : archive()->count();
+}
+
+QVector<QVariantMap> ClipboardBrowser::archivedItems(int index, int count)
+{
+    QVector<QVariantMap> items;
+    if ( !tabName().isEmpty() )
+        archive()->read(index, count, &items);
+    return items;
+}
+
+QList<int> ClipboardBrowser::findArchivedItems(const QRegExp &re, int maxCount)
+{
+    QList<int> found;
+    if ( tabName().isEmpty() || !m_sharedData->itemFactory )
+        return found;
+
+    // Plugins match items in model so archived items are loaded to temporary model in batches.
+    const int batchSize = 64;
+    const TextMatcher matcher(re);
+    ClipboardModel batch;
+    const int count = archive()->count();
+
+    for (int index = 0; index < count && (maxCount < 0 || found.size() < maxCount); index += batchSize) {
+        QVector<QVariantMap> items;
+        if ( !archive()->read(index, batchSize, &items) )
+            break;
+
+        batch.removeRows( 0, batch.rowCount() );
+        batch.insertItems(items, 0);
+
+        for (int row = 0; row < batch.rowCount() && (maxCount < 0 || found.size() < maxCount); ++row) {
+            if ( m_sharedData->itemFactory->matches(batch.index(row), matcher) )
+                found.append(index + row);
+        }
+    }
+
+    return found;
+}
+
+QList<int> ClipboardBrowser::findFuzzy(const FuzzyMatcher &matcher, int maxCount) const
+{
+    QList<int> rows;
+    if ( !m_sharedData->itemFactory || matcher.isEmpty() )
+        return rows;
+
+    // Sort by score (descending) and row.
+    QVector< QPair<int, int> > scoreRows;
+    for (int row = 0; row < m.rowCount(); ++row) {
+        const int score = matcher.score( m.index(row).data(contentType::searchableTexts).toStringList() );
+        if (score >= 0)
+            scoreRows.append( qMakePair(-score, row) );
+    }
+
+    std::sort( scoreRows.begin(), scoreRows.end() );
+
+    for (const auto &scoreRow : scoreRows) {
+        if (maxCount >= 0 && rows.size() >= maxCount)
+            break;
+        rows.append(scoreRow.second);
+    }
+
+    return rows;
+}
+
+bool ClipboardBrowser::restoreArchivedItems(const QList<int> &indexes)
+{
+    if ( tabName().isEmpty() )
+        return false;
+
+    QList<int> sortedIndexes = indexes;
+    std::sort( sortedIndexes.begin(), sortedIndexes.end() );
+    sortedIndexes.erase( std::unique(sortedIndexes.begin(), sortedIndexes.end()), sortedIndexes.end() );
+
+    // Restored items would be dropped if they don't fit into the tab.
+    if ( sortedIndexes.size() > m_sharedData->maxItems )
+        return false;
+
+    QVector<QVariantMap> items;
+    for (int index : sortedIndexes) {
+        if ( !archive()->read(index, 1, &items) )
+            return false;
+    }
+
+    // Remove items from archive first since adding can archive other items.
+    if ( !archive()->remove(sortedIndexes) )
+        return false;
+
+    if ( !add(items, 0) ) {
+        QVector<QVariantMap> itemsToArchive;
+        for (int i = items.size() - 1; i >= 0; --i)
+            itemsToArchive.append(items[i]);
+        archive()->append(itemsToArchive);
+        return false;
+    }
+
+    return true;
+}
+
 bool ClipboardBrowser::add(const QString &txt, int row)
 {
     return add( createDataMap(mimeText, txt), row );
 }
 
 bool ClipboardBrowser::add(const QVariantMap &data, int row)
+{
+    return add(QVector<QVariantMap>() << data, row);
+}
+
+bool ClipboardBrowser::add(const QVector<QVariantMap> &items, int row)
 {
     if ( m.isDisabled() )
         return false;
@@ -1326,24 +1681,37 @@ bool ClipboardBrowser::add(const QVariantMap &data, int row)
             return false;
     }
 
+    if ( items.isEmpty() )
+        return true;
+
+    // Only first (newest) items are added if there are more than the tab can hold.
+    const auto maxItems = m_sharedData->maxItems;
+    if ( maxItems > 0 && items.size() > maxItems )
+        return add( items.mid(0, maxItems), row );
+
     // list size limit
-    if ( !allocateSpaceForNewItems(1) ) {
+    if ( !allocateSpaceForNewItems(items.size()) ) {
         QMessageBox::information(
                     this, tr("Cannot Add New Items"),
                     tr("Tab is full. Failed to remove any items.") );
         return false;
     }
 
-    // create new item
-    int newRow = row < 0 ? m.rowCount() : qMin(row, m.rowCount());
-    m.insertItem(data, newRow);
+    // create new items
+    const int newRow = row < 0 ? m.rowCount() : qMin(row, m.rowCount());
+    m.insertItems(items, newRow);
 
-    // filter item
-    if ( !hideFiltered(newRow) ) {
-        // Select new item if clipboard is not focused and the item is not filtered-out.
-        selectionModel()->setCurrentIndex(index(newRow), QItemSelectionModel::ClearAndSelect);
+    // filter items
+    int firstVisibleRow = -1;
+    for (int i = newRow; i < newRow + items.size(); ++i) {
+        if ( !hideFiltered(i) && firstVisibleRow == -1 )
+            firstVisibleRow = i;
     }
 
+    // Select new item if clipboard is not focused and the item is not filtered-out.
+    if (firstVisibleRow != -1)
+        selectionModel()->setCurrentIndex(index(firstVisibleRow), QItemSelectionModel::ClearAndSelect);
+
     delayedSaveItems();
 
     return true;
@@ -1420,6 +1788,14 @@ void ClipboardBrowser::loadSettings()
 
     // restore configuration
     m.setMaxItems(m_sharedData->maxItems);
+    m.setMapItemData(m_sharedData->mapItemData);
+    m.setMemoryLimit( static_cast<qint64>(m_sharedData->tabMemoryLimit) * 1024 * 1024 );
+    ClipboardModel::setTotalMemoryLimit( static_cast<qint64>(m_sharedData->totalMemoryLimit) * 1024 * 1024 );
+
+    // Enabled plugins may have changed.
+    m.invalidateSearchableTexts();
+    m_searchIndex.invalidate();
+    m_filterMatches.clear();
 
     updateItemMaximumSize();
 
@@ -1468,7 +1844,6 @@ void ClipboardBrowser::loadItemsAgain()
     if ( !m.isDisabled() ) {
         delete m_loadButton;
         m_loadButton = nullptr;
-        d.rowsInserted(QModelIndex(), 0, m.rowCount());
         setCurrent(0);
         onItemCountChanged();
         emit updateContextMenu(this);
@@ -1491,7 +1866,7 @@ bool ClipboardBrowser::saveItems()
     if ( !isLoaded() || tabName().isEmpty() )
         return false;
 
-    return ::saveItems(m, m_itemSaver);
+    return m_saveQueue.save(&m, m_itemSaver);
 }
 
 void ClipboardBrowser::moveToClipboard()
@@ -1513,13 +1888,64 @@ void ClipboardBrowser::saveUnsavedItems()
         saveItems();
 }
 
+QVector<QStringList> ClipboardBrowser::searchableTexts()
+{
+    QVector<QStringList> texts;
+    if ( !isLoaded() && loadItemSearchIndex(tabName(), &texts) )
+        return texts;
+
+    loadItems();
+    if ( !isLoaded() )
+        return texts;
+
+    texts.reserve( length() );
+    for (int row = 0; row < length(); ++row)
+        texts.append( index(row).data(contentType::searchableTexts).toStringList() );
+
+    return texts;
+}
+
+void ClipboardBrowser::saveSearchIndex()
+{
+    // Never load items only to create the index and don't store plain texts
+    // of items for tabs which are encrypted or stored elsewhere.
+    if ( tabName().isEmpty() || !isLoaded() || !m_itemSaver
+         || !m_itemSaver->storesPlainData() || hasItemSearchIndex(tabName()) )
+    {
+        return;
+    }
+
+    QVector<QStringList> texts;
+    texts.reserve( length() );
+    for (int row = 0; row < length(); ++row)
+        texts.append( index(row).data(contentType::searchableTexts).toStringList() );
+
+    saveItemSearchIndex(tabName(), texts);
+}
+
+void ClipboardBrowser::selectBestFuzzyMatch()
+{
+    // Items keep their order in the list, only the best match is selected.
+    if ( m_bestFuzzyMatch.isValid() && !isRowHidden(m_bestFuzzyMatch.row()) )
+        setCurrentIndex(m_bestFuzzyMatch);
+}
+
+ItemArchive *ClipboardBrowser::archive()
+{
+    if (!m_archive)
+        m_archive = createItemArchive( tabName() );
+    return m_archive.get();
+}
+
 void ClipboardBrowser::purgeItems()
 {
     if ( tabName().isEmpty() )
         return;
 
-    removeItems(tabName());
     m_timerSave.stop();
+    m_saveQueue.waitForSaved();
+    removeItems(tabName());
+    m_archive.reset();
 }
 
 const QString ClipboardBrowser::selectedText() const
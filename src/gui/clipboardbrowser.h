@@ -21,18 +21,27 @@
 #define CLIPBOARDBROWSER_H
 
 #include "common/command.h"
+#include "common/textmatcher.h"
 #include "gui/configtabshortcuts.h"
 #include "item/clipboardmodel.h"
+#include "item/itemarchive.h"
 #include "item/itemdelegate.h"
+#include "item/itemfiltermatches.h"
+#include "item/itemfilterrunner.h"
+#include "item/itemsavequeue.h"
+#include "item/itemsearchindex.h"
 #include "item/itemwidget.h"
 
 #include <QListView>
+#include <QPersistentModelIndex>
 #include <QPointer>
 #include <QTimer>
 #include <QVariantMap>
+#include <QVector>
 
 #include <memory>
 
+class FuzzyMatcher;
 class ItemEditorWidget;
 class ItemFactory;
 class QProgressBar;
@@ -60,6 +69,10 @@ struct ClipboardBrowserShared {
     bool moveItemOnReturnKey;
     bool showSimpleItems;
     int minutesToExpire;
+    bool mapItemData;
+    int tabMemoryLimit;
+    int totalMemoryLimit;
+    bool archiveItems;
 
     ItemFactory *itemFactory;
 };
@@ -85,7 +98,7 @@ class ClipboardBrowser : public QListView
          *
          * @return true only if item exists
          */
-        bool select(uint itemHash, SelectActions selectActions);
+        bool select(quint64 itemHash, SelectActions selectActions);
 
         /** Sort selected items. */
         void sortItems(const QModelIndexList &indexes);
@@ -146,9 +159,43 @@ class ClipboardBrowser : public QListView
         /** Render preview image with items. */
         QPixmap renderItemPreview(const QModelIndexList &indexes, int maxWidth, int maxHeight);
 
-        /** Removes items from end of list without notifying plugins. */
+        /**
+         * Removes items from end of list without notifying plugins.
+         *
+         * Removed items are archived if enabled in configuration.
+         *
+         * If @a newItemCount exceeds maximum number of items, space is
+         * allocated only for the maximum (see add()).
+         */
         bool allocateSpaceForNewItems(int newItemCount);
 
+        /** Number of items in archive (see ItemArchive). */
+        int archivedItemCount();
+
+        /** Return at most @a count archived items starting at @a index. */
+        QVector<QVariantMap> archivedItems(int index, int count);
+
+        /**
+         * Return indexes of archived items matching @a re.
+         *
+         * Items are loaded in small batches so the archive can be big.
+         */
+        QList<int> findArchivedItems(const QRegExp &re, int maxCount = -1);
+
+        /** Move archived items to the top of the list. */
+        bool restoreArchivedItems(const QList<int> &indexes);
+
+        /** Return rows of items matching @a matcher, best matches first. */
+        QList<int> findFuzzy(const FuzzyMatcher &matcher, int maxCount = -1) const;
+
+        /**
+         * Return texts to search in for all items (see ItemFactory::searchableTexts()).
+         *
+         * Texts of unloaded tab are read from search index saved with the tab
+         * so items are loaded only if the index is missing or outdated.
+         */
+        QVector<QStringList> searchableTexts();
+
         /** Add new item to the browser. */
         bool add(
                 const QString &txt, //!< Text of new item.
@@ -164,6 +211,19 @@ class ClipboardBrowser : public QListView
                 int row = 0 //!< Target row for the new item (negative to append item).
                 );
 
+        /**
+         * Add new items to the browser at once.
+         *
+         * Space for all items is allocated at once, model notifies views only
+         * once and items are saved once.
+         *
+         * First item in @a items will be at @a row (negative to append items).
+         *
+         * If there are more items than the tab can hold, only the first
+         * (newest) ones are added.
+         */
+        bool add(const QVector<QVariantMap> &items, int row = 0);
+
         /**
          * Add item and remove duplicates.
          */
@@ -176,13 +236,19 @@ class ClipboardBrowser : public QListView
         void keyEvent(QKeyEvent *event) { keyPressEvent(event); }
         /** Move item to clipboard. */
         void moveToClipboard(const QModelIndex &ind);
-        /** Show only items matching the regular expression. */
-        void filterItems(const QRegExp &re);
+        /**
+         * Show only items matching the regular expression.
+         *
+         * If @a fuzzy is true, @a re must be created by FuzzyMatcher::regExp()
+         * and the best matching item is selected. Matching items keep their
+         * order in the list, ranked results are available with findFuzzy().
+         */
+        void filterItems(const QRegExp &re, bool fuzzy = false);
         /** Open editor. */
         bool openEditor(const QByteArray &textData, bool changeClipboard = false);
         /** Open editor for an item. */
         bool openEditor(const QModelIndex &index);
-        /** Add items. */
+        /** Add items with text (last item will be at the top). */
         void addItems(const QStringList &items);
 
         /** Set current item. */
@@ -241,6 +307,9 @@ class ClipboardBrowser : public QListView
 
         /**
          * Save items to configuration.
+         *
+         * Bigger saves are finished in background.
+         *
          * @see setID, loadItems, purgeItems
          */
         bool saveItems();
@@ -285,6 +354,9 @@ class ClipboardBrowser : public QListView
 
         void itemCountChanged(const QString &tabName, int count);
 
+        /** Emitted with description of memory used by items. */
+        void tabToolTipChanged(const QString &tabName, const QString &toolTip);
+
         void showContextMenu(const QPoint &position);
 
         void updateContextMenu(const ClipboardBrowser *self);
@@ -320,6 +392,21 @@ class ClipboardBrowser : public QListView
 
         void onItemCountChanged();
 
+        void onMemoryUsageChanged(qint64 residentBytes, qint64 storedBytes);
+
+        /** Show or hide items filtered in background. */
+        void onItemsFiltered(int first, const QBitArray &matches);
+        void onItemFilteringFinished();
+        void onBestFuzzyMatchFound(int item, int score);
+
+        /** Update rows filtered in background after model changes or filter them again. */
+        void onRowsInsertedWhileFiltering(const QModelIndex &, int first, int last);
+        void onRowsRemovedWhileFiltering(const QModelIndex &, int first, int last);
+        void restartFiltering();
+
+        /** Filter all items again with current filter. */
+        void refilterItems();
+
         void onTabNameChanged(const QString &tabName);
 
         void expire(bool force = false);
@@ -332,6 +419,8 @@ class ClipboardBrowser : public QListView
 
         void onModelUnloaded();
 
+        void onItemsSaved(bool ok);
+
         void onEditorNeedsChangeClipboard();
 
         void onEditorNeedsChangeClipboard(const QByteArray &bytes, const QString &mime);
@@ -342,8 +431,17 @@ class ClipboardBrowser : public QListView
          */
         void delayedSaveItems();
 
+        /** Save search index before items are unloaded if tab file changed (see saveItemSearchIndex()). */
+        void saveSearchIndex();
+
         bool isFiltered(int row) const;
 
+        /**
+         * Hide or show row.
+         * @return @a hide
+         */
+        bool hideRow(int row, bool hide);
+
         /**
          * Hide row if filtered out, otherwise show.
          * @return true only if hidden
@@ -397,10 +495,16 @@ class ClipboardBrowser : public QListView
         void preload(int pixelsAboveCurrent, int pixelsBelowCurrent, const QModelIndex &current);
         void preload(int pixels, bool above, const QModelIndex &current);
 
+        ItemArchive *archive();
+
+        /** Select best fuzzy match found while filtering. */
+        void selectBestFuzzyMatch();
+
         ItemSaverPtr m_itemSaver;
         QString m_tabName;
         ClipboardModel m;
         ItemDelegate d;
+        ItemSaveQueue m_saveQueue;
         QTimer m_timerSave;
         QTimer m_timerScroll;
         QTimer m_timerExpire;
@@ -414,6 +518,23 @@ class ClipboardBrowser : public QListView
 
         ClipboardBrowserSharedPtr m_sharedData;
 
+        ItemArchivePtr m_archive;
+
+        ItemSearchIndex m_searchIndex;
+        ItemFilterMatches m_filterMatches;
+
+        ItemFilterRunner m_filterRunner;
+        /// Rows of items filtered in background (when filtering started).
+        QVector<int> m_filterRows;
+        /// Number of rows added (or removed) above items filtered in background.
+        int m_filterRowOffset;
+        /// Matcher for current filter (shared for all items).
+        TextMatcher m_filterMatcher;
+        bool m_fuzzyFilter;
+        /// Best scored item for fuzzy filter (scored while items are filtered).
+        QPersistentModelIndex m_bestFuzzyMatch;
+        int m_bestFuzzyScore;
+
         QPushButton *m_loadButton;
 
         int m_dragTargetRow;
@@ -158,7 +158,7 @@ private:
         addDocumentation("config", "String config(optionName)", "Returns value of given option.");
         addDocumentation("config", "String config(optionName, value)", "Sets option and returns new value.");
         addDocumentation("config", "String config(optionName, value, ...)", "Sets multiple options and return list with values in format `optionName=newValue`.");
-        addDocumentation("info", "String info([pathName])", "Returns paths and flags used by the application.");
+        addDocumentation("info", "String info([pathName])", "Returns paths and flags used by the application and size of item data in memory and in files.");
         addDocumentation("eval", "Value eval(script)", "Evaluates script and returns result.");
         addDocumentation("source", "Value source(fileName)", "Evaluates script file and returns result of last expression in the script.");
         addDocumentation("currentPath", "String currentPath([path])", "Get or set current path.");
@@ -181,6 +181,12 @@ private:
         addDocumentation("pack", "ByteArray pack(item)", "Returns serialized item.");
         addDocumentation("getItem", "Item getItem(row)", "Returns an item in current tab.");
         addDocumentation("setItem", "setItem(row, item)", "Inserts item to current tab.");
+        addDocumentation("fuzzyFind", "[row, ...] fuzzyFind(text)", "Returns rows of items containing characters of the text in the same order, best matches first.");
+        addDocumentation("searchTabs", "[{tab, row}, ...] searchTabs(regularExpression)", "Returns tab names and rows of items matching the expression in all tabs.");
+        addDocumentation("archiveSize", "int archiveSize()", "Returns number of items archived from current tab.");
+        addDocumentation("archiveItem", "Item archiveItem(index)", "Returns archived item (index 0 is the most recently archived item).");
+        addDocumentation("archiveFind", "[index, ...] archiveFind(regularExpression)", "Returns indexes of archived items matching the expression.");
+        addDocumentation("archiveRestore", "archiveRestore(index, ...)", "Moves archived items to the top of current tab.");
         addDocumentation("toBase64", "String toBase64(data)", "Returns base64-encoded data.");
         addDocumentation("fromBase64", "ByteArray fromBase64(base64String)", "Returns base64-decoded data.");
         addDocumentation("open", "QScriptValue open(url, ...)", "Tries to open URLs in appropriate applications.");
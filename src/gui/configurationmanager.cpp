@@ -245,6 +245,10 @@ void ConfigurationManager::initOptions()
 
     /* other options */
     bind<Config::command_history_size>();
+    bind<Config::map_item_data>();
+    bind<Config::tab_memory_limit>();
+    bind<Config::total_memory_limit>();
+    bind<Config::archive_items>();
 #ifdef HAS_MOUSE_SELECTIONS
     /* X11 clipboard selection monitoring and synchronization */
     bind<Config::check_selection>(ui->checkBoxSel);
@@ -31,6 +31,7 @@
 
 #include "common/appconfig.h"
 #include "common/config.h"
+#include "common/fuzzymatcher.h"
 #include "gui/iconfactory.h"
 #include "gui/icons.h"
 #include "gui/filtercompleter.h"
@@ -118,6 +119,9 @@ FilterLineEdit::FilterLineEdit(QWidget *parent)
 
     m_actionCaseInsensitive = menu->addAction(tr("Case Insensitive"));
     m_actionCaseInsensitive->setCheckable(true);
+
+    m_actionFuzzy = menu->addAction(tr("Fuzzy Match"));
+    m_actionFuzzy->setCheckable(true);
 }
 
 QRegExp FilterLineEdit::filter() const
@@ -125,6 +129,9 @@ QRegExp FilterLineEdit::filter() const
     Qt::CaseSensitivity sensitivity =
             m_actionCaseInsensitive->isChecked() ? Qt::CaseInsensitive : Qt::CaseSensitive;
 
+    if ( isFuzzy() )
+        return FuzzyMatcher(text(), sensitivity).regExp();
+
     QString pattern;
     if (m_actionRe->isChecked()) {
         pattern = text();
@@ -139,6 +146,11 @@ QRegExp FilterLineEdit::filter() const
     return QRegExp(pattern, sensitivity, QRegExp::RegExp2);
 }
 
+bool FilterLineEdit::isFuzzy() const
+{
+    return m_actionFuzzy->isChecked();
+}
+
 void FilterLineEdit::loadSettings()
 {
     AppConfig appConfig;
@@ -149,6 +161,9 @@ void FilterLineEdit::loadSettings()
     const bool filterCaseSensitive = appConfig.option("filter_case_insensitive", true);
     m_actionCaseInsensitive->setChecked(filterCaseSensitive);
 
+    const bool filterFuzzy = appConfig.option("filter_fuzzy", false);
+    m_actionFuzzy->setChecked(filterFuzzy);
+
     // KDE has custom icons for this. Notice that icon namings are counter intuitive.
     // If these icons are not available we use the freedesktop standard name before
     // falling back to a bundled resource.
@@ -210,6 +225,7 @@ void FilterLineEdit::onMenuAction()
     AppConfig appConfig;
     appConfig.setOption("filter_regular_expression", m_actionRe->isChecked());
     appConfig.setOption("filter_case_insensitive", m_actionCaseInsensitive->isChecked());
+    appConfig.setOption("filter_fuzzy", m_actionFuzzy->isChecked());
 
     const QRegExp re = filter();
     if ( !re.isEmpty() )
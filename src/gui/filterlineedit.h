@@ -44,6 +44,9 @@ public:
 
     QRegExp filter() const;
 
+    /** Return true if filter matches characters in order (see FuzzyMatcher). */
+    bool isFuzzy() const;
+
     void loadSettings();
 
 signals:
@@ -64,6 +67,7 @@ private:
     QTimer *m_timerSearch;
     QAction *m_actionRe;
     QAction *m_actionCaseInsensitive;
+    QAction *m_actionFuzzy;
 };
 
 } // namespace Utils
@@ -22,6 +22,7 @@
 
 #include "gui/tabicons.h"
 
+#include <QCoreApplication>
 #include <QPushButton>
 
 ImportExportDialog::ImportExportDialog(QWidget *parent)
@@ -30,6 +31,8 @@ ImportExportDialog::ImportExportDialog(QWidget *parent)
 {
     ui->setupUi(this);
 
+    ui->progressBar->hide();
+
     connect( ui->listTabs, SIGNAL(itemSelectionChanged()),
              this, SLOT(update()) );
     connect( ui->checkBoxConfiguration, SIGNAL(stateChanged(int)),
@@ -105,6 +108,29 @@ bool ImportExportDialog::isCommandsEnabled() const
             && !ui->checkBoxCommands->isHidden();
 }
 
+void ImportExportDialog::startProgress(int maximum)
+{
+    ui->checkBoxAll->hide();
+    ui->labelTabs->hide();
+    ui->listTabs->hide();
+    ui->checkBoxConfiguration->hide();
+    ui->checkBoxCommands->hide();
+    ui->buttonBox->setEnabled(false);
+
+    ui->progressBar->setRange(0, maximum);
+    ui->progressBar->setValue(0);
+    ui->progressBar->show();
+
+    show();
+    QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+}
+
+void ImportExportDialog::setProgress(int value)
+{
+    ui->progressBar->setValue(value);
+    QCoreApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
+}
+
 void ImportExportDialog::on_checkBoxAll_clicked(bool cheked)
 {
     ui->checkBoxConfiguration->setChecked(cheked);
@@ -47,6 +47,12 @@ public:
     bool isConfigurationEnabled() const;
     bool isCommandsEnabled() const;
 
+    /** Hide options and show progress bar (e.g. after the dialog is accepted). */
+    void startProgress(int maximum);
+
+    /** Update progress bar (repaints the dialog but ignores user input). */
+    void setProgress(int value);
+
 private slots:
     void on_checkBoxAll_clicked(bool checked);
 
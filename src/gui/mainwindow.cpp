@@ -26,6 +26,7 @@
 #include "common/command.h"
 #include "common/config.h"
 #include "common/contenttype.h"
+#include "common/fuzzymatcher.h"
 #include "common/log.h"
 #include "common/mimetypes.h"
 #include "gui/aboutdialog.h"
@@ -50,7 +51,10 @@
 #include "gui/theme.h"
 #include "gui/traymenu.h"
 #include "gui/windowgeometryguard.h"
+#include "item/clipboardmodel.h"
 #include "item/itemfactory.h"
+#include "item/itemfiltermatches.h"
+#include "item/itemtabsearch.h"
 #include "item/serialize.h"
 #include "platform/platformnativeinterface.h"
 #include "platform/platformwindow.h"
@@ -60,6 +64,7 @@
 #endif
 
 #include <QAction>
+#include <QBitArray>
 #include <QCloseEvent>
 #include <QFile>
 #include <QFileDialog>
@@ -78,6 +83,7 @@
 #endif
 
 #include <algorithm>
+#include <limits>
 #include <memory>
 
 namespace {
@@ -92,6 +98,9 @@ const int clipboardNotificationId = 0;
 
 const char propertyWidgetSizeGuarded[] = "CopyQ_widget_size_guarded";
 
+/// Approximate size of chunk with items in exported file.
+const int exportChunkSize = 1024 * 1024;
+
 /// Omit size changes of a widget.
 class WidgetSizeGuard : public QObject {
 public:
@@ -381,6 +390,40 @@ QVariant serializableValue(const QSettings &settings, const QString &key)
     return QString();
 }
 
+QVariantMap exportSettings()
+{
+    QVariantMap settingsMap;
+    const QSettings settings;
+
+    for (const auto &key : settings.allKeys()) {
+        if ( !key.startsWith("Commands/") )
+            settingsMap[key] = serializableValue(settings, key);
+    }
+
+    return settingsMap;
+}
+
+QVariantList exportCommandList()
+{
+    QVariantList commandsList;
+    QSettings settings;
+
+    const int commandCount = settings.beginReadArray("Commands");
+    for (int i = 0; i < commandCount; ++i) {
+        settings.setArrayIndex(i);
+
+        QVariantMap commandMap;
+        for ( const auto &key : settings.allKeys() )
+            commandMap[key] = serializableValue(settings, key);
+
+        commandsList.append(commandMap);
+    }
+
+    settings.endArray();
+
+    return commandsList;
+}
+
 #ifdef HAS_TESTS
 /**
  * Read base64-encoded settings from "COPYQ_TEST_SETTINGS" enviroment variable if not empty.
@@ -432,6 +475,7 @@ MainWindow::MainWindow(ItemFactory *itemFactory, QWidget *parent)
     , ui(new Ui::MainWindow)
     , m_menuItem(nullptr)
     , m_trayMenu( new TrayMenu(this) )
+    , m_trayMenuFilterMatches( new ItemFilterMatches(this) )
     , m_tray(nullptr)
     , m_clipboardStoringDisabled(false)
     , m_actionToggleClipboardStoring()
@@ -440,6 +484,7 @@ MainWindow::MainWindow(ItemFactory *itemFactory, QWidget *parent)
     , m_notifications(nullptr)
     , m_actionHandler(new ActionHandler(this))
     , m_menu( new TrayMenu(this) )
+    , m_menuFilterMatches( new ItemFilterMatches(this) )
     , m_menuMaxItemCount(-1)
     , m_commandDialog(nullptr)
     , m_canUpdateTitleFromScript(true)
@@ -472,13 +517,13 @@ MainWindow::MainWindow(ItemFactory *itemFactory, QWidget *parent)
              this, SLOT(updateFocusWindows()) );
     connect( m_trayMenu, SIGNAL(searchRequest(QString)),
              this, SLOT(addTrayMenuItems(QString)) );
-    connect( m_trayMenu, SIGNAL(clipboardItemActionTriggered(uint,bool)),
-             this, SLOT(onTrayActionTriggered(uint,bool)) );
+    connect( m_trayMenu, SIGNAL(clipboardItemActionTriggered(quint64,bool)),
+             this, SLOT(onTrayActionTriggered(quint64,bool)) );
 
     connect( m_menu, SIGNAL(searchRequest(QString)),
              this, SLOT(addMenuItems(QString)) );
-    connect( m_menu, SIGNAL(clipboardItemActionTriggered(uint,bool)),
-             this, SLOT(onMenuActionTriggered(uint,bool)) );
+    connect( m_menu, SIGNAL(clipboardItemActionTriggered(quint64,bool)),
+             this, SLOT(onMenuActionTriggered(quint64,bool)) );
 
     connect( ui->tabWidget, SIGNAL(currentChanged(int,int)),
              this, SLOT(tabChanged(int,int)) );
@@ -667,6 +712,9 @@ void MainWindow::createMenu()
     // - find
     createAction( Actions::Edit_FindItems, SLOT(findNextOrPrevious()), menu );
 
+    // - find in all tabs
+    createAction( Actions::Edit_FindInAllTabs, SLOT(findInAllTabs()), menu );
+
     // - separator
     menu->addSeparator();
 
@@ -1342,6 +1390,8 @@ ClipboardBrowser *MainWindow::createTab(
              this, SLOT(activateCurrentItem()) );
     connect( c, SIGNAL(itemCountChanged(QString,int)),
              ui->tabWidget, SLOT(setTabItemCount(QString,int)) );
+    connect( c, SIGNAL(tabToolTipChanged(QString,QString)),
+             ui->tabWidget, SLOT(setTabToolTip(QString,QString)) );
     connect( c, SIGNAL(showContextMenu(QPoint)),
              this, SLOT(showContextMenu(QPoint)) );
     connect( c, SIGNAL(updateContextMenu(const ClipboardBrowser *)),
@@ -1685,29 +1735,64 @@ QAction *MainWindow::actionForMenuItem(int id, QWidget *parent, Qt::ShortcutCont
     return action;
 }
 
-void MainWindow::addMenuItems(TrayMenu *menu, ClipboardBrowser *c, int maxItemCount, const QString &searchText)
+void MainWindow::addMenuItems(
+        TrayMenu *menu, ItemFilterMatches *filterMatches, ClipboardBrowser *c,
+        int maxItemCount, const QString &searchText)
 {
     WidgetSizeGuard sizeGuard(menu);
     menu->clearClipboardItems();
 
+    if (!c || searchText.isEmpty())
+        filterMatches->clear();
+
     if (!c)
         return;
 
     const int current = c->currentIndex().row();
+
+    // Show best matching items first in fuzzy filter mode.
+    if ( !searchText.isEmpty() && ui->searchBar->isFuzzy() ) {
+        filterMatches->clear();
+        const FuzzyMatcher matcher(searchText, Qt::CaseInsensitive);
+        for ( int row : c->findFuzzy(matcher, maxItemCount) ) {
+            const QModelIndex index = c->model()->index(row, 0);
+            menu->addClipboardItemAction(index, m_options.trayImages, row == current);
+        }
+        return;
+    }
+
+    // Test only items matching previous search text if it was extended.
+    const QRegExp re(searchText, Qt::CaseInsensitive, QRegExp::FixedString);
+    QBitArray candidates;
+    const bool hasCandidates = !searchText.isEmpty()
+            && filterMatches->findCandidateRows(c->model(), re, &candidates);
+
+    QBitArray matches(c->length());
+
     int itemCount = 0;
-    for ( int i = 0; i < c->length() && itemCount < maxItemCount; ++i ) {
+    int i = 0;
+    for ( ; i < c->length() && itemCount < maxItemCount; ++i ) {
+        if ( hasCandidates && !candidates.testBit(i) )
+            continue;
+
         const QModelIndex index = c->model()->index(i, 0);
         if ( !searchText.isEmpty() ) {
-            const QString itemText = index.data(contentType::text).toString().toLower();
-            if ( !itemText.contains(searchText.toLower()) )
+            const QString itemText = index.data(contentType::text).toString();
+            if ( re.indexIn(itemText) == -1 )
                 continue;
+            matches.setBit(i);
         }
         menu->addClipboardItemAction(index, m_options.trayImages, i == current);
         ++itemCount;
     }
+
+    if ( !searchText.isEmpty() ) {
+        matches.resize(i);
+        filterMatches->setMatches(c->model(), re, matches);
+    }
 }
 
-void MainWindow::onMenuActionTriggered(ClipboardBrowser *c, uint itemHash, bool omitPaste)
+void MainWindow::onMenuActionTriggered(ClipboardBrowser *c, quint64 itemHash, bool omitPaste)
 {
     if (!c)
         return;
@@ -1738,96 +1823,236 @@ QWidget *MainWindow::toggleMenu(TrayMenu *menu)
     return menu;
 }
 
-bool MainWindow::exportData(const QString &fileName, const QStringList &tabs, bool exportConfiguration, bool exportCommands)
+bool MainWindow::exportData(
+        const QString &fileName, const QStringList &tabs, bool exportConfiguration, bool exportCommands,
+        ImportExportDialog *progressDialog)
 {
     QFile file(fileName);
     if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
         return false;
 
     QDataStream out(&file);
-    return exportDataV3(&out, tabs, exportConfiguration, exportCommands);
+    return exportDataV4(&out, tabs, exportConfiguration, exportCommands, progressDialog);
 }
 
-bool MainWindow::exportDataV3(QDataStream *out, const QStringList &tabs, bool exportConfiguration, bool exportCommands)
+bool MainWindow::exportDataV4(
+        QDataStream *out, const QStringList &tabs, bool exportConfiguration, bool exportCommands,
+        ImportExportDialog *progressDialog)
 {
+    // Items are exported from a snapshot since tabs and items can be changed
+    // or removed while processing events to update the progress.
+    QVector< QVector<ClipboardItem> > tabItems;
     QVariantList tabsList;
+    int totalItemCount = 0;
+
     for (const auto &tab : tabs) {
         const auto i = findTabIndex(tab);
         if (i == -1)
             continue;
 
         ClipboardBrowser *c = browser(i);
-        const auto tabName = c->tabName();
-
-        QByteArray tabBytes;
-        {
-            QDataStream tabOut(&tabBytes, QIODevice::WriteOnly);
-            tabOut.setVersion(QDataStream::Qt_4_7);
-            if ( !serializeData(*c->model(), &tabOut) )
-                return false;
-        }
+        const auto model = qobject_cast<const ClipboardModel*>( c->model() );
+        if (!model)
+            continue;
 
+        const auto tabName = c->tabName();
         const auto iconName = getIconNameForTabName(tabName);
+        const auto items = model->items();
 
         QVariantMap tabMap;
         tabMap["name"] = tabName;
-        tabMap["data"] = tabBytes;
+        tabMap["count"] = items.size();
         if ( !iconName.isEmpty() )
             tabMap["icon"] = iconName;
 
         tabsList.append(tabMap);
+        tabItems.append(items);
+        totalItemCount += items.size();
     }
 
-    QVariantMap settingsMap;
+    // Table of contents is small and can be read before any items.
+    QVariantMap data;
+    if ( !tabsList.isEmpty() )
+        data["tabs"] = tabsList;
     if (exportConfiguration) {
-        const QSettings settings;
+        const auto settingsMap = exportSettings();
+        if ( !settingsMap.isEmpty() )
+            data["settings"] = settingsMap;
+    }
+    if (exportCommands) {
+        const auto commandsList = exportCommandList();
+        if ( !commandsList.isEmpty() )
+            data["commands"] = commandsList;
+    }
 
-        for (const auto &key : settings.allKeys()) {
-            if ( !key.startsWith("Commands/") )
-                settingsMap[key] = serializableValue(settings, key);
+    out->setVersion(QDataStream::Qt_4_7);
+    (*out) << QByteArray("CopyQ v4");
+    (*out) << data;
+
+    if (progressDialog)
+        progressDialog->startProgress(totalItemCount);
+
+    int exportedItemCount = 0;
+    for (const auto &items : tabItems) {
+        const int count = items.size();
+
+        // Items are written in chunks followed by empty chunk.
+        for (int row = 0; row < count; ) {
+            QByteArray chunk;
+            qint32 chunkItemCount = 0;
+            {
+                QDataStream chunkOut(&chunk, QIODevice::WriteOnly);
+                chunkOut.setVersion(QDataStream::Qt_4_7);
+                for ( ; row < count && chunk.size() < exportChunkSize; ++row, ++chunkItemCount ) {
+                    // Avoid keeping all data of lazily loaded items in memory.
+                    serializeData( &chunkOut, items[row].readData() );
+                }
+            }
+
+            (*out) << chunkItemCount << chunk;
+            if ( out->status() != QDataStream::Ok )
+                return false;
+
+            exportedItemCount += chunkItemCount;
+            if (progressDialog)
+                progressDialog->setProgress(exportedItemCount);
         }
+
+        (*out) << qint32(0);
     }
 
-    QVariantList commandsList;
-    if (exportCommands) {
-        QSettings settings;
+    return out->status() == QDataStream::Ok;
+}
 
-        const int commandCount = settings.beginReadArray("Commands");
-        for (int i = 0; i < commandCount; ++i) {
-            settings.setArrayIndex(i);
+bool MainWindow::importDataV4(QDataStream *in, ImportOptions options)
+{
+    in->setVersion(QDataStream::Qt_4_7);
 
-            QVariantMap commandMap;
-            for ( const auto &key : settings.allKeys() )
-                commandMap[key] = serializableValue(settings, key);
+    QVariantMap data;
+    (*in) >> data;
+    if ( in->status() != QDataStream::Ok )
+        return false;
+
+    const auto tabsList = data.value("tabs").toList();
+
+    QStringList tabs;
+    for (const auto &tabMapValue : tabsList) {
+        const auto tabMap = tabMapValue.toMap();
+        tabs.append( tabMap["name"].toString() );
+    }
+
+    const auto settingsMap = data.value("settings").toMap();
+    const auto commandsList = data.value("commands").toList();
+
+    bool importConfiguration = true;
+    bool importCommands = true;
 
-            commandsList.append(commandMap);
+    std::unique_ptr<ImportExportDialog> importDialog;
+    if (options == ImportOptions::Select) {
+        importDialog.reset( new ImportExportDialog(this) );
+        if ( !selectImportOptions(
+                 importDialog.get(), &tabs, !settingsMap.isEmpty(), !commandsList.isEmpty(),
+                 &importConfiguration, &importCommands) )
+        {
+            return true;
         }
 
-        settings.endArray();
+        int totalItemCount = 0;
+        for (const auto &tabMapValue : tabsList) {
+            const auto tabMap = tabMapValue.toMap();
+            if ( tabs.contains(tabMap["name"].toString()) )
+                totalItemCount += tabMap["count"].toInt();
+        }
+        importDialog->startProgress(totalItemCount);
     }
 
-    QVariantMap data;
-    if ( !tabsList.isEmpty() )
-        data["tabs"] = tabsList;
-    if ( !settingsMap.isEmpty() )
-        data["settings"] = settingsMap;
-    if ( !commandsList.isEmpty() )
-        data["commands"] = commandsList;
+    // Don't read items based on current value of "maxitems" option since
+    // the option can be later also imported.
+    const bool readAllItems = importConfiguration;
 
-    out->setVersion(QDataStream::Qt_4_7);
-    (*out) << QByteArray("CopyQ v3");
-    (*out) << data;
+    int importedItemCount = 0;
+    for (const auto &tabMapValue : tabsList) {
+        const auto tabMap = tabMapValue.toMap();
+        const auto oldTabName = tabMap["name"].toString();
 
-    return out->status() == QDataStream::Ok;
+        // Items of tabs which are not imported are skipped.
+        // Tab can be removed while processing events to update the progress.
+        QPointer<ClipboardBrowser> c;
+        int maxItemCount = 0;
+        if ( tabs.contains(oldTabName) ) {
+            auto tabName = oldTabName;
+            renameToUnique( &tabName, ui->tabWidget->tabs() );
+
+            const auto iconName = tabMap.value("icon").toString();
+            if ( !iconName.isEmpty() )
+                setIconNameForTabName(tabName, iconName);
+
+            c = createTab(tabName, MatchExactTabName);
+            c->loadItems();
+            const auto model = qobject_cast<ClipboardModel*>( c->model() );
+            if (model) {
+                maxItemCount = readAllItems ? std::numeric_limits<int>::max()
+                        : model->maxItems() - model->rowCount();
+            } else {
+                c = nullptr;
+            }
+        }
+
+        // Imported items are added above existing items.
+        int row = 0;
+
+        for (;;) {
+            qint32 chunkItemCount;
+            (*in) >> chunkItemCount;
+            if ( in->status() != QDataStream::Ok || chunkItemCount < 0 )
+                return false;
+
+            if (chunkItemCount == 0)
+                break;
+
+            QByteArray chunk;
+            (*in) >> chunk;
+            if ( in->status() != QDataStream::Ok )
+                return false;
+
+            const auto model = c ? qobject_cast<ClipboardModel*>( c->model() ) : nullptr;
+            if (model && row < maxItemCount) {
+                QDataStream chunkIn(chunk);
+                chunkIn.setVersion(QDataStream::Qt_4_7);
+
+                const int itemCount = qMin(chunkItemCount, maxItemCount - row);
+                QVector<QVariantMap> dataList;
+                dataList.reserve(itemCount);
+                for (int i = 0; i < itemCount; ++i) {
+                    QVariantMap itemData;
+                    deserializeData(&chunkIn, &itemData);
+                    if ( chunkIn.status() != QDataStream::Ok )
+                        return false;
+                    dataList.append(itemData);
+                }
+
+                // Items above can be removed while processing events.
+                row = qMin( row, model->rowCount() );
+                model->insertItems(dataList, row);
+                row += itemCount;
+            }
+
+            if (model) {
+                importedItemCount += chunkItemCount;
+                if (importDialog)
+                    importDialog->setProgress(importedItemCount);
+            }
+        }
+    }
+
+    if ( !importSettingsAndCommands(settingsMap, commandsList, importConfiguration, importCommands) )
+        return false;
+
+    return in->status() == QDataStream::Ok;
 }
 
 bool MainWindow::importDataV3(QDataStream *in, ImportOptions options)
 {
-    QByteArray header;
-    (*in) >> header;
-    if ( !header.startsWith("CopyQ v3") )
-        return false;
-
     QVariantMap data;
     (*in) >> data;
     if ( in->status() != QDataStream::Ok )
@@ -1850,18 +2075,12 @@ bool MainWindow::importDataV3(QDataStream *in, ImportOptions options)
 
     if (options == ImportOptions::Select) {
         ImportExportDialog importDialog(this);
-        importDialog.setWindowTitle( tr("CopyQ Options for Import") );
-        importDialog.setTabs(tabs);
-        importDialog.setHasConfiguration( !settingsMap.isEmpty() );
-        importDialog.setHasCommands( !commandsList.isEmpty() );
-        importDialog.setConfigurationEnabled(true);
-        importDialog.setCommandsEnabled(true);
-        if ( importDialog.exec() != QDialog::Accepted )
+        if ( !selectImportOptions(
+                 &importDialog, &tabs, !settingsMap.isEmpty(), !commandsList.isEmpty(),
+                 &importConfiguration, &importCommands) )
+        {
             return true;
-
-        tabs = importDialog.selectedTabs();
-        importConfiguration = importDialog.isConfigurationEnabled();
-        importCommands = importDialog.isCommandsEnabled();
+        }
     }
 
     for (const auto &tabMapValue : tabsList) {
@@ -1891,6 +2110,35 @@ bool MainWindow::importDataV3(QDataStream *in, ImportOptions options)
             return false;
     }
 
+    if ( !importSettingsAndCommands(settingsMap, commandsList, importConfiguration, importCommands) )
+        return false;
+
+    return in->status() == QDataStream::Ok;
+}
+
+bool MainWindow::selectImportOptions(
+        ImportExportDialog *importDialog, QStringList *tabs, bool hasConfiguration, bool hasCommands,
+        bool *importConfiguration, bool *importCommands)
+{
+    importDialog->setWindowTitle( tr("CopyQ Options for Import") );
+    importDialog->setTabs(*tabs);
+    importDialog->setHasConfiguration(hasConfiguration);
+    importDialog->setHasCommands(hasCommands);
+    importDialog->setConfigurationEnabled(true);
+    importDialog->setCommandsEnabled(true);
+    if ( importDialog->exec() != QDialog::Accepted )
+        return false;
+
+    *tabs = importDialog->selectedTabs();
+    *importConfiguration = importDialog->isConfigurationEnabled();
+    *importCommands = importDialog->isCommandsEnabled();
+    return true;
+}
+
+bool MainWindow::importSettingsAndCommands(
+        const QVariantMap &settingsMap, const QVariantList &commandsList,
+        bool importConfiguration, bool importCommands)
+{
     if (importConfiguration) {
         // Configuration dialog shouldn't be open.
         if (cm)
@@ -1934,7 +2182,7 @@ bool MainWindow::importDataV3(QDataStream *in, ImportOptions options)
         onCommandDialogSaved();
     }
 
-    return in->status() == QDataStream::Ok;
+    return true;
 }
 
 int MainWindow::findTabIndex(const QString &name)
@@ -2424,12 +2672,12 @@ void MainWindow::showBrowser(int index)
         showWindow();
 }
 
-void MainWindow::onMenuActionTriggered(uint itemHash, bool omitPaste)
+void MainWindow::onMenuActionTriggered(quint64 itemHash, bool omitPaste)
 {
     onMenuActionTriggered( getTabForMenu(), itemHash, omitPaste );
 }
 
-void MainWindow::onTrayActionTriggered(uint itemHash, bool omitPaste)
+void MainWindow::onTrayActionTriggered(quint64 itemHash, bool omitPaste)
 {
     onMenuActionTriggered( getTabForTrayMenu(), itemHash, omitPaste );
 }
@@ -2503,7 +2751,7 @@ void MainWindow::tabChanged(int current, int)
         // update item menu (necessary for keyboard shortcuts to work)
         ClipboardBrowser *c = getBrowser();
 
-        c->filterItems( ui->searchBar->filter() );
+        c->filterItems( ui->searchBar->filter(), ui->searchBar->isFuzzy() );
 
         if ( current >= 0 ) {
             if( !c->currentIndex().isValid() && isVisible() ) {
@@ -2816,6 +3064,19 @@ QStringList MainWindow::tabs() const
     return ui->tabWidget->tabs();
 }
 
+QVector<ItemTabSearchResult> MainWindow::searchTabs(const QRegExp &re, int maxCount)
+{
+    ItemTabSearch search(re);
+
+    for ( int i = 0; i < ui->tabWidget->count(); ++i ) {
+        ClipboardBrowser *c = getBrowser(i);
+        if (c)
+            search.addTab( c->tabName(), c->searchableTexts() );
+    }
+
+    return search.results(maxCount);
+}
+
 ClipboardBrowser *MainWindow::getTabForMenu()
 {
     const auto i = findTabIndex(m_menuTabName);
@@ -2840,7 +3101,7 @@ void MainWindow::onFilterChanged(const QRegExp &re)
         enterBrowseMode();
     else if ( browseMode() )
         enterSearchMode();
-    browser()->filterItems(re);
+    browser()->filterItems( re, ui->searchBar->isFuzzy() );
     updateItemPreview();
 }
 
@@ -2906,6 +3167,40 @@ void MainWindow::findNextOrPrevious()
     }
 }
 
+void MainWindow::findInAllTabs()
+{
+    if ( ui->searchBar->text().isEmpty() ) {
+        enterSearchMode();
+        return;
+    }
+
+    const QVector<ItemTabSearchResult> results = searchTabs( ui->searchBar->filter() );
+    if ( results.isEmpty() )
+        return;
+
+    // Select result after current item or the best one.
+    ClipboardBrowser *c = getBrowser();
+    int next = 0;
+    if (c) {
+        const int currentRow = c->currentIndex().row();
+        for (int i = 0; i < results.size(); ++i) {
+            if ( results[i].row == currentRow && results[i].tabName == c->tabName() ) {
+                next = (i + 1) % results.size();
+                break;
+            }
+        }
+    }
+
+    const ItemTabSearchResult &result = results[next];
+    const int tabIndex = findTabIndexExactMatch(result.tabName);
+    if ( !setCurrentTab(tabIndex) )
+        return;
+
+    c = browser(tabIndex);
+    if ( c->isLoaded() )
+        c->setCurrent(result.row);
+}
+
 void MainWindow::enterBrowseMode()
 {
     getBrowser()->setFocus();
@@ -2959,12 +3254,12 @@ void MainWindow::updateTrayMenuItems()
 
 void MainWindow::addMenuItems(const QString &searchText)
 {
-    addMenuItems(m_menu, getTabForMenu(), m_menuMaxItemCount, searchText);
+    addMenuItems(m_menu, m_menuFilterMatches, getTabForMenu(), m_menuMaxItemCount, searchText);
 }
 
 void MainWindow::addTrayMenuItems(const QString &searchText)
 {
-    addMenuItems(m_trayMenu, getTabForTrayMenu(), m_options.trayItems, searchText);
+    addMenuItems(m_trayMenu, m_trayMenuFilterMatches, getTabForTrayMenu(), m_options.trayItems, searchText);
 }
 
 void MainWindow::openLogDialog()
@@ -3178,7 +3473,7 @@ bool MainWindow::exportData()
     const bool exportConfiguration = exportDialog.isConfigurationEnabled();
     const bool exportCommands = exportDialog.isCommandsEnabled();
 
-    if ( !exportData(fileName, tabs, exportConfiguration, exportCommands) ) {
+    if ( !exportData(fileName, tabs, exportConfiguration, exportCommands, &exportDialog) ) {
         QMessageBox::critical(
                     this, tr("CopyQ Export Error"),
                     tr("Failed to export file %1!")
@@ -3241,7 +3536,14 @@ bool MainWindow::importData(const QString &fileName, ImportOptions options)
 
     QDataStream in(&file);
 
-    return importDataV3(&in, options);
+    QByteArray header;
+    in >> header;
+    if ( header.startsWith("CopyQ v4") )
+        return importDataV4(&in, options);
+    if ( header.startsWith("CopyQ v3") )
+        return importDataV3(&in, options);
+
+    return false;
 }
 
 bool MainWindow::exportAllData(const QString &fileName)
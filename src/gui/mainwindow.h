@@ -36,10 +36,13 @@ class Action;
 class ActionHandler;
 class CommandDialog;
 class ConfigurationManager;
+class ImportExportDialog;
+class ItemFilterMatches;
 class NotificationDaemon;
 class QModelIndex;
 class TrayMenu;
 struct Command;
+struct ItemTabSearchResult;
 struct MainWindowOptions;
 
 Q_DECLARE_METATYPE(QPersistentModelIndex)
@@ -290,6 +293,13 @@ public:
 
     QStringList tabs() const;
 
+    /**
+     * Return items matching @a re in all tabs, best matches first (see ItemTabSearch).
+     *
+     * Unloaded tabs are searched using saved search index if possible.
+     */
+    QVector<ItemTabSearchResult> searchTabs(const QRegExp &re, int maxCount = -1);
+
     /** Update the first item in the first tab. */
     void updateFirstItem(QVariantMap data);
 
@@ -511,9 +521,10 @@ private slots:
     void addMenuItems(const QString &searchText);
     void addTrayMenuItems(const QString &searchText);
     void trayActivated(QSystemTrayIcon::ActivationReason reason);
-    void onMenuActionTriggered(uint itemHash, bool omitPaste);
-    void onTrayActionTriggered(uint itemHash, bool omitPaste);
+    void onMenuActionTriggered(quint64 itemHash, bool omitPaste);
+    void onTrayActionTriggered(quint64 itemHash, bool omitPaste);
     void findNextOrPrevious();
+    void findInAllTabs();
     void tabChanged(int current, int previous);
     void saveTabPositions();
     void tabsMoved(const QString &oldPrefix, const QString &newPrefix);
@@ -657,19 +668,33 @@ private:
 
     QAction *actionForMenuItem(int id, QWidget *parent, Qt::ShortcutContext context);
 
-    void addMenuItems(TrayMenu *menu, ClipboardBrowser *c, int maxItemCount, const QString &searchText);
-    void onMenuActionTriggered(ClipboardBrowser *c, uint clipboardItemHash, bool omitPaste);
+    void addMenuItems(
+            TrayMenu *menu, ItemFilterMatches *filterMatches, ClipboardBrowser *c,
+            int maxItemCount, const QString &searchText);
+    void onMenuActionTriggered(ClipboardBrowser *c, quint64 clipboardItemHash, bool omitPaste);
     QWidget *toggleMenu(TrayMenu *menu);
 
-    bool exportData(const QString &fileName, const QStringList &tabs, bool exportConfiguration, bool exportCommands);
-    bool exportDataV3(QDataStream *out, const QStringList &tabs, bool exportConfiguration, bool exportCommands);
+    bool exportData(
+            const QString &fileName, const QStringList &tabs, bool exportConfiguration, bool exportCommands,
+            ImportExportDialog *progressDialog = nullptr);
+    bool exportDataV4(
+            QDataStream *out, const QStringList &tabs, bool exportConfiguration, bool exportCommands,
+            ImportExportDialog *progressDialog);
     bool importDataV3(QDataStream *in, ImportOptions options);
+    bool importDataV4(QDataStream *in, ImportOptions options);
+    bool selectImportOptions(
+            ImportExportDialog *importDialog, QStringList *tabs, bool hasConfiguration, bool hasCommands,
+            bool *importConfiguration, bool *importCommands);
+    bool importSettingsAndCommands(
+            const QVariantMap &settingsMap, const QVariantList &commandsList,
+            bool importConfiguration, bool importCommands);
 
     ConfigurationManager *cm;
     Ui::MainWindow *ui;
 
     QMenu *m_menuItem;
     TrayMenu *m_trayMenu;
+    ItemFilterMatches *m_trayMenuFilterMatches;
 
     QSystemTrayIcon *m_tray;
 
@@ -697,6 +722,7 @@ private:
     QVariantMap m_clipboardData;
 
     TrayMenu *m_menu;
+    ItemFilterMatches *m_menuFilterMatches;
     QString m_menuTabName;
     int m_menuMaxItemCount;
 
@@ -94,6 +94,8 @@ MenuItems menuItems()
                   "copy_selected_items", QKeySequence::Copy, "edit-copy", IconCopy );
     addMenuItem( items, Actions::Edit_FindItems, QObject::tr("&Find"),
                   "find_items", QKeySequence::FindNext, "edit-find", IconSearch );
+    addMenuItem( items, Actions::Edit_FindInAllTabs, QObject::tr("Find in &All Tabs"),
+                  "find_in_all_tabs", QObject::tr("Ctrl+Shift+F"), "edit-find", IconSearch );
 
     addMenuItem( items, Actions::Item_MoveToClipboard, QObject::tr("Move to &Clipboard"),
                   "move_to_clipboard", QKeySequence(), "clipboard", IconPaste );
@@ -43,6 +43,7 @@ enum Id {
     Edit_PasteItems,
     Edit_CopySelectedItems,
     Edit_FindItems,
+    Edit_FindInAllTabs,
 
     Item_MoveToClipboard,
     Item_ShowContent,
@@ -87,6 +87,13 @@ void TabBar::updateTabIcons()
         ::updateTabIcon(i, this);
 }
 
+void TabBar::setTabToolTip(const QString &tabName, const QString &toolTip)
+{
+    const int i = tabIndex(tabName, *this);
+    if (i != -1)
+        QTabBar::setTabToolTip(i, toolTip);
+}
+
 void TabBar::setTabItemCount(const QString &tabName, const QString &itemCount)
 {
     const int i = tabIndex(tabName, *this);
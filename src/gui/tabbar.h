@@ -40,6 +40,8 @@ public:
 
     void setTabItemCount(const QString &tabName, const QString &itemCount);
 
+    void setTabToolTip(const QString &tabName, const QString &toolTip);
+
 signals:
     void tabMenuRequested(const QPoint &pos, int tab);
     void tabRenamed(const QString &newName, int index);
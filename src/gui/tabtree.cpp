@@ -464,6 +464,13 @@ void TabTree::setTabItemCount(const QString &tabName, const QString &itemCount)
     updateSize();
 }
 
+void TabTree::setTabToolTip(const QString &tabName, const QString &toolTip)
+{
+    QTreeWidgetItem *item = findTreeItem(tabName);
+    if ( item && !isTabGroup(item) )
+        item->setToolTip(0, toolTip);
+}
+
 void TabTree::setCollapsedTabs(const QStringList &collapsedPaths)
 {
     for (const auto &path : collapsedPaths) {
@@ -63,6 +63,8 @@ public:
 
     void setTabItemCount(const QString &tabName, const QString &itemCount);
 
+    void setTabToolTip(const QString &tabName, const QString &toolTip);
+
     void setCollapsedTabs(const QStringList &collapsedPaths);
 
     QStringList collapsedTabs() const;
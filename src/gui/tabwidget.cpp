@@ -135,12 +135,15 @@ void TabWidget::setTabText(int tabIndex, const QString &tabName)
     const QString oldTabName = tabText(tabIndex);
     if ( m_tabItemCounters.contains(oldTabName) )
         m_tabItemCounters.insert( tabName, m_tabItemCounters.take(oldTabName) );
+    if ( m_tabToolTips.contains(oldTabName) )
+        m_tabToolTips.insert( tabName, m_tabToolTips.take(oldTabName) );
 
     if ( isTreeModeEnabled() )
         m_tabTree->setTabText(tabIndex, tabName);
     else
         m_tabBar->setTabText(tabIndex, tabName);
 
+    updateTabToolTip(tabName);
     updateSize();
 }
 
@@ -178,6 +181,7 @@ void TabWidget::insertTab(int tabIndex, QWidget *widget, const QString &tabText)
         emit currentChanged(0, -1);
 
     updateTabItemCount(tabText);
+    updateTabToolTip(tabText);
     updateToolBar();
 }
 
@@ -188,6 +192,7 @@ void TabWidget::removeTab(int tabIndex)
 
     const QString tabName = tabText(tabIndex);
     m_tabItemCounters.remove(tabName);
+    m_tabToolTips.remove(tabName);
 
     // Item count must be updated If tab is removed but tab group remains.
     if (isTreeModeEnabled())
@@ -367,6 +372,7 @@ void TabWidget::setTreeModeEnabled(bool enabled)
             const QString &tabName = tabs[i];
             m_tabTree->insertTab(tabName, i, i == 0);
             m_tabTree->setTabItemCount(tabName, itemCountLabel(tabName));
+            m_tabTree->setTabToolTip( tabName, m_tabToolTips.value(tabName) );
         }
 
         m_tabTree->setCollapsedTabs(m_collapsedTabs);
@@ -381,6 +387,7 @@ void TabWidget::setTreeModeEnabled(bool enabled)
             const QString &tabName = tabs[i];
             m_tabBar->insertTab(i, tabName);
             m_tabBar->setTabItemCount(tabName, itemCountLabel(tabName));
+            m_tabBar->setTabToolTip( tabName, m_tabToolTips.value(tabName) );
         }
     }
 }
@@ -395,6 +402,16 @@ void TabWidget::setTabItemCount(const QString &tabName, int itemCount)
     updateTabItemCount(tabName);
 }
 
+void TabWidget::setTabToolTip(const QString &tabName, const QString &toolTip)
+{
+    if ( m_tabToolTips.value(tabName) == toolTip )
+        return;
+
+    m_tabToolTips[tabName] = toolTip;
+
+    updateTabToolTip(tabName);
+}
+
 bool TabWidget::eventFilter(QObject *, QEvent *event)
 {
     if (event->type() == QEvent::Move)
@@ -541,6 +558,14 @@ void TabWidget::updateTabItemCount(const QString &name)
     updateSize();
 }
 
+void TabWidget::updateTabToolTip(const QString &name)
+{
+    if ( isTreeModeEnabled() )
+        m_tabTree->setTabToolTip( name, m_tabToolTips.value(name) );
+    else
+        m_tabBar->setTabToolTip( name, m_tabToolTips.value(name) );
+}
+
 void TabWidget::updateSize()
 {
     if ( isTreeModeEnabled() )
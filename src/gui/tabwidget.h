@@ -99,6 +99,7 @@ public slots:
     void setTabBarHidden(bool hidden);
     void setTreeModeEnabled(bool enabled);
     void setTabItemCount(const QString &tabName, int itemCount);
+    void setTabToolTip(const QString &tabName, const QString &toolTip);
 
 signals:
     /// Tabs moved in tab bar.
@@ -126,6 +127,7 @@ private:
     void createTabTree();
     void updateToolBar();
     void updateTabItemCount(const QString &name);
+    void updateTabToolTip(const QString &name);
     void updateSize();
     QString itemCountLabel(const QString &name);
 
@@ -138,6 +140,7 @@ private:
 
     QStringList m_collapsedTabs;
     QMap<QString, int> m_tabItemCounters;
+    QMap<QString, QString> m_tabToolTips;
 
     bool m_showTabItemCount;
 };
@@ -307,7 +307,7 @@ void TrayMenu::onClipboardItemActionTriggered()
     QVariant actionData = act->data();
     Q_ASSERT( actionData.isValid() );
 
-    uint hash = actionData.toUInt();
+    const quint64 hash = actionData.toULongLong();
     emit clipboardItemActionTriggered(hash, m_omitPaste);
     close();
 }
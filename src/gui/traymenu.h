@@ -54,7 +54,7 @@ public:
 
 signals:
     /** Emitted if numbered action triggered. */
-    void clipboardItemActionTriggered(uint clipboardItemHash, bool omitPaste);
+    void clipboardItemActionTriggered(quint64 clipboardItemHash, bool omitPaste);
 
     void searchRequest(const QString &text);
 
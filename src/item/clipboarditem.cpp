@@ -22,21 +22,49 @@
 #include "common/common.h"
 #include "common/contenttype.h"
 #include "common/mimetypes.h"
+#include "item/itemblobstore.h"
 #include "item/serialize.h"
 
 #include <QBrush>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QIODevice>
 #include <QString>
 #include <QStringList>
 #include <QVariant>
+#include <QVector>
 
 namespace {
 
-void clearDataExceptInternal(QVariantMap *data)
+void clearDataExceptInternal(ItemData *data)
 {
-    for ( const auto &format : data->keys() ) {
-        if ( !format.startsWith(COPYQ_MIME_PREFIX) )
-            data->remove(format);
+    for (int i = data->size() - 1; i >= 0; --i) {
+        if ( !itemFormatName(data->formatIdAt(i)).startsWith(COPYQ_MIME_PREFIX) )
+            data->removeAt(i);
+    }
+}
+
+void removeTextData(ItemData *data)
+{
+    for (int i = data->size() - 1; i >= 0; --i) {
+        if ( itemFormatName(data->formatIdAt(i)).startsWith("text/") )
+            data->removeAt(i);
+    }
+}
+
+QElapsedTimer startedTimer()
+{
+    QElapsedTimer timer;
+    timer.start();
+    return timer;
+}
+
+/// Share bigger data with other items.
+void internData(ItemData *data)
+{
+    for (int i = 0; i < data->size(); ++i) {
+        if ( data->bytesAt(i).size() >= minBlobSize )
+            data->setBytesAt( i, internBlob(data->bytesAt(i)) );
     }
 }
 
@@ -44,7 +72,12 @@ void clearDataExceptInternal(QVariantMap *data)
 
 ClipboardItem::ClipboardItem()
     : m_data()
+    , m_payloads()
     , m_hash(0)
+    , m_encodedCache(std::make_shared<ItemEncodedCache>())
+    , m_searchableTexts()
+    , m_hasSearchableTexts(false)
+    , m_lastAccess(itemAccessTime())
 {
 }
 
@@ -55,28 +88,38 @@ bool ClipboardItem::operator ==(const ClipboardItem &item) const
 
 void ClipboardItem::setText(const QString &text)
 {
-    for ( const auto &format : m_data.keys() ) {
+    removeTextData(&m_data);
+
+    for ( const auto &format : m_payloads.keys() ) {
         if ( format.startsWith("text/") )
-            m_data.remove(format);
+            m_payloads.remove(format);
     }
 
-    setTextData(&m_data, text);
+    m_data.insert( mimeText, text.toUtf8() );
 
     invalidateDataHash();
 }
 
 bool ClipboardItem::setData(const QVariantMap &data)
 {
-    if (m_data == data)
+    loadAllData();
+
+    ItemData newData = ItemData::fromMap(data);
+    if (m_data == newData)
         return false;
 
-    m_data = data;
+    // Only changed formats need to be hashed again.
+    newData.copyFormatHashes(m_data);
+    m_data = newData;
+    internData(&m_data);
     invalidateDataHash();
     return true;
 }
 
 bool ClipboardItem::updateData(const QVariantMap &data)
 {
+    loadAllData();
+
     const int oldSize = m_data.size();
     for ( const auto &format : data.keys() ) {
         if ( !format.startsWith(COPYQ_MIME_PREFIX) ) {
@@ -87,18 +130,26 @@ bool ClipboardItem::updateData(const QVariantMap &data)
 
     bool changed = (oldSize != m_data.size());
 
-    for ( const auto &format : data.keys() ) {
-        const auto &value = data[format];
+    for ( auto it = data.constBegin(); it != data.constEnd(); ++it ) {
+        const auto &format = it.key();
+        const auto &value = it.value();
         if ( !value.isValid() ) {
             m_data.remove(format);
             changed = true;
-        } else if ( m_data.value(format) != value ) {
-            m_data.insert(format, value);
-            changed = true;
+        } else {
+            const QByteArray bytes = value.toByteArray();
+            const QByteArray *oldBytes = m_data.find(format);
+            if (oldBytes == nullptr || *oldBytes != bytes) {
+                m_data.insert(format, bytes);
+                changed = true;
+            }
         }
     }
 
-    invalidateDataHash();
+    if (changed) {
+        internData(&m_data);
+        invalidateDataHash();
+    }
 
     return changed;
 }
@@ -106,6 +157,7 @@ bool ClipboardItem::updateData(const QVariantMap &data)
 void ClipboardItem::removeData(const QString &mimeType)
 {
     m_data.remove(mimeType);
+    m_payloads.remove(mimeType);
     invalidateDataHash();
 }
 
@@ -114,8 +166,9 @@ bool ClipboardItem::removeData(const QStringList &mimeTypeList)
     bool removed = false;
 
     for (const auto &mimeType : mimeTypeList) {
-        if ( m_data.contains(mimeType) ) {
+        if ( hasFormat(mimeType) ) {
             m_data.remove(mimeType);
+            m_payloads.remove(mimeType);
             removed = true;
         }
     }
@@ -128,53 +181,279 @@ bool ClipboardItem::removeData(const QStringList &mimeTypeList)
 
 void ClipboardItem::setData(const QString &mimeType, const QByteArray &data)
 {
-    m_data.insert(mimeType, data);
+    m_payloads.remove(mimeType);
+    m_data.insert( mimeType, internBlob(data) );
     invalidateDataHash();
 }
 
+void ClipboardItem::setPayloads(const ItemPayloads &payloads, quint64 hash)
+{
+    m_data.clear();
+    m_payloads = payloads;
+    m_hash = hash;
+    m_encodedCache = std::make_shared<ItemEncodedCache>();
+    clearSearchableTexts();
+}
+
+QByteArray ClipboardItem::data(const QString &format) const
+{
+    m_lastAccess = itemAccessTime();
+    loadData(format);
+    return m_data.value(format);
+}
+
 QVariant ClipboardItem::data(int role) const
 {
+    m_lastAccess = itemAccessTime();
+
     if (role == Qt::DisplayRole || role == Qt::EditRole) {
-        if ( m_data.contains(mimeText) )
-            return getTextData(m_data);
-        if ( m_data.contains(mimeUriList) )
-            return getTextData(m_data, mimeUriList);
+        if ( loadData(mimeText) )
+            return getTextData( m_data.value(mimeText) );
+        if ( loadData(mimeUriList) )
+            return getTextData( m_data.value(mimeUriList) );
     } else if (role >= Qt::UserRole) {
         if (role == contentType::data) {
-            return m_data; // copy-on-write, so this should be fast
+            loadAllData();
+            return m_data.toMap();
         } else if (role == contentType::hash) {
             return dataHash();
         } else if (role == contentType::hasText) {
-            return m_data.contains(mimeText) || m_data.contains(mimeUriList);
+            return hasFormat(mimeText) || hasFormat(mimeUriList);
         } else if (role == contentType::hasHtml) {
-            return m_data.contains(mimeHtml);
+            return hasFormat(mimeHtml);
         } else if (role == contentType::hasNotes) {
-            return m_data.contains(mimeItemNotes);
+            return hasFormat(mimeItemNotes);
         } else if (role == contentType::text) {
-            return getTextData(m_data);
+            if ( loadData(mimeText) )
+                return getTextData( m_data.value(mimeText) );
+            loadData(mimeUriList);
+            return getTextData( m_data.value(mimeUriList) );
         } else if (role == contentType::html) {
-            return getTextData(m_data, mimeHtml);
+            loadData(mimeHtml);
+            return getTextData( m_data.value(mimeHtml) );
         } else if (role == contentType::notes) {
-            return getTextData(m_data, mimeItemNotes);
+            loadData(mimeItemNotes);
+            return getTextData( m_data.value(mimeItemNotes) );
         } else if (role == contentType::color) {
-            return getTextData(m_data, mimeColor);
+            loadData(mimeColor);
+            return getTextData( m_data.value(mimeColor) );
         } else if (role == contentType::isHidden) {
-            return m_data.contains(mimeHidden);
+            return hasFormat(mimeHidden);
         }
     }
 
     return QVariant();
 }
 
-unsigned int ClipboardItem::dataHash() const
+QVariantMap ClipboardItem::readData() const
 {
-    if (m_hash == 0)
-        m_hash = hash(m_data);
+    QVariantMap data = m_data.toMap();
+    if ( !m_payloads.isEmpty() )
+        loadPayloads(m_payloads, &data);
+    return data;
+}
+
+void ClipboardItem::dataToSave(QVariantMap *data, ItemEncodedFormats *storedData) const
+{
+    *data = m_data.toMap();
+    if ( !m_payloads.isEmpty() && !readEncodedPayloads(m_payloads, storedData) ) {
+        storedData->clear();
+        loadPayloads(m_payloads, data);
+    }
+}
+
+quint64 ClipboardItem::dataHash() const
+{
+    if (m_hash == 0) {
+        // Load only data with unknown hash.
+        for ( const auto &format : m_payloads.keys() ) {
+            if (m_payloads.value(format).hash == 0)
+                loadData(format);
+        }
+
+        m_data.updateFormatHashes();
+        QMap<QString, quint64> formatHashes = m_data.formatHashes();
+        for (auto it = m_payloads.constBegin(); it != m_payloads.constEnd(); ++it)
+            formatHashes.insert( it.key(), it.value().hash );
+
+        m_hash = hashItemFormats(formatHashes);
+    }
 
     return m_hash;
 }
 
+void ClipboardItem::updateDataHashes() const
+{
+    m_data.updateFormatHashes();
+    dataHash();
+}
+
+quint64 ClipboardItem::formatHash(const QString &format) const
+{
+    const auto it = m_payloads.constFind(format);
+    if ( it != m_payloads.constEnd() && it.value().hash != 0 )
+        return it.value().hash;
+
+    loadData(format);
+    return m_data.formatHash(format);
+}
+
+bool ClipboardItem::searchableTexts(QStringList *texts) const
+{
+    if (!m_hasSearchableTexts)
+        return false;
+
+    *texts = m_searchableTexts;
+    return true;
+}
+
+void ClipboardItem::setSearchableTexts(const QStringList &texts) const
+{
+    m_searchableTexts = texts;
+    m_hasSearchableTexts = true;
+}
+
+void ClipboardItem::clearSearchableTexts() const
+{
+    m_searchableTexts.clear();
+    m_hasSearchableTexts = false;
+}
+
 void ClipboardItem::invalidateDataHash()
 {
     m_hash = 0;
+    m_encodedCache = std::make_shared<ItemEncodedCache>();
+    clearSearchableTexts();
+}
+
+qint64 ClipboardItem::residentSize() const
+{
+    return m_data.byteCount() + m_encodedCache->byteCount(m_data);
+}
+
+qint64 ClipboardItem::storedSize() const
+{
+    qint64 result = 0;
+    for (const auto &payload : m_payloads)
+        result += payload.size;
+    return result;
+}
+
+qint64 ClipboardItem::spillData(const ItemPayloadFilePtr &spillPayloadFile, QIODevice *spillFile, bool map)
+{
+    if ( m_data.isEmpty() )
+        return 0;
+
+    // Check that all data are encoded before writing anything.
+    QVector<ItemEncodedFormat> encodedFormats;
+    encodedFormats.reserve( m_data.size() );
+    for (int i = 0; i < m_data.size(); ++i) {
+        ItemEncodedFormat encoded;
+        const QString &format = itemFormatName( m_data.formatIdAt(i) );
+        if ( !m_encodedCache->find(format, &encoded) )
+            return 0;
+        if ( !encoded.payload.blobHash.isEmpty() && !hasBlob(encoded.payload.blobHash) )
+            return 0;
+        encodedFormats.append(encoded);
+    }
+
+    ItemPayloads payloads;
+    for (int i = 0; i < m_data.size(); ++i) {
+        const ItemEncodedFormat &encoded = encodedFormats[i];
+        ItemPayload payload = encoded.payload;
+
+        if ( payload.blobHash.isEmpty() ) {
+            payload.file = spillPayloadFile;
+            payload.offset = spillFile->pos();
+            payload.size = encoded.bytes.size();
+            if ( spillFile->write(encoded.bytes) != encoded.bytes.size() )
+                return 0;
+        } else {
+            payload.file = blobPayloadFile(payload.blobHash, map);
+        }
+
+        payload.hash = m_data.formatHashAt(i);
+        payloads.insert( itemFormatName(m_data.formatIdAt(i)), payload );
+    }
+
+    const qint64 releasedSize = residentSize();
+
+    for (auto it = payloads.constBegin(); it != payloads.constEnd(); ++it)
+        m_payloads.insert( it.key(), it.value() );
+
+    // Keep only references to blob files in cache so the data don't need to be
+    // loaded and encoded again when saving.
+    m_encodedCache = std::make_shared<ItemEncodedCache>();
+    for (int i = 0; i < encodedFormats.size(); ++i) {
+        if ( !encodedFormats[i].payload.blobHash.isEmpty() )
+            m_encodedCache->insert( itemFormatName(m_data.formatIdAt(i)), encodedFormats[i] );
+    }
+    encodedFormats.clear();
+
+    QVector<QByteArray> sharedBytes;
+    for (int i = 0; i < m_data.size(); ++i) {
+        if ( m_data.bytesAt(i).size() >= minBlobSize )
+            sharedBytes.append( m_data.bytesAt(i) );
+    }
+    m_data.clear();
+
+    for (auto &bytes : sharedBytes)
+        releaseBlob(&bytes);
+
+    return releasedSize;
+}
+
+bool ClipboardItem::hasFormat(const QString &format) const
+{
+    return m_data.contains(format) || m_payloads.contains(format);
+}
+
+bool ClipboardItem::loadData(const QString &format) const
+{
+    if ( m_data.contains(format) )
+        return true;
+
+    const auto it = m_payloads.find(format);
+    if ( it == m_payloads.end() )
+        return false;
+
+    ItemPayloads payloads;
+    payloads.insert( it.key(), it.value() );
+    m_payloads.erase(it);
+
+    if ( !loadPayloadData(payloads) ) {
+        // Hash no longer matches the data.
+        m_hash = 0;
+        return false;
+    }
+
+    return true;
+}
+
+void ClipboardItem::loadAllData() const
+{
+    if ( m_payloads.isEmpty() )
+        return;
+
+    if ( !loadPayloadData(m_payloads) )
+        m_hash = 0;
+
+    m_payloads.clear();
+}
+
+bool ClipboardItem::loadPayloadData(const ItemPayloads &payloads) const
+{
+    QVariantMap data;
+    const bool loaded = loadPayloads(payloads, &data, m_encodedCache.get());
+
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it)
+        m_data.insert( it.key(), it.value().toByteArray(), payloads.value(it.key()).hash );
+
+    return loaded;
+}
+
+qint64 itemAccessTime()
+{
+    static const QElapsedTimer timer = startedTimer();
+    return timer.elapsed();
 }
@@ -20,6 +20,10 @@
 #ifndef CLIPBOARDITEM_H
 #define CLIPBOARDITEM_H
 
+#include "item/itemdata.h"
+#include "item/itempayload.h"
+
+#include <QStringList>
 #include <QVariant>
 
 class QByteArray;
@@ -30,6 +34,9 @@ class QString;
  *
  * Clipboard item stores data of different MIME types and has single default
  * MIME type for displaying the contents.
+ *
+ * Data are stored in compact form (see ItemData) and converted to QVariantMap
+ * only when requested with contentType::data role.
  */
 class ClipboardItem
 {
@@ -66,20 +73,114 @@ public:
     /** Remove item's MIME type data. */
     bool removeData(const QStringList &mimeTypeList);
 
+    /**
+     * Set formats with data to load from file when requested.
+     * @a hash is hash of all the data (see dataHash()) or 0 if unknown.
+     */
+    void setPayloads(const ItemPayloads &payloads, quint64 hash);
+
     /** Return data for given @a role. */
     QVariant data(int role) const;
 
     /** Return data for format. */
-    QByteArray data(const QString &format) const { return m_data.value(format).toByteArray(); }
+    QByteArray data(const QString &format) const;
+
+    /** Return all data; data not loaded yet are read from file but not kept in item. */
+    QVariantMap readData() const;
+
+    /**
+     * Return loaded data in @a data and data not loaded yet as stored in file
+     * in @a storedData (these are neither decoded nor kept in item).
+     */
+    void dataToSave(QVariantMap *data, ItemEncodedFormats *storedData) const;
+
+    /**
+     * Return hash for item's data.
+     *
+     * Data are not loaded from file if hashes of their formats are known.
+     */
+    quint64 dataHash() const;
+
+    /**
+     * Compute and cache hashes of item data and of each format.
+     *
+     * Call this before the item is copied for other thread so the copy
+     * doesn't compute the hashes again.
+     */
+    void updateDataHashes() const;
+
+    /** Return hash of data for format (see hashFormatData()) or 0 if format is missing. */
+    quint64 formatHash(const QString &format) const;
+
+    /** Return encoded data from last save (valid until data change). */
+    const ItemEncodedCachePtr &encodedCache() const { return m_encodedCache; }
 
-    /** Return hash for item's data. */
-    unsigned int dataHash() const;
+    /**
+     * Return cached texts to search in (see setSearchableTexts()).
+     * @return false if texts are not cached
+     */
+    bool searchableTexts(QStringList *texts) const;
+
+    /** Cache texts to search in until data change. */
+    void setSearchableTexts(const QStringList &texts) const;
+
+    void clearSearchableTexts() const;
+
+    /** Return size of data loaded in memory (including encoded data cached for saving). */
+    qint64 residentSize() const;
+
+    /** Return size of data stored in files and not loaded yet. */
+    qint64 storedSize() const;
+
+    /** Return time of last access to the data (see itemAccessTime()). */
+    qint64 lastAccess() const { return m_lastAccess; }
+
+    /**
+     * Move loaded data to file so these are not kept in memory.
+     *
+     * Data are loaded again when requested.
+     *
+     * Only data already encoded for saving (see encodedCache()) are moved.
+     * Data saved in blob files are not written to @a spillFile, only the blob
+     * file is referenced. Encoded data are dropped from the cache and shared
+     * data no longer used by other items are released from memory.
+     *
+     * @param spillPayloadFile  payload file for @a spillFile (must be temporary)
+     * @param spillFile         file opened for writing at the end
+     * @param map               map blob files (see ItemPayloadFile)
+     *
+     * @return size of released data
+     */
+    qint64 spillData(const ItemPayloadFilePtr &spillPayloadFile, QIODevice *spillFile, bool map);
 
 private:
     void invalidateDataHash();
 
-    QVariantMap m_data;
-    mutable unsigned int m_hash;
+    /** Return true if item has @a format. */
+    bool hasFormat(const QString &format) const;
+
+    /**
+     * Load data for @a format from file if not yet loaded.
+     * @return true if item has @a format
+     */
+    bool loadData(const QString &format) const;
+
+    /** Load data for all formats from file. */
+    void loadAllData() const;
+
+    /** Load data from file and add them to item data. */
+    bool loadPayloadData(const ItemPayloads &payloads) const;
+
+    mutable ItemData m_data;
+    mutable ItemPayloads m_payloads;
+    mutable quint64 m_hash;
+    ItemEncodedCachePtr m_encodedCache;
+    mutable QStringList m_searchableTexts;
+    mutable bool m_hasSearchableTexts;
+    mutable qint64 m_lastAccess;
 };
 
+/** Return monotonic time in milliseconds for least recently used items. */
+qint64 itemAccessTime();
+
 #endif // CLIPBOARDITEM_H
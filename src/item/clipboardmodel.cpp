@@ -19,16 +19,46 @@
 
 #include "clipboardmodel.h"
 
+#include "common/common.h"
 #include "common/contenttype.h"
+#include "common/log.h"
 #include "common/mimetypes.h"
 
+#include <QDir>
 #include <QStringList>
+#include <QTemporaryFile>
 
 #include <algorithm>
 #include <functional>
+#include <utility>
+#include <vector>
 
 namespace {
 
+/// Delay for checking memory usage after items are accessed or changed.
+const int releaseMemoryDelayMs = 5000;
+
+
+/// Spill file smaller than this is not replaced with new one.
+const qint64 minSpillFileSizeToReplace = 64 * 1024 * 1024;
+
+/// Searchable texts of bigger items are not cached to keep memory usage low.
+const int maxCachedSearchableTextsLength = 256 * 1024;
+
+/// Models with memory limit (all in main thread).
+QList<ClipboardModel*> memoryManagedModels;
+
+qint64 totalMemoryLimit = 0;
+
+/// Don't move data of recently accessed items to spill file.
+qint64 minIdleTimeToSpillMs = 10000;
+
+struct SpillCandidate {
+    qint64 lastAccess;
+    ClipboardModel *model;
+    int row;
+};
+
 QList<QPersistentModelIndex> validIndeces(const QModelIndexList &indexList)
 {
     QList<QPersistentModelIndex> list;
@@ -52,28 +82,95 @@ int topMostRow(const QList<QPersistentModelIndex> &indexList)
     return row;
 }
 
+/**
+ * Change item data for given role.
+ * @return true if data were changed
+ */
+bool setItemData(ClipboardItem *item, const QVariant &value, int role)
+{
+    if (role == Qt::EditRole) {
+        item->setText(value.toString());
+        return true;
+    }
+
+    if (role == contentType::notes) {
+        const QString notes = value.toString();
+        if ( notes.isEmpty() )
+            item->removeData(mimeItemNotes);
+        else
+            item->setData( mimeItemNotes, notes.toUtf8() );
+        return true;
+    }
+
+    if (role == contentType::updateData)
+        return item->updateData(value.toMap());
+
+    if (role == contentType::data)
+        return item->setData(value.toMap());
+
+    if (role >= contentType::removeFormats)
+        return item->removeData(value.toStringList());
+
+    return false;
+}
+
 } // namespace
 
-void ClipboardItemList::move(int from, int count, int to)
+void ClipboardItemList::move(int from, int to)
 {
-    if (to < from) {
-        std::swap(from, to);
-        ++to;
+    // Removing and inserting shifts fewer items than rotating if the item is
+    // moved far (e.g. to the top from the bottom).
+    const int distance = qAbs(to - from);
+    const int shifted = qMin(from, size() - from) + qMin(to, size() - to);
+    if (distance <= shifted) {
+        if (from < to)
+            move(from, 1, to + 1);
+        else
+            move(from, 1, to);
+        return;
     }
 
+    ClipboardItem item = std::move(m_items[from]);
+    m_items.erase( m_items.begin() + from );
+    m_items.insert( m_items.begin() + to, std::move(item) );
+}
+
+void ClipboardItemList::move(int from, int count, int to)
+{
     const auto start = std::begin(m_items) + from;
     const auto end = start + count;
     const auto dest = std::begin(m_items) + to;
-    std::rotate(start, end, dest);
+
+    if (from < to)
+        std::rotate(start, end, dest);
+    else
+        std::rotate(dest, start, end);
 }
 
 ClipboardModel::ClipboardModel(QObject *parent)
     : QAbstractListModel(parent)
     , m_max(100)
-    , m_clipboardList(m_max)
+    , m_clipboardList()
     , m_disabled(false)
+    , m_mapItemData(false)
     , m_tabName()
+    , m_rowKeys()
+    , m_rowKeyOffset(0)
+    , m_memoryLimit(0)
+    , m_memoryManaged(false)
+    , m_timerReleaseMemory()
+    , m_spillFile()
+    , m_spillPayloadFile()
+    , m_searchableTexts()
+{
+    initSingleShotTimer( &m_timerReleaseMemory, releaseMemoryDelayMs, this, SLOT(releaseMemory()) );
+}
+
+ClipboardModel::~ClipboardModel()
 {
+    // Models for saving items in other thread are never registered.
+    if (m_memoryManaged)
+        memoryManagedModels.removeOne(this);
 }
 
 int ClipboardModel::rowCount(const QModelIndex&) const
@@ -86,6 +183,11 @@ QVariant ClipboardModel::data(const QModelIndex &index, int role) const
     if (!index.isValid() || index.row() >= m_clipboardList.size())
         return QVariant();
 
+    scheduleReleaseMemory();
+
+    if (role == contentType::searchableTexts)
+        return searchableTexts(index);
+
     return m_clipboardList[index.row()].data(role);
 }
 
@@ -102,30 +204,16 @@ bool ClipboardModel::setData(const QModelIndex &index, const QVariant &value, in
     if ( !index.isValid() )
         return false;
 
-    int row = index.row();
+    const int row = index.row();
 
-    if (role == Qt::EditRole) {
-        m_clipboardList[row].setText(value.toString());
-    } else if (role == contentType::notes) {
-        const QString notes = value.toString();
-        if ( notes.isEmpty() )
-            m_clipboardList[row].removeData(mimeItemNotes);
-        else
-            m_clipboardList[row].setData( mimeItemNotes, notes.toUtf8() );
-    } else if (role == contentType::updateData) {
-        if ( !m_clipboardList[row].updateData(value.toMap()) )
-            return false;
-    } else if (role == contentType::data) {
-        ClipboardItem &item = m_clipboardList[row];
-        const QVariantMap dataMap = value.toMap();
-        if ( !item.setData(dataMap) )
-            return false;
-    } else if (role >= contentType::removeFormats) {
-        if ( !m_clipboardList[row].removeData(value.toStringList()) )
-            return false;
-    } else {
+    unindexRows(row, row);
+    const bool changed = setItemData(&m_clipboardList[row], value, role);
+    indexRows(row, row);
+
+    if (!changed)
         return false;
-    }
+
+    scheduleReleaseMemory();
 
     emit dataChanged(index, index);
 
@@ -137,11 +225,122 @@ void ClipboardModel::insertItem(const QVariantMap &data, int row)
     ClipboardItem item;
     item.setData(data);
 
-    beginInsertRows(QModelIndex(), row, row);
+    beginInsertItems(row, 1);
 
     m_clipboardList.insert(row, item);
 
-    endInsertRows();
+    endInsertItems(row, 1);
+}
+
+void ClipboardModel::insertItems(const QVector<QVariantMap> &dataList, int row)
+{
+    if ( dataList.isEmpty() )
+        return;
+
+    beginInsertItems( row, dataList.size() );
+
+    for (int i = 0; i < dataList.size(); ++i) {
+        ClipboardItem item;
+        item.setData(dataList[i]);
+        m_clipboardList.insert(row + i, item);
+    }
+
+    endInsertItems( row, dataList.size() );
+}
+
+void ClipboardModel::insertItems(const QVector<ClipboardItem> &items, int row)
+{
+    if ( items.isEmpty() )
+        return;
+
+    beginInsertItems( row, items.size() );
+
+    for (int i = 0; i < items.size(); ++i)
+        m_clipboardList.insert(row + i, items[i]);
+
+    endInsertItems( row, items.size() );
+}
+
+void ClipboardModel::removeItems(const QList<int> &rows)
+{
+    QList<int> sortedRows = rows;
+    std::sort( sortedRows.begin(), sortedRows.end(), std::greater<int>() );
+    sortedRows.erase( std::unique(sortedRows.begin(), sortedRows.end()), sortedRows.end() );
+
+    // Remove ranges from the end so rows before them don't change.
+    for (int i = 0; i < sortedRows.size(); ) {
+        const int last = sortedRows[i];
+        int first = last;
+        for (++i; i < sortedRows.size() && sortedRows[i] == first - 1; ++i)
+            first = sortedRows[i];
+
+        removeRows(first, last - first + 1);
+    }
+}
+
+int ClipboardModel::setItemsData(const QMap<int, QVariantMap> &dataMap)
+{
+    int changedCount = 0;
+    int firstChanged = rowCount();
+    int lastChanged = -1;
+
+    for (auto it = dataMap.constBegin(); it != dataMap.constEnd(); ++it) {
+        const int row = it.key();
+        if ( row < 0 || row >= rowCount() )
+            continue;
+
+        unindexRows(row, row);
+        const bool changed = m_clipboardList[row].setData( it.value() );
+        indexRows(row, row);
+
+        if (changed) {
+            ++changedCount;
+            firstChanged = qMin(firstChanged, row);
+            lastChanged = qMax(lastChanged, row);
+        }
+    }
+
+    if (changedCount > 0) {
+        scheduleReleaseMemory();
+        emit dataChanged( index(firstChanged), index(lastChanged) );
+    }
+
+    return changedCount;
+}
+
+QVector<ClipboardItem> ClipboardModel::items() const
+{
+    QVector<ClipboardItem> items;
+    items.reserve( m_clipboardList.size() );
+
+    for (int row = 0; row < m_clipboardList.size(); ++row) {
+        const ClipboardItem &item = m_clipboardList[row];
+        // Copies share cached hashes of data so these are computed before data are shared.
+        item.updateDataHashes();
+        items.append(item);
+    }
+
+    return items;
+}
+
+QVariantMap ClipboardModel::readItemData(int row) const
+{
+    return m_clipboardList[row].readData();
+}
+
+void ClipboardModel::dataToSave(int row, QVariantMap *data, ItemEncodedFormats *storedData) const
+{
+    m_clipboardList[row].dataToSave(data, storedData);
+}
+
+ItemEncodedCachePtr ClipboardModel::encodedCache(int row) const
+{
+    return m_clipboardList[row].encodedCache();
+}
+
+quint64 ClipboardModel::formatHash(int row, const QString &format) const
+{
+    return m_clipboardList[row].formatHash(format);
 }
 
 bool ClipboardModel::insertRows(int position, int rows, const QModelIndex&)
@@ -149,12 +348,12 @@ bool ClipboardModel::insertRows(int position, int rows, const QModelIndex&)
     if ( rows <= 0 || position < 0 )
         return false;
 
-    beginInsertRows(QModelIndex(), position, position + rows - 1);
+    beginInsertItems(position, rows);
 
     for (int row = 0; row < rows; ++row)
         m_clipboardList.insert(position, ClipboardItem());
 
-    endInsertRows();
+    endInsertItems(position, rows);
 
     return true;
 }
@@ -166,11 +365,15 @@ bool ClipboardModel::removeRows(int position, int rows, const QModelIndex&)
 
     int last = qMin( position + rows, rowCount() ) - 1;
 
-    beginRemoveRows(QModelIndex(), position, last);
+    const int count = last - position + 1;
+    beginRemoveItems(position, count);
 
-    m_clipboardList.remove(position, last - position + 1);
+    m_clipboardList.remove(position, count);
 
-    endRemoveRows();
+    endRemoveItems(position, count);
+
+    // Removed items could be the last ones referencing data in mapped files.
+    ItemPayloadFile::releaseUnusedMappings();
 
     return true;
 }
@@ -190,7 +393,13 @@ bool ClipboardModel::moveRows(
         return false;
 
     beginMoveRows(sourceParent, sourceRow, last, destinationParent, destinationRow);
+
+    const int firstMoved = qMin(sourceRow, destinationRow);
+    const int lastMoved = qMax(last, destinationRow - 1);
+    unindexRows(firstMoved, lastMoved);
     m_clipboardList.move(sourceRow, rows, destinationRow);
+    indexRows(firstMoved, lastMoved);
+
     endMoveRows();
 
     return true;
@@ -215,6 +424,126 @@ void ClipboardModel::unloadItems()
 {
     emit unloaded();
     removeRows(0, rowCount());
+    closeSpillFile();
+    updateMemoryUsage();
+}
+
+void ClipboardModel::setMemoryLimit(qint64 bytes)
+{
+    m_memoryLimit = qMax(Q_INT64_C(0), bytes);
+
+    if (!m_memoryManaged) {
+        m_memoryManaged = true;
+        memoryManagedModels.append(this);
+    }
+
+    scheduleReleaseMemory();
+}
+
+void ClipboardModel::setTotalMemoryLimit(qint64 bytes)
+{
+    totalMemoryLimit = qMax(Q_INT64_C(0), bytes);
+
+    for (auto model : memoryManagedModels)
+        model->scheduleReleaseMemory();
+}
+
+void ClipboardModel::setMinIdleTimeToSpill(qint64 ms)
+{
+    minIdleTimeToSpillMs = qMax(Q_INT64_C(0), ms);
+}
+
+void ClipboardModel::setSearchableTextsFunction(const SearchableTextsFunction &searchableTexts)
+{
+    m_searchableTexts = searchableTexts;
+    invalidateSearchableTexts();
+}
+
+QVector<QStringList> ClipboardModel::searchableTexts(const QVector<int> &rows) const
+{
+    QVector<QStringList> texts;
+    if (!m_searchableTexts)
+        return QVector<QStringList>(rows.size());
+
+    texts.reserve( rows.size() );
+    for (int row : rows)
+        texts.append( searchableTexts(row) );
+
+    scheduleReleaseMemory();
+
+    return texts;
+}
+
+void ClipboardModel::invalidateSearchableTexts()
+{
+    for (int row = 0; row < m_clipboardList.size(); ++row)
+        m_clipboardList[row].clearSearchableTexts();
+}
+
+void ClipboardModel::memoryUsage(qint64 *residentBytes, qint64 *storedBytes) const
+{
+    *residentBytes = 0;
+    *storedBytes = 0;
+
+    for (int row = 0; row < m_clipboardList.size(); ++row) {
+        const ClipboardItem &item = m_clipboardList[row];
+        *residentBytes += item.residentSize();
+        *storedBytes += item.storedSize();
+    }
+}
+
+void ClipboardModel::totalMemoryUsage(qint64 *residentBytes, qint64 *storedBytes)
+{
+    *residentBytes = 0;
+    *storedBytes = 0;
+
+    for (auto model : memoryManagedModels) {
+        qint64 modelResidentBytes;
+        qint64 modelStoredBytes;
+        model->memoryUsage(&modelResidentBytes, &modelStoredBytes);
+        *residentBytes += modelResidentBytes;
+        *storedBytes += modelStoredBytes;
+    }
+}
+
+void ClipboardModel::releaseMemory()
+{
+    qint64 residentBytes;
+    qint64 storedBytes;
+    memoryUsage(&residentBytes, &storedBytes);
+
+    // Replace spill file if most of the data in it are no longer used.
+    if ( m_spillFile.isOpen() && m_spillFile.size() > qMax(minSpillFileSizeToReplace, 2 * storedBytes) )
+        closeSpillFile();
+
+    QList<ClipboardModel*> changedModels;
+
+    if (m_memoryLimit > 0 && residentBytes > m_memoryLimit) {
+        const QList<ClipboardModel*> models = QList<ClipboardModel*>() << this;
+        if ( spillLeastRecentlyUsed(models, residentBytes - m_memoryLimit) > 0 )
+            changedModels = models;
+    }
+
+    if (totalMemoryLimit > 0 && m_memoryManaged) {
+        qint64 totalResidentBytes;
+        qint64 totalStoredBytes;
+        totalMemoryUsage(&totalResidentBytes, &totalStoredBytes);
+
+        if (totalResidentBytes > totalMemoryLimit
+                && spillLeastRecentlyUsed(memoryManagedModels, totalResidentBytes - totalMemoryLimit) > 0)
+        {
+            changedModels = memoryManagedModels;
+        }
+    }
+
+    if ( !changedModels.contains(this) )
+        changedModels.append(this);
+
+    for (auto model : changedModels)
+        model->updateMemoryUsage();
+
+    // Data referencing mapped files could have been released or moved to spill file.
+    ItemPayloadFile::releaseUnusedMappings();
 }
 
 void ClipboardModel::setMaxItems(int max)
@@ -222,11 +551,11 @@ void ClipboardModel::setMaxItems(int max)
     m_max = qMax(0, max);
 
     if ( m_max < m_clipboardList.size() ) {
-        beginRemoveRows(QModelIndex(), m_max + 1, m_clipboardList.size() - 1);
+        const int count = m_clipboardList.size() - m_max;
+        beginRemoveItems(m_max, count);
         m_clipboardList.resize(m_max);
-        endRemoveRows();
-    } else {
-        m_clipboardList.reserve(m_max);
+        endRemoveItems(m_max, count);
+        ItemPayloadFile::releaseUnusedMappings();
     }
 }
 
@@ -257,7 +586,7 @@ bool ClipboardModel::move(int pos, int newpos)
     if ( !beginMoveRows(QModelIndex(), from, from, QModelIndex(), to) )
         return false;
 
-    m_clipboardList.move(sourceRow, targetRow);
+    moveItem(sourceRow, targetRow);
 
     endMoveRows();
 
@@ -322,7 +651,7 @@ void ClipboardModel::sortItems(const QModelIndexList &indexList, CompareItems *c
 
             if (targetRow != sourceRow) {
                 beginMoveRows(QModelIndex(), sourceRow, sourceRow, QModelIndex(), targetRow);
-                m_clipboardList.move(sourceRow, targetRow);
+                moveItem(sourceRow, targetRow);
                 endMoveRows();
 
                 // If the moved item was removed or moved further (as reaction on moving the item),
@@ -336,12 +665,223 @@ void ClipboardModel::sortItems(const QModelIndexList &indexList, CompareItems *c
     }
 }
 
-int ClipboardModel::findItem(uint item_hash) const
+int ClipboardModel::findItem(quint64 item_hash) const
+{
+    int foundRow = -1;
+
+    // Check found rows since item hash can change if its data fail to load.
+    for ( auto it = m_rowKeys.constFind(item_hash);
+          it != m_rowKeys.constEnd() && it.key() == item_hash; ++it )
+    {
+        const int row = it.value() - m_rowKeyOffset;
+        if ( (foundRow == -1 || row < foundRow)
+             && row >= 0 && row < m_clipboardList.size()
+             && m_clipboardList[row].dataHash() == item_hash )
+        {
+            foundRow = row;
+        }
+    }
+
+    return foundRow;
+}
+
+QVariant ClipboardModel::searchableTexts(const QModelIndex &index) const
+{
+    if (!m_searchableTexts)
+        return QVariant();
+
+    return searchableTexts( index.row() );
+}
+
+QStringList ClipboardModel::searchableTexts(int row) const
+{
+    const ClipboardItem &item = m_clipboardList[row];
+
+    QStringList texts;
+    if ( item.searchableTexts(&texts) )
+        return texts;
+
+    texts = m_searchableTexts( index(row) );
+
+    int length = 0;
+    for (const auto &text : texts)
+        length += text.size();
+
+    if (length <= maxCachedSearchableTextsLength)
+        item.setSearchableTexts(texts);
+
+    return texts;
+}
+
+void ClipboardModel::scheduleReleaseMemory() const
+{
+    if ( m_memoryManaged && !m_timerReleaseMemory.isActive() )
+        m_timerReleaseMemory.start();
+}
+
+void ClipboardModel::updateMemoryUsage()
+{
+    qint64 residentBytes;
+    qint64 storedBytes;
+    memoryUsage(&residentBytes, &storedBytes);
+    emit memoryUsageChanged(residentBytes, storedBytes);
+}
+
+bool ClipboardModel::openSpillFile()
+{
+    if ( m_spillFile.isOpen() )
+        return true;
+
+    QTemporaryFile tmpFile( QDir::temp().absoluteFilePath("copyq-spill-XXXXXX") );
+    tmpFile.setAutoRemove(false);
+    if ( !tmpFile.open() ) {
+        log( QString("Failed to create file for item data: %1").arg(tmpFile.errorString()), LogError );
+        return false;
+    }
+    tmpFile.close();
+
+    m_spillFile.setFileName( tmpFile.fileName() );
+    if ( !m_spillFile.open(QIODevice::WriteOnly) ) {
+        log( QString("Failed to open file for item data \"%1\": %2")
+             .arg(m_spillFile.fileName(), m_spillFile.errorString()), LogError );
+        QFile::remove( m_spillFile.fileName() );
+        return false;
+    }
+
+    COPYQ_LOG( QString("Tab \"%1\": Moving item data to \"%2\"")
+               .arg(m_tabName, m_spillFile.fileName()) );
+
+    // The file is removed after all items using it are removed or changed.
+    m_spillPayloadFile = std::make_shared<ItemPayloadFile>( m_spillFile.fileName() );
+    m_spillPayloadFile->setTemporary();
+
+    return true;
+}
+
+void ClipboardModel::closeSpillFile()
+{
+    m_spillFile.close();
+    m_spillPayloadFile.reset();
+}
+
+qint64 ClipboardModel::spillItem(int row)
+{
+    if ( !openSpillFile() )
+        return 0;
+
+    const qint64 releasedBytes =
+            m_clipboardList[row].spillData(m_spillPayloadFile, &m_spillFile, m_mapItemData);
+
+    // Data are read using other file handle.
+    if ( !m_spillFile.flush() ) {
+        log( QString("Failed to write item data \"%1\": %2")
+             .arg(m_spillFile.fileName(), m_spillFile.errorString()), LogError );
+        closeSpillFile();
+    }
+
+    return releasedBytes;
+}
+
+qint64 ClipboardModel::spillLeastRecentlyUsed(const QList<ClipboardModel*> &models, qint64 bytesToRelease)
+{
+    const qint64 now = itemAccessTime();
+
+    std::vector<SpillCandidate> candidates;
+    for (auto model : models) {
+        for (int row = 0; row < model->m_clipboardList.size(); ++row) {
+            const ClipboardItem &item = model->m_clipboardList[row];
+            if ( item.residentSize() > 0 && now - item.lastAccess() >= minIdleTimeToSpillMs )
+                candidates.push_back( SpillCandidate{item.lastAccess(), model, row} );
+        }
+    }
+
+    std::sort( candidates.begin(), candidates.end(),
+               [](const SpillCandidate &lhs, const SpillCandidate &rhs) {
+                   return lhs.lastAccess < rhs.lastAccess;
+               } );
+
+    qint64 releasedBytes = 0;
+    for (const auto &candidate : candidates) {
+        if (releasedBytes >= bytesToRelease)
+            break;
+        releasedBytes += candidate.model->spillItem(candidate.row);
+    }
+
+    COPYQ_LOG( QString("Released %1 KiB of item data").arg(releasedBytes / 1024) );
+
+    return releasedBytes;
+}
+
+void ClipboardModel::indexRows(int first, int last)
 {
-    for (int i = 0; i < m_clipboardList.size(); ++i) {
-        if ( m_clipboardList[i].dataHash() == item_hash )
-            return i;
+    for (int row = first; row <= last; ++row)
+        m_rowKeys.insert( m_clipboardList[row].dataHash(), row + m_rowKeyOffset );
+}
+
+void ClipboardModel::unindexRows(int first, int last)
+{
+    for (int row = first; row <= last; ++row)
+        m_rowKeys.remove( m_clipboardList[row].dataHash(), row + m_rowKeyOffset );
+}
+
+void ClipboardModel::beginInsertItems(int row, int count)
+{
+    beginInsertRows(QModelIndex(), row, row + count - 1);
+
+    // Only rows before or after new items need new keys, whichever are fewer.
+    if ( row < m_clipboardList.size() - row )
+        unindexRows(0, row - 1);
+    else
+        unindexRows(row, m_clipboardList.size() - 1);
+}
+
+void ClipboardModel::endInsertItems(int row, int count)
+{
+    const int oldSize = m_clipboardList.size() - count;
+    if (row < oldSize - row) {
+        m_rowKeyOffset -= count;
+        indexRows(0, row + count - 1);
+    } else {
+        indexRows(row, m_clipboardList.size() - 1);
     }
 
-    return -1;
+    endInsertRows();
+
+    scheduleReleaseMemory();
+}
+
+void ClipboardModel::beginRemoveItems(int row, int count)
+{
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+
+    if ( count == m_clipboardList.size() ) {
+        m_rowKeys.clear();
+        m_rowKeyOffset = 0;
+    } else if ( row < m_clipboardList.size() - row - count ) {
+        unindexRows(0, row + count - 1);
+    } else {
+        unindexRows(row, m_clipboardList.size() - 1);
+    }
+}
+
+void ClipboardModel::endRemoveItems(int row, int count)
+{
+    const int oldSize = m_clipboardList.size() + count;
+    if (row < oldSize - row - count) {
+        m_rowKeyOffset += count;
+        indexRows(0, row - 1);
+    } else {
+        indexRows(row, m_clipboardList.size() - 1);
+    }
+
+    endRemoveRows();
+}
+
+void ClipboardModel::moveItem(int from, int to)
+{
+    const int first = qMin(from, to);
+    const int last = qMax(from, to);
+    unindexRows(first, last);
+    m_clipboardList.move(from, to);
+    indexRows(first, last);
 }
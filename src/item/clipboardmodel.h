@@ -23,20 +23,26 @@
 #include "item/clipboarditem.h"
 
 #include <QAbstractListModel>
+#include <QFile>
+#include <QHash>
 #include <QList>
+#include <QMap>
+#include <QTimer>
+#include <QVector>
+
+#include <deque>
+#include <functional>
 
 /**
  * Container with clipboard items.
  *
- * Item prepending is optimized.
+ * Items are stored in chunks (std::deque) so adding items to the top and
+ * removing them from the bottom is fast and memory grows with number of items.
+ * Inserting or removing other items shifts only items before or after them
+ * (whichever are fewer).
  */
 class ClipboardItemList {
 public:
-    explicit ClipboardItemList(int maxItems)
-    {
-        reserve(maxItems);
-    }
-
     ClipboardItem &operator [](int i)
     {
         return m_items[i];
@@ -49,46 +55,31 @@ public:
 
     void insert(int row, const ClipboardItem &item)
     {
-        m_items.insert(row, item);
+        m_items.insert(m_items.begin() + row, item);
     }
 
     void remove(int row, int count)
     {
-        const QList<ClipboardItem>::iterator from = m_items.begin() + row;
-        const QList<ClipboardItem>::iterator to = from + count;
-        m_items.erase(from, to);
+        const auto from = m_items.begin() + row;
+        m_items.erase(from, from + count);
     }
 
     int size() const
     {
-        return m_items.size();
+        return static_cast<int>( m_items.size() );
     }
 
-    void move(int from, int to)
-    {
-        const ClipboardItem item = m_items[from];
-        m_items.removeAt(from);
-        m_items.insert(to, item);
-    }
+    void move(int from, int to);
 
     void move(int from, int count, int to);
 
-    void reserve(int maxItems)
-    {
-        m_items.reserve(maxItems);
-    }
-
     void resize(int size)
     {
-        if (size < this->size())
-            remove(size, this->size());
-
-        while (size > this->size())
-            m_items.append(ClipboardItem());
+        m_items.resize(size);
     }
 
 private:
-    QList<ClipboardItem> m_items;
+    std::deque<ClipboardItem> m_items;
 };
 
 /**
@@ -104,14 +95,19 @@ class ClipboardModel : public QAbstractListModel
     Q_OBJECT
     Q_PROPERTY(int maxItems READ maxItems WRITE setMaxItems)
     Q_PROPERTY(bool disabled READ isDisabled WRITE setDisabled)
+    Q_PROPERTY(bool mapItemData READ mapItemData WRITE setMapItemData)
     Q_PROPERTY(QString tabName READ tabName WRITE setTabName NOTIFY tabNameChanged)
 
 public:
     /** Return true if @a lhs is less than @a rhs. */
     typedef bool CompareItems(const QModelIndex &lhs, const QModelIndex &rhs);
 
+    using SearchableTextsFunction = std::function<QStringList (const QModelIndex &)>;
+
     explicit ClipboardModel(QObject *parent = nullptr);
 
+    ~ClipboardModel();
+
     /** Return number of items in model. */
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
@@ -138,6 +134,51 @@ public:
     /** insert new item to model. */
     void insertItem(const QVariantMap &data, int row);
 
+    /** Insert new items to model at once. */
+    void insertItems(const QVector<QVariantMap> &dataList, int row);
+
+    /** Insert copies of items to model at once. */
+    void insertItems(const QVector<ClipboardItem> &items, int row);
+
+    /**
+     * Remove items in given rows.
+     *
+     * Consecutive rows are removed at once (single notification for each range).
+     */
+    void removeItems(const QList<int> &rows);
+
+    /**
+     * Set data for items in rows (map keys) at once.
+     *
+     * Emits dataChanged() only once for range with all changed rows.
+     *
+     * @return number of changed items
+     */
+    int setItemsData(const QMap<int, QVariantMap> &dataMap);
+
+    /**
+     * Return copies of all items.
+     *
+     * This is fast since data are implicitly shared. Data not loaded yet are
+     * loaded by copies from the same files (these are kept until no longer used).
+     */
+    QVector<ClipboardItem> items() const;
+
+    /**
+     * Return all data of item without keeping data loaded from tab file in memory.
+     * @see ClipboardItem::readData()
+     */
+    QVariantMap readItemData(int row) const;
+
+    /** Return data of item to save in tab file (see ClipboardItem::dataToSave()). */
+    void dataToSave(int row, QVariantMap *data, ItemEncodedFormats *storedData) const;
+
+    /** Return encoded data of item from last save (see ClipboardItem::encodedCache()). */
+    ItemEncodedCachePtr encodedCache(int row) const;
+
+    /** Return cached hash of item data in given format (see ClipboardItem::formatHash()). */
+    quint64 formatHash(int row, const QString &format) const;
+
     /**
      * Set maximum number of items in model.
      *
@@ -154,6 +195,14 @@ public:
 
     void setDisabled(bool disabled) { m_disabled = disabled; }
 
+    /**
+     * Map uncompressed item data from tab file into memory when loading items
+     * instead of reading them.
+     */
+    bool mapItemData() const { return m_mapItemData; }
+
+    void setMapItemData(bool map) { m_mapItemData = map; }
+
     /** Tab name associated with model. */
     const QString &tabName() const { return m_tabName; }
 
@@ -186,10 +235,13 @@ public:
     void sortItems(const QModelIndexList &indexList, CompareItems *compare);
 
     /**
-     * Find item with given @a hash.
+     * Find first item with given @a hash.
+     *
+     * This is fast even for many items since model keeps index of item hashes.
+     *
      * @return Row number with found item or -1 if no item was found.
      */
-    int findItem(uint hash) const;
+    int findItem(quint64 hash) const;
 
     /**
      * Return row index for given @a row.
@@ -205,21 +257,130 @@ public:
     /** Emit unloaded() and unload (remove) all items. */
     void unloadItems();
 
+    /**
+     * Set maximum size of item data kept in memory (0 for no limit).
+     *
+     * Data of least recently used items over the limit are moved to spill
+     * file and loaded again when needed (see releaseMemory()).
+     *
+     * Model with memory limit (even zero) is also checked for total memory limit.
+     */
+    void setMemoryLimit(qint64 bytes);
+
+    /** Set maximum size of item data in memory for all models with memory limit. */
+    static void setTotalMemoryLimit(qint64 bytes);
+
+    /** Set time after last access to item when its data can be moved to spill file. */
+    static void setMinIdleTimeToSpill(qint64 ms);
+
+    /**
+     * Set function returning texts to search in item (decoded text, notes, tags etc.).
+     *
+     * Texts are returned for contentType::searchableTexts role and cached in
+     * the item until its data change so filtering items doesn't need to
+     * decode and allocate texts again.
+     */
+    void setSearchableTextsFunction(const SearchableTextsFunction &searchableTexts);
+
+    /**
+     * Return texts to search in items in given @a rows (see setSearchableTextsFunction()).
+     *
+     * This is cheaper than requesting contentType::searchableTexts for each
+     * row since cached texts are only shared without creating model indexes.
+     */
+    QVector<QStringList> searchableTexts(const QVector<int> &rows) const;
+
+    /** Drop cached texts of all items (e.g. after plugins are enabled or disabled). */
+    void invalidateSearchableTexts();
+
+    /** Return size of item data in memory and size of data stored in files. */
+    void memoryUsage(qint64 *residentBytes, qint64 *storedBytes) const;
+
+    /** Return memory usage of all models with memory limit (see memoryUsage()). */
+    static void totalMemoryUsage(qint64 *residentBytes, qint64 *storedBytes);
+
 public slots:
 #if QT_VERSION < 0x050000
     void moveRow(int from, int to) { moveRows(QModelIndex(), from, 1, QModelIndex(), to); }
 #endif
 
+    /**
+     * Move data of least recently used items to spill file if memory limit
+     * or total memory limit is exceeded.
+     *
+     * Only items with data already saved in tab file are moved.
+     */
+    void releaseMemory();
 
 signals:
     void unloaded();
     void tabNameChanged(const QString &tabName);
+    void memoryUsageChanged(qint64 residentBytes, qint64 storedBytes);
 
 private:
+    /** Return cached texts to search in item or cache them first. */
+    QVariant searchableTexts(const QModelIndex &index) const;
+    QStringList searchableTexts(int row) const;
+
+    /** Call releaseMemory() later if memory is managed. */
+    void scheduleReleaseMemory() const;
+
+    /** Emit memoryUsageChanged() with current usage. */
+    void updateMemoryUsage();
+
+    /** Open new spill file if needed (old one is removed after no item uses it). */
+    bool openSpillFile();
+
+    void closeSpillFile();
+
+    /** Move data of item to spill file and return number of released bytes. */
+    qint64 spillItem(int row);
+
+    /** Spill data of least recently used items in @a models. */
+    static qint64 spillLeastRecentlyUsed(const QList<ClipboardModel*> &models, qint64 bytesToRelease);
+
+    /** Add items in given rows to hash index. */
+    void indexRows(int first, int last);
+
+    /** Remove items in given rows from hash index (must be called before items change). */
+    void unindexRows(int first, int last);
+
+    /** Call beginInsertRows() and update hash index for inserting items. */
+    void beginInsertItems(int row, int count);
+
+    /** Update hash index for inserted items and call endInsertRows(). */
+    void endInsertItems(int row, int count);
+
+    /** Call beginRemoveRows() and update hash index for removing items. */
+    void beginRemoveItems(int row, int count);
+
+    /** Update hash index after removing items and call endRemoveRows(). */
+    void endRemoveItems(int row, int count);
+
+    /** Move item to row @a to and update hash index. */
+    void moveItem(int from, int to);
+
     int m_max;
     ClipboardItemList m_clipboardList;
     bool m_disabled;
+    bool m_mapItemData;
     QString m_tabName;
+
+    /**
+     * Maps item hash to row key.
+     *
+     * Key is row plus offset so only keys of rows before or after inserted or
+     * removed items (whichever are fewer) need to be updated.
+     */
+    QMultiHash<quint64, int> m_rowKeys;
+    int m_rowKeyOffset;
+
+    qint64 m_memoryLimit;
+    bool m_memoryManaged;
+    mutable QTimer m_timerReleaseMemory;
+    QFile m_spillFile;
+    ItemPayloadFilePtr m_spillPayloadFile;
+    SearchableTextsFunction m_searchableTexts;
 };
 
 #endif // CLIPBOARDMODEL_H
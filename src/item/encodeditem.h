@@ -0,0 +1,49 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENCODEDITEM_H
+#define ENCODEDITEM_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+class QDataStream;
+
+/// Data of single format as stored in stream (not decoded yet).
+struct EncodedFormat {
+    QString mime;
+    bool mimeCompressed;
+    int codec;
+    QByteArray bytes;
+};
+
+using EncodedItem = QVector<EncodedFormat>;
+
+/// Return MIME type saved in compressed form by serializeData().
+QString decompressMime(const QString &mime);
+
+/// Read item data saved with serializeData() without decoding them.
+bool readEncodedItem(QDataStream *stream, EncodedItem *item);
+
+/// Decode data read with readEncodedItem().
+bool decodeItem(const EncodedItem &item, QVariantMap *data);
+
+#endif // ENCODEDITEM_H
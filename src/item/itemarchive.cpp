@@ -0,0 +1,312 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemarchive.h"
+
+#include "common/log.h"
+#include "item/itemcodec.h"
+#include "item/serialize.h"
+
+#include <QDataStream>
+#include <QFile>
+
+#include <algorithm>
+#include <functional>
+
+/**
+ * Format:
+ *   QString "CopyQ_item_archive", qint32 version,
+ *   records:
+ *     quint8 1 (item), quint8 codec, qint32 size, encoded serialized item data
+ *     quint8 2 (removed item), qint32 record number of the item (counting only items)
+ *
+ * Incomplete record at the end of file (e.g. after crash) is ignored and
+ * overwritten with next appended record.
+ */
+
+namespace {
+
+const char archiveFileHeader[] = "CopyQ_item_archive";
+
+const qint32 archiveVersion = 1;
+
+const quint8 recordItem = 1;
+
+const quint8 recordRemoved = 2;
+
+void printArchiveError(const QString &action, const QFile &file)
+{
+    log( QString("Cannot %1 archived items \"%2\": %3")
+         .arg(action, file.fileName(), file.errorString()), LogError );
+}
+
+} // namespace
+
+ItemArchive::ItemArchive(const QString &fileName)
+    : m_fileName(fileName)
+    , m_indexLoaded(false)
+    , m_size(0)
+    , m_offsets()
+    , m_records()
+    , m_recordCount(0)
+{
+}
+
+bool ItemArchive::append(const QVector<QVariantMap> &items)
+{
+    QFile file(m_fileName);
+    if ( !loadIndex() || !openForAppending(&file) )
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    for (const auto &data : items) {
+        const QByteArray bytes = serializeData(data, true);
+        int level;
+        const ItemCodec codec = codecForData(bytes, QString(), &level);
+        const QByteArray encoded = encodeData(codec, bytes, level);
+
+        const qint64 offset = file.pos();
+        stream << recordItem << static_cast<quint8>(codec) << static_cast<qint32>(encoded.size());
+        if ( stream.status() != QDataStream::Ok || file.write(encoded) != encoded.size() ) {
+            printArchiveError("save", file);
+            return false;
+        }
+
+        m_offsets.append(offset);
+        m_records.append(m_recordCount);
+        ++m_recordCount;
+        m_size = file.pos();
+    }
+
+    if ( !file.flush() ) {
+        printArchiveError("save", file);
+        return false;
+    }
+
+    COPYQ_LOG( QString("Archived %1 items to \"%2\"").arg(items.size()).arg(m_fileName) );
+
+    return true;
+}
+
+int ItemArchive::count()
+{
+    return loadIndex() ? m_offsets.size() : 0;
+}
+
+bool ItemArchive::read(int index, int count, QVector<QVariantMap> *items)
+{
+    if ( !loadIndex() || index < 0 || index >= m_offsets.size() )
+        return false;
+
+    QFile file(m_fileName);
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        printArchiveError("load", file);
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    const int last = qMin(index + count, m_offsets.size()) - 1;
+    for (int i = index; i <= last; ++i) {
+        if ( !file.seek(m_offsets[position(i)]) ) {
+            printArchiveError("load", file);
+            return false;
+        }
+
+        quint8 type;
+        quint8 codec;
+        qint32 size;
+        stream >> type >> codec >> size;
+
+        QByteArray bytes;
+        QVariantMap data;
+        if ( stream.status() != QDataStream::Ok || type != recordItem || size < 0
+             || !decodeData(codec, file.read(size), &bytes)
+             || !deserializeData(&data, bytes) )
+        {
+            log( QString("Archived item %1 in \"%2\" is corrupted").arg(i).arg(m_fileName), LogError );
+            return false;
+        }
+
+        items->append(data);
+    }
+
+    return true;
+}
+
+bool ItemArchive::remove(const QList<int> &indexes)
+{
+    if ( !loadIndex() )
+        return false;
+
+    QList<int> positions;
+    for (int index : indexes) {
+        if ( index >= 0 && index < m_offsets.size() )
+            positions.append( position(index) );
+    }
+
+    if ( positions.isEmpty() )
+        return true;
+
+    std::sort( positions.begin(), positions.end(), std::greater<int>() );
+    positions.erase( std::unique(positions.begin(), positions.end()), positions.end() );
+
+    QFile file(m_fileName);
+    if ( !openForAppending(&file) )
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    for (int pos : positions) {
+        stream << recordRemoved << m_records[pos];
+        if ( stream.status() != QDataStream::Ok ) {
+            printArchiveError("save", file);
+            return false;
+        }
+
+        m_offsets.remove(pos);
+        m_records.remove(pos);
+        m_size = file.pos();
+    }
+
+    if ( !file.flush() ) {
+        printArchiveError("save", file);
+        return false;
+    }
+
+    return true;
+}
+
+bool ItemArchive::loadIndex()
+{
+    if (m_indexLoaded)
+        return true;
+
+    m_size = 0;
+    m_offsets.clear();
+    m_records.clear();
+    m_recordCount = 0;
+
+    QFile file(m_fileName);
+    if ( !file.exists() ) {
+        m_indexLoaded = true;
+        return true;
+    }
+
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        printArchiveError("load", file);
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    QString header;
+    qint32 version;
+    stream >> header >> version;
+    if ( stream.status() != QDataStream::Ok || header != archiveFileHeader || version != archiveVersion ) {
+        log( QString("Archived items \"%1\" are corrupted or unsupported").arg(m_fileName), LogError );
+        return false;
+    }
+
+    m_size = file.pos();
+    const qint64 fileSize = file.size();
+
+    while ( m_size < fileSize ) {
+        quint8 type;
+        stream >> type;
+
+        if (type == recordItem) {
+            quint8 codec;
+            qint32 size;
+            stream >> codec >> size;
+            if ( stream.status() != QDataStream::Ok || size < 0 || file.pos() + size > fileSize )
+                break;
+
+            m_offsets.append(m_size);
+            m_records.append(m_recordCount);
+            ++m_recordCount;
+
+            if ( !file.seek(file.pos() + size) )
+                break;
+        } else if (type == recordRemoved) {
+            qint32 record;
+            stream >> record;
+            if ( stream.status() != QDataStream::Ok )
+                break;
+
+            const auto it = std::lower_bound(m_records.begin(), m_records.end(), record);
+            if ( it != m_records.end() && *it == record ) {
+                const int pos = static_cast<int>( it - m_records.begin() );
+                m_offsets.remove(pos);
+                m_records.remove(pos);
+            }
+        } else {
+            break;
+        }
+
+        m_size = file.pos();
+    }
+
+    if (m_size < fileSize) {
+        log( QString("Ignoring incomplete data at the end of archived items \"%1\"")
+             .arg(m_fileName), LogWarning );
+    }
+
+    m_indexLoaded = true;
+    return true;
+}
+
+bool ItemArchive::openForAppending(QFile *file)
+{
+    if ( !file->open(QIODevice::ReadWrite) ) {
+        printArchiveError("save", *file);
+        return false;
+    }
+
+    if (m_size == 0) {
+        QDataStream stream(file);
+        stream.setVersion(QDataStream::Qt_4_7);
+        if ( !file->resize(0) ) {
+            printArchiveError("save", *file);
+            return false;
+        }
+
+        stream << QString(archiveFileHeader) << archiveVersion;
+        if ( stream.status() != QDataStream::Ok ) {
+            printArchiveError("save", *file);
+            return false;
+        }
+
+        m_size = file->pos();
+        return true;
+    }
+
+    // Overwrite incomplete record.
+    if ( file->size() > m_size && !file->resize(m_size) ) {
+        printArchiveError("save", *file);
+        return false;
+    }
+
+    return file->seek(m_size);
+}
@@ -0,0 +1,91 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMARCHIVE_H
+#define ITEMARCHIVE_H
+
+#include <QList>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+#include <memory>
+
+class QFile;
+
+/**
+ * Append-only file with items removed from full tab.
+ *
+ * Archived items are never loaded all at once, only offsets of items in the
+ * file are kept in memory.
+ *
+ * Items are numbered from the most recently archived one (index 0) so archive
+ * continues where the tab ends.
+ *
+ * Removed items are only marked as removed in the file.
+ */
+class ItemArchive
+{
+public:
+    explicit ItemArchive(const QString &fileName);
+
+    const QString &fileName() const { return m_fileName; }
+
+    /**
+     * Append items to archive.
+     *
+     * Last item in @a items will have index 0.
+     */
+    bool append(const QVector<QVariantMap> &items);
+
+    /** Return number of archived items. */
+    int count();
+
+    /**
+     * Read at most @a count items starting at @a index.
+     * @return false if the file cannot be read or @a index is not valid
+     */
+    bool read(int index, int count, QVector<QVariantMap> *items);
+
+    /** Mark items as removed. */
+    bool remove(const QList<int> &indexes);
+
+private:
+    /** Read offsets of items (only first time or after the file changed). */
+    bool loadIndex();
+
+    bool openForAppending(QFile *file);
+
+    /** Convert index of item to position in m_offsets. */
+    int position(int index) const { return m_offsets.size() - 1 - index; }
+
+    QString m_fileName;
+    bool m_indexLoaded;
+    qint64 m_size;
+
+    /// Offsets of items in the file (oldest first).
+    QVector<qint64> m_offsets;
+    /// Record number of each item (used to mark item as removed).
+    QVector<qint32> m_records;
+    qint32 m_recordCount;
+};
+
+using ItemArchivePtr = std::shared_ptr<ItemArchive>;
+
+#endif // ITEMARCHIVE_H
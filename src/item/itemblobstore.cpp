@@ -0,0 +1,319 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemblobstore.h"
+
+#include "common/config.h"
+#include "common/log.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+namespace {
+
+/// Blob file starts with single byte with codec for the rest of data (see ItemCodec).
+const qint64 blobHeaderSize = 1;
+
+QMutex blobMutex;
+
+/// Blob files are written and removed from main thread and from thread saving items.
+QMutex blobFileMutex;
+
+/// Maps content hash to shared data.
+QHash<QByteArray, QByteArray> internedBlobs;
+
+/// Maps shared data to content hash.
+QHash<const char*, QByteArray> internedBlobHashes;
+
+/// Maps content hash to file with the data.
+QHash<QByteArray, std::weak_ptr<ItemPayloadFile>> blobFiles;
+
+/// Maps file name to content hashes of blob files referenced from the file (expects locked blobFileMutex).
+QHash<QString, QSet<QByteArray>> blobReferences;
+
+/// Maps content hash to number of files referencing the blob file (expects locked blobFileMutex).
+QHash<QByteArray, int> blobReferenceCounts;
+
+/// Number of files being saved (expects locked blobFileMutex).
+int blobSaveCount = 0;
+
+int blobCountToRelease = 64;
+
+QString blobDirectoryPath()
+{
+    return getConfigurationFilePath("_blobs");
+}
+
+QString blobFileName(const QByteArray &hash)
+{
+    return blobDirectoryPath() + '/' + QString::fromLatin1( hash.toHex() );
+}
+
+/// Forget data and files not used outside the store (expects locked blobMutex).
+void releaseUnusedBlobs()
+{
+    for (auto it = internedBlobs.begin(); it != internedBlobs.end(); ) {
+        if ( it.value().isDetached() ) {
+            internedBlobHashes.remove( it.value().constData() );
+            it = internedBlobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (auto it = blobFiles.begin(); it != blobFiles.end(); ) {
+        if ( it.value().expired() )
+            it = blobFiles.erase(it);
+        else
+            ++it;
+    }
+
+    blobCountToRelease = qMax( 64, 2 * (internedBlobs.size() + blobFiles.size()) );
+}
+
+void releaseUnusedBlobsIfNeeded()
+{
+    if (internedBlobs.size() + blobFiles.size() >= blobCountToRelease)
+        releaseUnusedBlobs();
+}
+
+/// Set references from file (expects locked blobFileMutex).
+void setBlobReferencesLocked(const QString &fileName, const QSet<QByteArray> &hashes)
+{
+    for ( const auto &hash : blobReferences.value(fileName) ) {
+        if ( --blobReferenceCounts[hash] <= 0 )
+            blobReferenceCounts.remove(hash);
+    }
+
+    for (const auto &hash : hashes)
+        ++blobReferenceCounts[hash];
+
+    blobReferences.insert(fileName, hashes);
+}
+
+/// Forget references from file (expects locked blobFileMutex).
+void removeBlobReferencesLocked(const QString &fileName)
+{
+    setBlobReferencesLocked( fileName, QSet<QByteArray>() );
+    blobReferences.remove(fileName);
+}
+
+void setBlobPayload(const QByteArray &hash, int codec, qint64 size, ItemPayload *payload)
+{
+    payload->offset = blobHeaderSize;
+    payload->size = static_cast<qint32>(size - blobHeaderSize);
+    payload->codec = codec;
+    payload->blobHash = hash;
+}
+
+} // namespace
+
+QByteArray blobHash(const QByteArray &bytes)
+{
+    {
+        QMutexLocker lock(&blobMutex);
+        const auto it = internedBlobHashes.constFind( bytes.constData() );
+        if ( it != internedBlobHashes.constEnd() && internedBlobs.value(*it).size() == bytes.size() )
+            return *it;
+    }
+
+    return QCryptographicHash::hash(bytes, QCryptographicHash::Sha1);
+}
+
+QByteArray internBlob(const QByteArray &bytes)
+{
+    if (bytes.size() < minBlobSize)
+        return bytes;
+
+    return internBlob( bytes, blobHash(bytes) );
+}
+
+QByteArray internBlob(const QByteArray &bytes, const QByteArray &hash)
+{
+    QMutexLocker lock(&blobMutex);
+
+    const auto it = internedBlobs.constFind(hash);
+    if ( it != internedBlobs.constEnd() )
+        return it.value();
+
+    internedBlobs.insert(hash, bytes);
+    internedBlobHashes.insert(bytes.constData(), hash);
+    releaseUnusedBlobsIfNeeded();
+
+    return bytes;
+}
+
+void releaseBlob(QByteArray *bytes)
+{
+    if (bytes->size() < minBlobSize) {
+        bytes->clear();
+        return;
+    }
+
+    QMutexLocker lock(&blobMutex);
+
+    const auto it = internedBlobHashes.find( bytes->constData() );
+    bytes->clear();
+
+    if ( it == internedBlobHashes.end() )
+        return;
+
+    const auto blobIt = internedBlobs.find( it.value() );
+    if ( blobIt != internedBlobs.end()
+         && blobIt.value().constData() == it.key()
+         && blobIt.value().isDetached() )
+    {
+        internedBlobs.erase(blobIt);
+        internedBlobHashes.erase(it);
+    }
+}
+
+bool saveBlob(
+        const QByteArray &hash, const QByteArray &bytes, ItemCodec codec, int level,
+        ItemPayload *payload)
+{
+    const QString fileName = blobFileName(hash);
+
+    QMutexLocker lock(&blobFileMutex);
+
+    {
+        QFile file(fileName);
+        char existingCodec;
+        if ( file.open(QIODevice::ReadOnly) && file.getChar(&existingCodec) ) {
+            setBlobPayload(hash, existingCodec, file.size(), payload);
+            return true;
+        }
+    }
+
+    if ( !QDir().mkpath(blobDirectoryPath()) ) {
+        log( QString("Failed to create directory for item data \"%1\"").arg(blobDirectoryPath()), LogError );
+        return false;
+    }
+
+    const QByteArray data = encodeData(codec, bytes, level);
+
+    QFile tmpFile(fileName + ".tmp");
+    if ( !tmpFile.open(QIODevice::WriteOnly)
+         || !tmpFile.putChar( static_cast<char>(codec) )
+         || tmpFile.write(data) != data.size()
+         || !tmpFile.flush() )
+    {
+        log( QString("Failed to save item data \"%1\": %2")
+             .arg(tmpFile.fileName(), tmpFile.errorString()), LogError );
+        return false;
+    }
+
+    tmpFile.close();
+
+    QFile::remove(fileName);
+    if ( !tmpFile.rename(fileName) ) {
+        log( QString("Failed to save item data \"%1\": %2")
+             .arg(fileName, tmpFile.errorString()), LogError );
+        return false;
+    }
+
+    setBlobPayload(hash, codec, blobHeaderSize + data.size(), payload);
+    return true;
+}
+
+bool hasBlob(const QByteArray &hash)
+{
+    return QFile::exists( blobFileName(hash) );
+}
+
+ItemPayloadFilePtr blobPayloadFile(const QByteArray &hash, bool map)
+{
+    QMutexLocker lock(&blobMutex);
+
+    auto file = blobFiles.value(hash).lock();
+    if (!file) {
+        file = std::make_shared<ItemPayloadFile>(blobFileName(hash), map);
+        blobFiles.insert(hash, file);
+        releaseUnusedBlobsIfNeeded();
+    }
+
+    return file;
+}
+
+void setBlobReferences(const QString &fileName, const QSet<QByteArray> &hashes)
+{
+    QMutexLocker lock(&blobFileMutex);
+    setBlobReferencesLocked(fileName, hashes);
+}
+
+void removeBlobReferences(const QString &fileName)
+{
+    QMutexLocker lock(&blobFileMutex);
+    removeBlobReferencesLocked(fileName);
+}
+
+BlobSaveGuard::BlobSaveGuard()
+{
+    QMutexLocker lock(&blobFileMutex);
+    ++blobSaveCount;
+}
+
+BlobSaveGuard::~BlobSaveGuard()
+{
+    QMutexLocker lock(&blobFileMutex);
+    --blobSaveCount;
+}
+
+void removeUnusedBlobs(const QStringList &fileNames, BlobHashesReader readHashes)
+{
+    // Lock until unused files are removed so no new references can be saved meanwhile.
+    QMutexLocker lock(&blobFileMutex);
+
+    // Files being saved can reference blob files not referenced from other files anymore.
+    if (blobSaveCount > 0)
+        return;
+
+    for ( const auto &fileName : blobReferences.keys() ) {
+        if ( !fileNames.contains(fileName) )
+            removeBlobReferencesLocked(fileName);
+    }
+
+    // References are read only once, later these are set after saving the file.
+    for (const auto &fileName : fileNames) {
+        if ( blobReferences.contains(fileName) )
+            continue;
+
+        QSet<QByteArray> hashes;
+        if ( !readHashes(fileName, &hashes) ) {
+            log( QString("Failed to read item data references from \"%1\"")
+                 .arg(fileName), LogWarning );
+            return;
+        }
+
+        setBlobReferencesLocked(fileName, hashes);
+    }
+
+    QDir dir( blobDirectoryPath() );
+    for ( const auto &fileName : dir.entryList(QDir::Files) ) {
+        const QByteArray hash = QByteArray::fromHex( fileName.toLatin1() );
+        if ( !blobReferenceCounts.contains(hash) ) {
+            COPYQ_LOG( QString("Removing unused item data \"%1\"").arg(fileName) );
+            dir.remove(fileName);
+        }
+    }
+}
@@ -0,0 +1,120 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMBLOBSTORE_H
+#define ITEMBLOBSTORE_H
+
+#include "item/itempayload.h"
+
+#include <QByteArray>
+#include <QSet>
+#include <QStringList>
+
+/**
+ * Content-addressed store for bigger item data.
+ *
+ * Identical data (e.g. same image in multiple items or tabs) are kept in
+ * memory only once and saved only once in a blob file named by content hash.
+ * Tab files reference the blob files by the hash.
+ */
+
+/// Minimal size of data to share in memory and to save in blob files.
+const int minBlobSize = 4096;
+
+/// Return content hash of @a bytes (cached for data returned by internBlob()).
+QByteArray blobHash(const QByteArray &bytes);
+
+/**
+ * Return shared copy of @a bytes if same data are already in memory.
+ *
+ * Data smaller than minBlobSize are returned unchanged.
+ */
+QByteArray internBlob(const QByteArray &bytes);
+
+/// Same as internBlob() but with known content hash.
+QByteArray internBlob(const QByteArray &bytes, const QByteArray &hash);
+
+/**
+ * Release @a bytes (cleared) returned by internBlob().
+ *
+ * Shared data are forgotten right away if no one else uses them so the memory
+ * is freed (e.g. after data are moved to file).
+ */
+void releaseBlob(QByteArray *bytes);
+
+/**
+ * Save data to blob file unless it already exists.
+ *
+ * @param codec    codec for new blob file
+ * @param level    zlib compression level for new blob file
+ * @param payload  reference to data in blob file (without payload file)
+ *
+ * @return true only if data were saved or blob file already exists
+ */
+bool saveBlob(
+        const QByteArray &hash, const QByteArray &bytes, ItemCodec codec, int level,
+        ItemPayload *payload);
+
+/// Return true if blob file with given content hash exists.
+bool hasBlob(const QByteArray &hash);
+
+/// Return payload file for blob (shared for all items with the same data).
+ItemPayloadFilePtr blobPayloadFile(const QByteArray &hash, bool map);
+
+/**
+ * Set content hashes of blob files referenced from @a fileName (e.g. saved tab file).
+ *
+ * Blob files are removed only if no file references them (see removeUnusedBlobs()).
+ */
+void setBlobReferences(const QString &fileName, const QSet<QByteArray> &hashes);
+
+/// Forget references from @a fileName so these are read again (e.g. file cannot be read).
+void removeBlobReferences(const QString &fileName);
+
+/**
+ * Keeps blob files from being removed while saving a file referencing them.
+ *
+ * Create before saving the file and destroy after its references are set
+ * with setBlobReferences().
+ */
+class BlobSaveGuard
+{
+public:
+    BlobSaveGuard();
+    ~BlobSaveGuard();
+
+    BlobSaveGuard(const BlobSaveGuard &) = delete;
+    BlobSaveGuard &operator=(const BlobSaveGuard &) = delete;
+};
+
+/// Reads content hashes of blob files referenced from a file.
+using BlobHashesReader = bool (*)(const QString &fileName, QSet<QByteArray> *hashes);
+
+/**
+ * Remove blob files not referenced from any of @a fileNames.
+ *
+ * References are read using @a readHashes only from files without references
+ * set yet; references from files not in @a fileNames are forgotten.
+ *
+ * Nothing is removed if any file cannot be read or if other files are being
+ * saved (see BlobSaveGuard).
+ */
+void removeUnusedBlobs(const QStringList &fileNames, BlobHashesReader readHashes);
+
+#endif // ITEMBLOBSTORE_H
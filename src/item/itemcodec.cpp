@@ -0,0 +1,329 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemcodec.h"
+
+#include "common/mimetypes.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct CodecPolicy {
+    const char *formatPrefix;
+    ItemCodec codec;
+    int level;
+};
+
+/// Codec for data with format starting with given prefix (first match is used).
+const CodecPolicy codecPolicies[] = {
+    // Already compressed.
+    {"image/png", CodecNone, 0},
+    {"image/jpeg", CodecNone, 0},
+    {"image/gif", CodecNone, 0},
+    {"image/webp", CodecNone, 0},
+    {"audio/", CodecNone, 0},
+    {"video/", CodecNone, 0},
+    {"application/zip", CodecNone, 0},
+    {"application/gzip", CodecNone, 0},
+    {"application/x-gzip", CodecNone, 0},
+    {"application/x-bzip2", CodecNone, 0},
+    {"application/x-xz", CodecNone, 0},
+    {"application/x-7z-compressed", CodecNone, 0},
+
+    // Text is saved and loaded often so prefer speed.
+    {"text/", CodecLz, 0},
+    {"image/svg", CodecLz, 0},
+    {COPYQ_MIME_PREFIX, CodecLz, 0},
+    {"application/json", CodecLz, 0},
+    {"application/xml", CodecLz, 0},
+
+    // Uncompressed images.
+    {"image/bmp", CodecZlib, 6},
+    {"image/x-bmp", CodecZlib, 6},
+    {"image/", CodecNone, 0},
+
+    {"", CodecZlib, -1}
+};
+
+/// Don't compress smaller data.
+const int minSizeToCompress = 256;
+
+/// Size of each of sampled parts (beginning, middle and end of data).
+const int sampleSize = 4096;
+
+/// Minimal number of bytes needed to encode a match in LZ codec.
+const int lzMinMatch = 4;
+
+const int lzHashBits = 12;
+
+const int lzMaxOffset = 0xFFFF;
+
+/// Limit for decompressed size (to avoid allocating too much memory for corrupted data).
+const quint32 lzMaxDecodedSize = 1u << 30;
+
+/**
+ * Maximum number of decoded bytes per byte of compressed sequences.
+ *
+ * Only length bytes of long matches expand that much (token and offset bytes
+ * of shortest match expand less).
+ */
+const quint64 lzMaxExpansion = 255;
+
+quint32 readUInt32(const uchar *data)
+{
+    quint32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+void appendLength(QByteArray *out, int length)
+{
+    for ( ; length >= 255; length -= 255 )
+        out->append( static_cast<char>(255) );
+    out->append( static_cast<char>(length) );
+}
+
+bool readLength(const uchar **in, const uchar *end, int *length)
+{
+    uchar byte;
+    do {
+        if (*in >= end)
+            return false;
+        byte = *(*in)++;
+        *length += byte;
+        if ( static_cast<quint32>(*length) > lzMaxDecodedSize )
+            return false;
+    } while (byte == 255);
+
+    return true;
+}
+
+/**
+ * Append sequence of literals optionally followed by a match.
+ *
+ * Token byte contains literal count (high 4 bits) and match length minus lzMinMatch
+ * (low 4 bits); value 15 means that more length bytes follow.
+ */
+void appendSequence(QByteArray *out, const uchar *literals, int literalCount, int offset, int matchLength)
+{
+    const int matchCode = matchLength - lzMinMatch;
+    const int token = (qMin(literalCount, 15) << 4) | (offset > 0 ? qMin(matchCode, 15) : 0);
+    out->append( static_cast<char>(token) );
+
+    if (literalCount >= 15)
+        appendLength(out, literalCount - 15);
+    out->append( reinterpret_cast<const char*>(literals), literalCount );
+
+    if (offset > 0) {
+        out->append( static_cast<char>(offset & 0xFF) );
+        out->append( static_cast<char>(offset >> 8) );
+        if (matchCode >= 15)
+            appendLength(out, matchCode - 15);
+    }
+}
+
+/**
+ * Compress with simple LZ77 codec (similar to LZ4 block format).
+ *
+ * Data start with 32-bit little-endian decompressed size followed by sequences.
+ * Last sequence contains only literals.
+ */
+QByteArray lzCompress(const QByteArray &bytes)
+{
+    const int size = bytes.size();
+    const auto src = reinterpret_cast<const uchar*>(bytes.constData());
+
+    QByteArray out;
+    out.reserve(size + size / 255 + 16);
+    for (int i = 0; i < 4; ++i)
+        out.append( static_cast<char>((static_cast<quint32>(size) >> (8 * i)) & 0xFF) );
+
+    std::vector<int> table(1 << lzHashBits, -1);
+
+    int anchor = 0;
+    int i = 0;
+    while (i + lzMinMatch <= size) {
+        const quint32 sequence = readUInt32(src + i);
+        const quint32 hash = (sequence * 2654435761u) >> (32 - lzHashBits);
+        const int candidate = table[hash];
+        table[hash] = i;
+
+        if ( candidate >= 0 && i - candidate <= lzMaxOffset && readUInt32(src + candidate) == sequence ) {
+            int matchLength = lzMinMatch;
+            while (i + matchLength < size && src[candidate + matchLength] == src[i + matchLength])
+                ++matchLength;
+
+            appendSequence(&out, src + anchor, i - anchor, i - candidate, matchLength);
+            i += matchLength;
+            anchor = i;
+        } else {
+            ++i;
+        }
+    }
+
+    appendSequence(&out, src + anchor, size - anchor, 0, 0);
+
+    return out;
+}
+
+bool lzDecompress(const QByteArray &bytes, QByteArray *decoded)
+{
+    if (bytes.size() < 4)
+        return false;
+
+    const auto data = reinterpret_cast<const uchar*>(bytes.constData());
+    const quint32 size = data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<quint32>(data[3]) << 24);
+    if (size > lzMaxDecodedSize)
+        return false;
+
+    const uchar *in = data + 4;
+    const uchar *end = data + bytes.size();
+
+    // Don't allocate more than compressed data can possibly decode to.
+    if ( size > static_cast<quint64>(end - in) * lzMaxExpansion )
+        return false;
+
+    decoded->resize( static_cast<int>(size) );
+    const auto outBegin = reinterpret_cast<uchar*>( decoded->data() );
+    const uchar *outEnd = outBegin + size;
+    uchar *out = outBegin;
+
+    // Data must end with sequence of literals (otherwise data are truncated).
+    for (;;) {
+        if (in >= end)
+            return false;
+
+        const int token = *in++;
+
+        int literalCount = token >> 4;
+        if ( literalCount == 15 && !readLength(&in, end, &literalCount) )
+            return false;
+        if (literalCount > end - in || literalCount > outEnd - out)
+            return false;
+
+        std::memcpy(out, in, static_cast<size_t>(literalCount));
+        out += literalCount;
+        in += literalCount;
+
+        if (in == end)
+            break;
+
+        if (end - in < 2)
+            return false;
+        const int offset = in[0] | (in[1] << 8);
+        in += 2;
+        if (offset == 0 || offset > out - outBegin)
+            return false;
+
+        int matchLength = token & 15;
+        if ( matchLength == 15 && !readLength(&in, end, &matchLength) )
+            return false;
+        matchLength += lzMinMatch;
+        if (matchLength > outEnd - out)
+            return false;
+
+        // Byte by byte since the match can overlap with the output.
+        const uchar *match = out - offset;
+        for (int i = 0; i < matchLength; ++i)
+            out[i] = match[i];
+        out += matchLength;
+    }
+
+    return out == outEnd;
+}
+
+/**
+ * Return true if sample of data (beginning, middle and end) can be compressed enough.
+ *
+ * Smaller data are compressed whole and returned in @a compressed (LZ codec).
+ */
+bool compressesWell(const QByteArray &bytes, QByteArray *compressed)
+{
+    const int size = bytes.size();
+    if (size <= 3 * sampleSize) {
+        *compressed = lzCompress(bytes);
+        return compressed->size() < size * 9 / 10;
+    }
+
+    const QByteArray sample =
+            bytes.left(sampleSize) + bytes.mid(size / 2 - sampleSize / 2, sampleSize) + bytes.right(sampleSize);
+    return lzCompress(sample).size() < sample.size() * 9 / 10;
+}
+
+} // namespace
+
+ItemCodec codecForData(const QByteArray &bytes, const QString &format, int *level, QByteArray *encoded)
+{
+    *level = -1;
+    if (encoded)
+        encoded->clear();
+
+    if (bytes.size() <= minSizeToCompress)
+        return CodecNone;
+
+    for (const auto &policy : codecPolicies) {
+        if ( format.startsWith(QLatin1String(policy.formatPrefix)) ) {
+            QByteArray compressed;
+            if ( policy.codec == CodecNone || !compressesWell(bytes, &compressed) )
+                return CodecNone;
+
+            if (encoded && policy.codec == CodecLz)
+                *encoded = compressed;
+
+            *level = policy.level;
+            return policy.codec;
+        }
+    }
+
+    return CodecNone;
+}
+
+QByteArray encodeData(ItemCodec codec, const QByteArray &bytes, int level)
+{
+    if (codec == CodecZlib)
+        return qCompress(bytes, level);
+
+    if (codec == CodecLz)
+        return lzCompress(bytes);
+
+    return bytes;
+}
+
+bool decodeData(int codec, const QByteArray &bytes, QByteArray *decoded)
+{
+    if (codec == CodecNone) {
+        *decoded = bytes;
+        return true;
+    }
+
+    if (codec == CodecZlib) {
+        *decoded = qUncompress(bytes);
+        return !decoded->isEmpty();
+    }
+
+    if (codec == CodecLz)
+        return lzDecompress(bytes, decoded);
+
+    return false;
+}
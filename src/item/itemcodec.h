@@ -0,0 +1,62 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMCODEC_H
+#define ITEMCODEC_H
+
+class QByteArray;
+class QString;
+
+/**
+ * Codecs for saved item data.
+ *
+ * Values are saved in tab files so these must not change.
+ */
+enum ItemCodec {
+    /// Data are not compressed.
+    CodecNone = 0,
+    /// Compressed with qCompress() (zlib).
+    CodecZlib = 1,
+    /// Compressed with fast LZ77 codec (faster but bigger than zlib).
+    CodecLz = 2
+};
+
+/**
+ * Choose codec for data of given @a format.
+ *
+ * Small data and data in already compressed formats are not compressed.
+ * Bigger data are compressed only if a sample compresses well.
+ *
+ * @param level    zlib compression level if CodecZlib is returned
+ * @param encoded  if not null, set to data encoded with returned codec if these
+ *                 were already encoded when choosing the codec, otherwise cleared
+ */
+ItemCodec codecForData(
+        const QByteArray &bytes, const QString &format, int *level, QByteArray *encoded = nullptr);
+
+/// Compress data with given codec (and zlib @a level).
+QByteArray encodeData(ItemCodec codec, const QByteArray &bytes, int level = -1);
+
+/**
+ * Decompress data.
+ * @return true only if data were decompressed successfully
+ */
+bool decodeData(int codec, const QByteArray &bytes, QByteArray *decoded);
+
+#endif // ITEMCODEC_H
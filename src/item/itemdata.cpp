@@ -0,0 +1,334 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemdata.h"
+
+#include "common/common.h"
+#include "common/log.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace {
+
+/// Format names are stored in chunks which are never moved so they can be read without locking.
+const int formatChunkSize = 256;
+const int maxFormatChunkCount = 4096;
+
+/**
+ * Open addressing hash table with format ids (plus one, zero for empty slot).
+ *
+ * Table is at most half full so lookups always end at an empty slot.
+ */
+struct FormatHashTable {
+    explicit FormatHashTable(int capacity)
+        : capacity(capacity)
+        , slots(new std::atomic<int>[capacity])
+    {
+        for (int i = 0; i < capacity; ++i)
+            slots[i].store(0, std::memory_order_relaxed);
+    }
+
+    const int capacity;
+    std::unique_ptr<std::atomic<int>[]> slots;
+};
+
+/**
+ * Formats are registered from main thread and threads loading and saving items.
+ *
+ * Formats are only appended (rarely and while holding the mutex) and looked up
+ * without locking. Name of new format is written and published before its id
+ * is added to hash table. Replaced hash tables are kept since other threads can
+ * still read them.
+ */
+QMutex formatMutex;
+
+std::atomic<QString*> formatNameChunks[maxFormatChunkCount];
+std::atomic<int> formatCount(0);
+std::atomic<FormatHashTable*> formatTable(nullptr);
+
+std::vector< std::unique_ptr<QString[]> > formatNameStorage;
+std::vector< std::unique_ptr<FormatHashTable> > formatTables;
+
+const QString &formatNameAt(int formatId)
+{
+    const QString *names = formatNameChunks[formatId / formatChunkSize].load(std::memory_order_acquire);
+    return names[formatId % formatChunkSize];
+}
+
+int findFormatId(const FormatHashTable *table, const QString &format, uint formatHash)
+{
+    if (table == nullptr)
+        return -1;
+
+    const int mask = table->capacity - 1;
+    for (int i = formatHash & mask; ; i = (i + 1) & mask) {
+        const int idPlusOne = table->slots[i].load(std::memory_order_acquire);
+        if (idPlusOne == 0)
+            return -1;
+        if ( formatNameAt(idPlusOne - 1) == format )
+            return idPlusOne - 1;
+    }
+}
+
+/// Add id to hash table (expects locked formatMutex).
+void insertFormatId(FormatHashTable *table, int formatId, uint formatHash)
+{
+    const int mask = table->capacity - 1;
+    int i = formatHash & mask;
+    while ( table->slots[i].load(std::memory_order_relaxed) != 0 )
+        i = (i + 1) & mask;
+    table->slots[i].store(formatId + 1, std::memory_order_release);
+}
+
+bool formatIdLessThan(const ItemDataFormat &format, int id)
+{
+    return format.id < id;
+}
+
+} // namespace
+
+int itemFormatId(const QString &format)
+{
+    const uint formatHash = qHash(format);
+    const int id = findFormatId( formatTable.load(std::memory_order_acquire), format, formatHash );
+    if (id != -1)
+        return id;
+
+    QMutexLocker lock(&formatMutex);
+
+    // Format could have been added by other thread.
+    FormatHashTable *table = formatTable.load(std::memory_order_relaxed);
+    const int existingId = findFormatId(table, format, formatHash);
+    if (existingId != -1)
+        return existingId;
+
+    const int newId = formatCount.load(std::memory_order_relaxed);
+    const int chunk = newId / formatChunkSize;
+    if (chunk >= maxFormatChunkCount) {
+        log( QString("Too many item formats, ignoring \"%1\"").arg(format), LogError );
+        return -1;
+    }
+
+    QString *names = formatNameChunks[chunk].load(std::memory_order_relaxed);
+    if (names == nullptr) {
+        names = new QString[formatChunkSize];
+        formatNameStorage.emplace_back(names);
+        formatNameChunks[chunk].store(names, std::memory_order_release);
+    }
+    names[newId % formatChunkSize] = format;
+    formatCount.store(newId + 1, std::memory_order_release);
+
+    if ( table == nullptr || 2 * (newId + 1) > table->capacity ) {
+        int capacity = table == nullptr ? 64 : 2 * table->capacity;
+        while ( 2 * (newId + 1) > capacity )
+            capacity *= 2;
+
+        table = new FormatHashTable(capacity);
+        formatTables.emplace_back(table);
+        for (int i = 0; i <= newId; ++i)
+            insertFormatId( table, i, qHash(formatNameAt(i)) );
+        formatTable.store(table, std::memory_order_release);
+    } else {
+        insertFormatId(table, newId, formatHash);
+    }
+
+    return newId;
+}
+
+int findItemFormatId(const QString &format)
+{
+    return findFormatId( formatTable.load(std::memory_order_acquire), format, qHash(format) );
+}
+
+const QString &itemFormatName(int formatId)
+{
+    static const QString unknownFormat;
+    if ( formatId < 0 || formatId >= formatCount.load(std::memory_order_acquire) )
+        return unknownFormat;
+
+    return formatNameAt(formatId);
+}
+
+ItemData ItemData::fromMap(const QVariantMap &data)
+{
+    ItemData itemData;
+    itemData.m_formats.reserve( data.size() );
+
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        ItemDataFormat format;
+        format.id = itemFormatId( it.key() );
+        format.bytes = it.value().toByteArray();
+        format.hash = 0;
+        itemData.m_formats.append(format);
+    }
+
+    std::sort(
+        itemData.m_formats.begin(), itemData.m_formats.end(),
+        [](const ItemDataFormat &lhs, const ItemDataFormat &rhs) { return lhs.id < rhs.id; });
+
+    return itemData;
+}
+
+QVariantMap ItemData::toMap() const
+{
+    QVariantMap data;
+    for (const auto &format : m_formats)
+        data.insert( itemFormatName(format.id), format.bytes );
+    return data;
+}
+
+qint64 ItemData::byteCount() const
+{
+    qint64 result = 0;
+    for (const auto &format : m_formats)
+        result += format.bytes.size();
+    return result;
+}
+
+bool ItemData::contains(const QString &format) const
+{
+    return find(format) != nullptr;
+}
+
+const QByteArray *ItemData::find(const QString &format) const
+{
+    const int i = indexOf( findItemFormatId(format) );
+    return i == -1 ? nullptr : &m_formats[i].bytes;
+}
+
+QByteArray ItemData::value(const QString &format) const
+{
+    const auto bytes = find(format);
+    return bytes ? *bytes : QByteArray();
+}
+
+quint64 ItemData::formatHashAt(int i) const
+{
+    const ItemDataFormat &format = m_formats[i];
+    return format.hash != 0 ? format.hash : hashFormatData(format.bytes);
+}
+
+void ItemData::updateFormatHashes()
+{
+    // Avoid detaching data shared with other copies if hashes are known.
+    for (int i = 0; i < m_formats.size(); ++i) {
+        if ( m_formats.at(i).hash == 0 )
+            m_formats[i].hash = hashFormatData( m_formats.at(i).bytes );
+    }
+}
+
+void ItemData::insert(const QString &format, const QByteArray &bytes, quint64 formatHash)
+{
+    ItemDataFormat newFormat;
+    newFormat.id = itemFormatId(format);
+    newFormat.bytes = bytes;
+    newFormat.hash = formatHash;
+
+    const auto it = std::lower_bound(
+                m_formats.begin(), m_formats.end(), newFormat.id, formatIdLessThan);
+    if ( it != m_formats.end() && it->id == newFormat.id ) {
+        it->bytes = bytes;
+        it->hash = formatHash;
+    } else {
+        m_formats.insert(it, newFormat);
+    }
+}
+
+bool ItemData::remove(const QString &format)
+{
+    const int i = indexOf( findItemFormatId(format) );
+    if (i == -1)
+        return false;
+
+    m_formats.remove(i);
+    return true;
+}
+
+QStringList ItemData::formats() const
+{
+    QStringList result;
+    for (const auto &format : m_formats)
+        result.append( itemFormatName(format.id) );
+    return result;
+}
+
+quint64 ItemData::formatHash(const QString &format) const
+{
+    const int i = indexOf( findItemFormatId(format) );
+    return i == -1 ? 0 : formatHashAt(i);
+}
+
+QMap<QString, quint64> ItemData::formatHashes() const
+{
+    QMap<QString, quint64> result;
+    for (int i = 0; i < m_formats.size(); ++i)
+        result.insert( itemFormatName(m_formats[i].id), formatHashAt(i) );
+    return result;
+}
+
+quint64 ItemData::hash() const
+{
+    return hashItemFormats( formatHashes() );
+}
+
+void ItemData::copyFormatHashes(const ItemData &other)
+{
+    for (auto &format : m_formats) {
+        if (format.hash != 0)
+            continue;
+
+        const int i = other.indexOf(format.id);
+        if (i != -1 && other.m_formats[i].hash != 0 && other.m_formats[i].bytes == format.bytes)
+            format.hash = other.m_formats[i].hash;
+    }
+}
+
+bool ItemData::operator==(const ItemData &other) const
+{
+    if ( m_formats.size() != other.m_formats.size() )
+        return false;
+
+    for (int i = 0; i < m_formats.size(); ++i) {
+        if ( m_formats[i].id != other.m_formats[i].id || m_formats[i].bytes != other.m_formats[i].bytes )
+            return false;
+    }
+
+    return true;
+}
+
+int ItemData::indexOf(int formatId) const
+{
+    if (formatId == -1)
+        return -1;
+
+    const auto it = std::lower_bound(
+                m_formats.constBegin(), m_formats.constEnd(), formatId, formatIdLessThan);
+    if ( it == m_formats.constEnd() || it->id != formatId )
+        return -1;
+
+    return static_cast<int>( it - m_formats.constBegin() );
+}
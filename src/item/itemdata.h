@@ -0,0 +1,135 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMDATA_H
+#define ITEMDATA_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+class QStringList;
+
+/**
+ * Return small unique number for MIME type.
+ *
+ * Ids are shared by all items and valid only while application runs.
+ */
+int itemFormatId(const QString &format);
+
+/// Return id for MIME type or -1 if itemFormatId() was not called for it yet.
+int findItemFormatId(const QString &format);
+
+/// Return MIME type for id returned by itemFormatId() (lookups of formats don't lock).
+const QString &itemFormatName(int formatId);
+
+struct ItemDataFormat {
+    int id;
+    QByteArray bytes;
+    /// Cached hash of the data (see hashFormatData()) or 0 if not computed yet.
+    quint64 hash;
+};
+
+Q_DECLARE_TYPEINFO(ItemDataFormat, Q_MOVABLE_TYPE);
+
+/**
+ * Compact storage for data of an item.
+ *
+ * Data are kept in small vector sorted by format id (see itemFormatId()) so
+ * there is no overhead of map nodes, QVariant and MIME type strings for each
+ * item. Use toMap() and fromMap() only where QVariantMap is needed.
+ */
+class ItemData {
+public:
+    static ItemData fromMap(const QVariantMap &data);
+
+    QVariantMap toMap() const;
+
+    bool isEmpty() const { return m_formats.isEmpty(); }
+
+    int size() const { return m_formats.size(); }
+
+    /// Return total size of data in all formats.
+    qint64 byteCount() const;
+
+    void clear() { m_formats.clear(); }
+
+    /// Return format id at given position (formats are sorted by id).
+    int formatIdAt(int i) const { return m_formats[i].id; }
+
+    const QByteArray &bytesAt(int i) const { return m_formats[i].bytes; }
+
+    /// Replace data with the same content (e.g. with data shared with other items).
+    void setBytesAt(int i, const QByteArray &bytes) { m_formats[i].bytes = bytes; }
+
+    /// Return cached hash of data at given position (computed but not cached if needed).
+    quint64 formatHashAt(int i) const;
+
+    /**
+     * Compute and cache missing hashes of data.
+     *
+     * Call this before data are shared with copies used in other threads
+     * since cached hashes are never modified from const methods.
+     */
+    void updateFormatHashes();
+
+    void removeAt(int i) { m_formats.remove(i); }
+
+    bool contains(const QString &format) const;
+
+    /// Return data for format or nullptr if format is missing.
+    const QByteArray *find(const QString &format) const;
+
+    /// Return data for format or empty data if format is missing.
+    QByteArray value(const QString &format) const;
+
+    /// Set data for format; @a formatHash is hash of the data if already known.
+    void insert(const QString &format, const QByteArray &bytes, quint64 formatHash = 0);
+
+    bool remove(const QString &format);
+
+    QStringList formats() const;
+
+    /// Return hash of data for format (computed if needed) or 0 if format is missing.
+    quint64 formatHash(const QString &format) const;
+
+    /// Return map with format as key and hash of its data as value.
+    QMap<QString, quint64> formatHashes() const;
+
+    /**
+     * Return same value as hash(const QVariantMap &) for data converted to map.
+     *
+     * Only data of formats without cached hash are hashed.
+     */
+    quint64 hash() const;
+
+    /// Reuse cached hashes of unchanged data from @a other.
+    void copyFormatHashes(const ItemData &other);
+
+    bool operator==(const ItemData &other) const;
+    bool operator!=(const ItemData &other) const { return !(*this == other); }
+
+private:
+    int indexOf(int formatId) const;
+
+    QVector<ItemDataFormat> m_formats;
+};
+
+#endif // ITEMDATA_H
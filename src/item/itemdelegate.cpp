@@ -37,12 +37,6 @@ namespace {
 
 const char propertySelectedItem[] = "CopyQ_selected";
 
-inline void reset(ItemWidget **ptr, ItemWidget *value = nullptr)
-{
-    delete *ptr;
-    *ptr = value != nullptr ? value : nullptr;
-}
-
 int itemMargin()
 {
     const int dpi = QApplication::desktop()->physicalDpiX();
@@ -79,14 +73,11 @@ ItemDelegate::~ItemDelegate()
 
 QSize ItemDelegate::sizeHint(const QModelIndex &index) const
 {
-    int row = index.row();
-    if ( row < m_cache.size() ) {
-        const ItemWidget *w = m_cache[row];
-        if (w != nullptr) {
-            QWidget *ww = w->widget();
-            return QSize( ww->width() + 2 * m_hMargin + rowNumberWidth(),
-                          qMax(ww->height() + 2 * m_vMargin, rowNumberHeight()) );
-        }
+    const ItemWidget *w = m_cache.value(index.row(), nullptr);
+    if (w != nullptr) {
+        QWidget *ww = w->widget();
+        return QSize( ww->width() + 2 * m_hMargin + rowNumberWidth(),
+                      qMax(ww->height() + 2 * m_vMargin, rowNumberHeight()) );
     }
     return QSize(0, 512);
 }
@@ -101,18 +92,14 @@ bool ItemDelegate::eventFilter(QObject *obj, QEvent *event)
 {
     // resize event for items
     if ( event->type() == QEvent::Resize ) {
-        int row = 0;
-        for (; row < m_cache.size(); ++row) {
-            auto w = m_cache[row];
-            if (w && w->widget() == obj)
+        for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+            if ( it.value()->widget() == obj ) {
+                const auto index = m_view->model()->index(it.key(), 0);
+                if ( index.isValid() )
+                    emit sizeHintChanged(index);
                 break;
+            }
         }
-
-        Q_ASSERT( row < m_cache.size() );
-
-        const auto index = m_view->model()->index(row, 0);
-        if ( index.isValid() )
-            emit sizeHintChanged(index);
     }
 
     return false;
@@ -120,43 +107,74 @@ bool ItemDelegate::eventFilter(QObject *obj, QEvent *event)
 
 void ItemDelegate::dataChanged(const QModelIndex &a, const QModelIndex &b)
 {
-    for ( int row = a.row(); row <= b.row(); ++row ) {
-        auto item = &m_cache[row];
-        if (*item) {
-            reset(item);
-            cache( m_view->index(row) );
-        }
+    QList<int> rows;
+    for ( auto it = m_cache.lowerBound(a.row()); it != m_cache.end() && it.key() <= b.row(); ++it )
+        rows.append( it.key() );
+
+    for (const int row : rows) {
+        setCachedWidget(row, nullptr);
+        cache( m_view->index(row) );
     }
 }
 
 void ItemDelegate::rowsRemoved(const QModelIndex &, int start, int end)
 {
-    for( int i = end; i >= start; --i ) {
-        delete m_cache.takeAt(i);
+    const int count = end - start + 1;
+
+    QMap<int, ItemWidget*> cache;
+    for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+        const int row = it.key();
+        if (row < start)
+            cache.insert(row, it.value());
+        else if (row > end)
+            cache.insert(row - count, it.value());
+        else
+            delete it.value();
     }
+
+    m_cache = cache;
 }
 
 void ItemDelegate::rowsMoved(const QModelIndex &, int sourceStart, int sourceEnd,
                              const QModelIndex &, int destinationRow)
 {
-    int dest = sourceStart < destinationRow ? destinationRow-1 : destinationRow;
-    for( int i = sourceStart; i <= sourceEnd; ++i ) {
-        m_cache.move(i,dest);
-        ++dest;
+    const int count = sourceEnd - sourceStart + 1;
+
+    QMap<int, ItemWidget*> cache;
+    for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+        int row = it.key();
+        if (sourceStart <= row && row <= sourceEnd) {
+            row += destinationRow > sourceEnd
+                    ? destinationRow - sourceEnd - 1
+                    : destinationRow - sourceStart;
+        } else if (sourceEnd < row && row < destinationRow) {
+            row -= count;
+        } else if (destinationRow <= row && row < sourceStart) {
+            row += count;
+        }
+        cache.insert(row, it.value());
     }
+
+    m_cache = cache;
 }
 
 void ItemDelegate::rowsInserted(const QModelIndex &, int start, int end)
 {
-    for( int i = start; i <= end; ++i )
-        m_cache.insert(i, nullptr);
+    const int count = end - start + 1;
+
+    // Only rows with widgets are stored so this is fast even for many items.
+    QMap<int, ItemWidget*> cache;
+    for (auto it = m_cache.constBegin(); it != m_cache.constEnd(); ++it) {
+        const int row = it.key();
+        cache.insert(row < start ? row : row + count, it.value());
+    }
+
+    m_cache = cache;
 }
 
 ItemWidget *ItemDelegate::cache(const QModelIndex &index)
 {
-    int n = index.row();
-
-    ItemWidget *w = m_cache[n];
+    ItemWidget *w = m_cache.value(index.row(), nullptr);
     if (w == nullptr) {
         QWidget *parent = m_view->viewport();
         w = m_createSimpleItems
@@ -170,7 +188,7 @@ ItemWidget *ItemDelegate::cache(const QModelIndex &index)
 
 bool ItemDelegate::hasCache(const QModelIndex &index) const
 {
-    return m_cache[index.row()] != nullptr;
+    return m_cache.contains( index.row() );
 }
 
 void ItemDelegate::setItemSizes(const QSize &size, int idealWidth)
@@ -179,15 +197,13 @@ void ItemDelegate::setItemSizes(const QSize &size, int idealWidth)
     m_maxSize.setWidth(size.width() - margins);
     m_idealWidth = idealWidth - margins;
 
-    for(auto w : m_cache) {
-        if (w != nullptr)
-            w->updateSize(m_maxSize, m_idealWidth);
-    }
+    for (auto w : m_cache)
+        w->updateSize(m_maxSize, m_idealWidth);
 }
 
 void ItemDelegate::setRowVisible(int row, bool visible)
 {
-    ItemWidget *w = m_cache[row];
+    ItemWidget *w = m_cache.value(row, nullptr);
     if (w != nullptr) {
         if (visible)
             highlightMatches(w);
@@ -196,7 +212,7 @@ void ItemDelegate::setRowVisible(int row, bool visible)
 
 bool ItemDelegate::otherItemLoader(const QModelIndex &index, bool next)
 {
-    ItemWidget *w = m_cache[index.row()];
+    ItemWidget *w = m_cache.value(index.row(), nullptr);
     if (w != nullptr) {
         ItemWidget *w2 = m_itemFactory->otherItemLoader(index, w, next, m_antialiasing);
         if (w2 != nullptr) {
@@ -211,8 +227,7 @@ bool ItemDelegate::otherItemLoader(const QModelIndex &index, bool next)
 ItemEditorWidget *ItemDelegate::createCustomEditor(QWidget *parent, const QModelIndex &index,
                                                    bool editNotes)
 {
-    cache(index);
-    ItemEditorWidget *editor = new ItemEditorWidget(m_cache[index.row()], index, editNotes, parent);
+    ItemEditorWidget *editor = new ItemEditorWidget(cache(index), index, editNotes, parent);
     loadEditorSettings(editor);
     return editor;
 }
@@ -232,7 +247,7 @@ void ItemDelegate::highlightMatches(ItemWidget *itemWidget) const
 void ItemDelegate::currentChanged(const QModelIndex &, const QModelIndex &previous)
 {
     if ( previous.isValid() ) {
-        auto w = m_cache[previous.row()];
+        auto w = m_cache.value(previous.row(), nullptr);
         if (w)
             w->widget()->hide();
     }
@@ -240,7 +255,7 @@ void ItemDelegate::currentChanged(const QModelIndex &, const QModelIndex &previo
 
 void ItemDelegate::setIndexWidget(const QModelIndex &index, ItemWidget *w)
 {
-    reset(&m_cache[index.row()], w);
+    setCachedWidget(index.row(), w);
     if (w == nullptr)
         return;
 
@@ -271,13 +286,20 @@ int ItemDelegate::rowNumberHeight() const
 
 void ItemDelegate::invalidateCache()
 {
-    for(auto &w : m_cache)
-        reset(&w);
+    qDeleteAll(m_cache);
+    m_cache.clear();
 }
 
 void ItemDelegate::invalidateCache(int row)
 {
-    reset(&m_cache[row]);
+    setCachedWidget(row, nullptr);
+}
+
+void ItemDelegate::setCachedWidget(int row, ItemWidget *w)
+{
+    delete m_cache.take(row);
+    if (w != nullptr)
+        m_cache.insert(row, w);
 }
 
 void ItemDelegate::setSearch(const QRegExp &re)
@@ -323,7 +345,7 @@ void ItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
                          const QModelIndex &index) const
 {
     const int row = index.row();
-    auto w = m_cache[row];
+    auto w = m_cache.value(row, nullptr);
     if (w == nullptr) {
         m_view->itemWidget(index);
         return;
@@ -23,6 +23,7 @@
 #include "gui/theme.h"
 
 #include <QItemDelegate>
+#include <QMap>
 #include <QRegExp>
 
 class Item;
@@ -41,6 +42,10 @@ class ClipboardBrowser;
  *
  * Before calling paint() for an index item on given index must be cached
  * using cache().
+ *
+ * Only items with created widgets are cached so memory and time needed to
+ * update cache after rows are inserted, removed or moved don't depend on
+ * number of items in model.
  */
 class ItemDelegate : public QItemDelegate
 {
@@ -134,6 +139,9 @@ class ItemDelegate : public QItemDelegate
     private:
         void setIndexWidget(const QModelIndex &index, ItemWidget *w);
 
+        /** Replace (and delete) cached widget for row. */
+        void setCachedWidget(int row, ItemWidget *w);
+
         int rowNumberWidth() const;
         int rowNumberHeight() const;
 
@@ -157,7 +165,8 @@ class ItemDelegate : public QItemDelegate
         bool m_antialiasing;
         bool m_createSimpleItems;
 
-        QList<ItemWidget*> m_cache;
+        /// Maps row to item widget.
+        QMap<int, ItemWidget*> m_cache;
 
         Theme m_theme;
 };
@@ -24,6 +24,8 @@
 #include "common/contenttype.h"
 #include "common/log.h"
 #include "common/mimetypes.h"
+#include "common/textmatcher.h"
+#include "item/itemjournal.h"
 #include "item/itemwidget.h"
 #include "item/serialize.h"
 #include "platform/platformnativeinterface.h"
@@ -35,6 +37,7 @@
 #include <QMetaObject>
 #include <QModelIndex>
 #include <QPluginLoader>
+#include <QTextDocumentFragment>
 
 #include <algorithm>
 
@@ -166,10 +169,48 @@ private:
 class DummySaver : public ItemSaverInterface
 {
 public:
+    explicit DummySaver(QAbstractItemModel *model)
+        : m_model(model)
+        , m_journal(model)
+    {
+    }
+
     bool saveItems(const QAbstractItemModel &model, QIODevice *file) override
     {
-        return serializeData(model, file);
+        if ( !serializeData(model, file) )
+            return false;
+
+        // Journal is cleared in prepareSaveItemsInBackground() if saving copy of items.
+        if (&model == m_model)
+            m_journal.clear();
+
+        return true;
+    }
+
+    bool prepareSaveItemsInBackground() override
+    {
+        m_journal.clear();
+        return true;
+    }
+
+    bool storesPlainData() const override
+    {
+        return true;
+    }
+
+    bool saveChanges(const QAbstractItemModel &, QIODevice *file) override
+    {
+        return m_journal.save(file);
+    }
+
+    bool loadChanges(QAbstractItemModel *model, QIODevice *file) override
+    {
+        return ItemJournal::load(model, file);
     }
+
+private:
+    const QAbstractItemModel *m_model;
+    ItemJournal m_journal;
 };
 
 class DummyLoader : public ItemLoaderInterface
@@ -198,18 +239,22 @@ public:
             }
         }
 
-        return std::make_shared<DummySaver>();
+        return std::make_shared<DummySaver>(model);
     }
 
-    ItemSaverPtr initializeTab(QAbstractItemModel *) override
+    ItemSaverPtr initializeTab(QAbstractItemModel *model) override
     {
-        return std::make_shared<DummySaver>();
+        return std::make_shared<DummySaver>(model);
     }
 
-    bool matches(const QModelIndex &index, const QRegExp &re) const override
+    QString searchableText(const QModelIndex &index) const override
     {
         const QString text = index.data(contentType::text).toString();
-        return re.indexIn(text) != -1;
+        if ( !text.isEmpty() || !index.data(contentType::hasHtml).toBool() )
+            return text;
+
+        const QString html = index.data(contentType::html).toString();
+        return QTextDocumentFragment::fromHtml(html).toPlainText();
     }
 };
 
@@ -404,9 +449,10 @@ ItemSaverPtr ItemFactory::initializeTab(QAbstractItemModel *model)
     return nullptr;
 }
 
-bool ItemFactory::matches(const QModelIndex &index, const QRegExp &re) const
+bool ItemFactory::matches(const QModelIndex &index, const TextMatcher &matcher) const
 {
     // Match formats if the filter expression contains single '/'.
+    const QRegExp &re = matcher.regExp();
     if (re.pattern().count('/') == 1) {
         const QVariantMap data = index.data(contentType::data).toMap();
         for (const auto &format : data.keys()) {
@@ -415,12 +461,30 @@ bool ItemFactory::matches(const QModelIndex &index, const QRegExp &re) const
         }
     }
 
+    const QVariant cachedTexts = index.data(contentType::searchableTexts);
+    const QStringList texts = cachedTexts.isValid()
+            ? cachedTexts.toStringList() : searchableTexts(index);
+
+    return matcher.matchesAny(texts);
+}
+
+QString ItemFactory::searchableText(const QModelIndex &index) const
+{
+    return searchableTexts(index).join("\n");
+}
+
+QStringList ItemFactory::searchableTexts(const QModelIndex &index) const
+{
+    QStringList texts;
     for ( const auto &loader : enabledLoaders() ) {
-        if ( isLoaderEnabled(loader) && loader->matches(index, re) )
-            return true;
+        if ( isLoaderEnabled(loader) ) {
+            const QString text = loader->searchableText(index);
+            if ( !text.isEmpty() )
+                texts.append(text);
+        }
     }
 
-    return false;
+    return texts;
 }
 
 QList<ItemScriptable*> ItemFactory::scriptableObjects(QObject *parent) const
@@ -35,6 +35,7 @@ class QAbstractItemModel;
 class QIODevice;
 class QModelIndex;
 class QWidget;
+class TextMatcher;
 struct Command;
 struct CommandMenu;
 
@@ -127,9 +128,25 @@ public:
     ItemSaverPtr initializeTab(QAbstractItemModel *model);
 
     /**
-     * Return true only if any plugin (ItemLoaderInterface::matches()) returns true;
+     * Return true only if any searchable text of item (cached in model if
+     * possible, see contentType::searchableTexts) contains match.
      */
-    bool matches(const QModelIndex &index, const QRegExp &re) const;
+    bool matches(const QModelIndex &index, const TextMatcher &matcher) const;
+
+    /**
+     * Return text of item from all plugins (ItemLoaderInterface::searchableText()).
+     */
+    QString searchableText(const QModelIndex &index) const;
+
+    /**
+     * Return non-empty texts of item from each plugin.
+     *
+     * Item matches the same expressions as with matches() if any of the
+     * texts matches (except formats).
+     *
+     * Texts for HTML items without plain text are stripped of HTML tags.
+     */
+    QStringList searchableTexts(const QModelIndex &index) const;
 
     QList<ItemScriptable *> scriptableObjects(QObject *parent) const;
 
@@ -0,0 +1,216 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemfiltermatches.h"
+
+#include <QAbstractItemModel>
+
+namespace {
+
+bool isSpecialCharacter(QChar c)
+{
+    return QString("\\^$.|?*+()[]{}").contains(c);
+}
+
+/**
+ * Return true if @a pattern contains only literal characters (possibly escaped)
+ * and, with @a allowAnyText, ".*".
+ *
+ * Literal characters are appended to @a text.
+ */
+bool parseLiteralPattern(const QString &pattern, bool allowAnyText, QString *text = nullptr)
+{
+    for (int i = 0; i < pattern.size(); ++i) {
+        const QChar c = pattern[i];
+        if (c == '\\') {
+            // Only escaped special characters (not \w, \x0041 etc.).
+            if ( ++i == pattern.size() || pattern[i].isLetterOrNumber() )
+                return false;
+            if (text)
+                text->append(pattern[i]);
+        } else if (allowAnyText && c == '.' && i + 1 < pattern.size() && pattern[i + 1] == '*') {
+            ++i;
+        } else if ( isSpecialCharacter(c) ) {
+            return false;
+        } else if (text) {
+            text->append(c);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Return true if appending text to regular expression @a pattern can only
+ * restrict matched text.
+ */
+bool canAppendToPattern(const QString &pattern)
+{
+    for (int i = 0; i < pattern.size(); ++i) {
+        const QChar c = pattern[i];
+        if (c == '\\') {
+            // Character codes could change by appending digits.
+            if ( ++i == pattern.size() || pattern[i] == 'x' || pattern[i].isDigit() )
+                return false;
+        } else if (c == '|') {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool isRegExpRefinement(const QString &previous, const QString &pattern, Qt::CaseSensitivity cs)
+{
+    if ( pattern.startsWith(previous) ) {
+        return canAppendToPattern(previous)
+            && parseLiteralPattern(pattern.mid(previous.size()), true);
+    }
+
+    QString previousText;
+    QString text;
+    return parseLiteralPattern(previous, false, &previousText)
+        && parseLiteralPattern(pattern, false, &text)
+        && text.contains(previousText, cs);
+}
+
+/// Insert @a count set bits at @a first (shifts following bits).
+void insertBits(QBitArray *bits, int first, int count)
+{
+    const int oldSize = bits->size();
+    bits->resize(oldSize + count);
+    for (int i = oldSize - 1; i >= first; --i)
+        bits->setBit( i + count, bits->testBit(i) );
+    bits->fill(true, first, first + count);
+}
+
+/// Remove @a count bits at @a first (shifts following bits).
+void removeBits(QBitArray *bits, int first, int count)
+{
+    const int newSize = bits->size() - count;
+    for (int i = first; i < newSize; ++i)
+        bits->setBit( i, bits->testBit(i + count) );
+    bits->resize(newSize);
+}
+
+} // namespace
+
+bool isFilterRefinement(const QRegExp &previous, const QRegExp &re)
+{
+    if ( previous.isEmpty() || !previous.isValid() || !re.isValid() )
+        return false;
+
+    if ( previous.patternSyntax() != re.patternSyntax()
+         || previous.caseSensitivity() != re.caseSensitivity() )
+    {
+        return false;
+    }
+
+    // Formats are matched for filter with single '/' (see ItemFactory::matches()).
+    if ( previous.pattern().count('/') == 1 || re.pattern().count('/') == 1 )
+        return false;
+
+    switch ( re.patternSyntax() ) {
+    case QRegExp::RegExp:
+    case QRegExp::RegExp2:
+        return isRegExpRefinement( previous.pattern(), re.pattern(), re.caseSensitivity() );
+    case QRegExp::FixedString:
+        return re.pattern().contains( previous.pattern(), re.caseSensitivity() );
+    default:
+        return false;
+    }
+}
+
+ItemFilterMatches::ItemFilterMatches(QObject *parent)
+    : QObject(parent)
+    , m_model()
+    , m_re()
+    , m_candidates()
+{
+}
+
+void ItemFilterMatches::setMatches(QAbstractItemModel *model, const QRegExp &re, const QBitArray &rows)
+{
+    clear();
+
+    m_model = model;
+    m_re = re;
+
+    // Rows after the tested ones can match.
+    const int rowCount = model->rowCount();
+    m_candidates = rows;
+    m_candidates.resize(rowCount);
+    if ( rows.size() < rowCount )
+        m_candidates.fill(true, rows.size(), rowCount);
+
+    // Added and changed items haven't been tested.
+    connect( model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+             this, SLOT(onRowsInserted(QModelIndex,int,int)) );
+    connect( model, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+             this, SLOT(onRowsRemoved(QModelIndex,int,int)) );
+    connect( model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+             this, SLOT(onDataChanged(QModelIndex,QModelIndex)) );
+    connect( model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+             this, SLOT(clear()) );
+    connect( model, SIGNAL(modelReset()),
+             this, SLOT(clear()) );
+    connect( model, SIGNAL(layoutChanged()),
+             this, SLOT(clear()) );
+}
+
+bool ItemFilterMatches::findCandidateRows(
+        QAbstractItemModel *model, const QRegExp &re, QBitArray *rows) const
+{
+    if ( m_model.isNull() || m_model != model || !isFilterRefinement(m_re, re) )
+        return false;
+
+    if ( m_candidates.size() != model->rowCount() )
+        return false;
+
+    *rows = m_candidates;
+    return true;
+}
+
+void ItemFilterMatches::clear()
+{
+    if (m_model)
+        m_model->disconnect(this);
+
+    m_model = nullptr;
+    m_re = QRegExp();
+    m_candidates.clear();
+}
+
+void ItemFilterMatches::onRowsInserted(const QModelIndex &, int first, int last)
+{
+    insertBits(&m_candidates, first, last - first + 1);
+}
+
+void ItemFilterMatches::onRowsRemoved(const QModelIndex &, int first, int last)
+{
+    removeBits(&m_candidates, first, last - first + 1);
+}
+
+void ItemFilterMatches::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    const int first = qMax(0, topLeft.row());
+    const int end = bottomRight.isValid() ? qMin(bottomRight.row() + 1, m_candidates.size()) : first;
+    if (first < end)
+        m_candidates.fill(true, first, end);
+}
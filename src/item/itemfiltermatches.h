@@ -0,0 +1,85 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMFILTERMATCHES_H
+#define ITEMFILTERMATCHES_H
+
+#include <QBitArray>
+#include <QObject>
+#include <QPointer>
+#include <QRegExp>
+
+class QAbstractItemModel;
+class QModelIndex;
+
+/**
+ * Return true only if any text matched by @a re is also matched by @a previous
+ * (e.g. a character was appended to a simple pattern).
+ *
+ * Returns false if this cannot be easily determined.
+ */
+bool isFilterRefinement(const QRegExp &previous, const QRegExp &re);
+
+/**
+ * Items matching the last filter.
+ *
+ * If the next filter only narrows the last one, only the matching items need
+ * to be tested again.
+ *
+ * Added and changed items are tested again. Matches are forgotten if items
+ * are moved.
+ */
+class ItemFilterMatches : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ItemFilterMatches(QObject *parent = nullptr);
+
+    /**
+     * Remember @a rows in @a model matching @a re (set bits in @a rows).
+     *
+     * Rows after the end of @a rows were not tested and can match.
+     */
+    void setMatches(QAbstractItemModel *model, const QRegExp &re, const QBitArray &rows);
+
+    /**
+     * Set bits in @a rows for items which can match @a re.
+     *
+     * @return false if any item can match (@a re doesn't narrow the last filter)
+     */
+    bool findCandidateRows(QAbstractItemModel *model, const QRegExp &re, QBitArray *rows) const;
+
+public slots:
+    /** Forget matches. */
+    void clear();
+
+private slots:
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+private:
+    QPointer<QAbstractItemModel> m_model;
+    QRegExp m_re;
+    /// Bit is set for each row which matched the last filter or wasn't tested.
+    QBitArray m_candidates;
+};
+
+#endif // ITEMFILTERMATCHES_H
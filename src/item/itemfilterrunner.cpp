@@ -0,0 +1,224 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemfilterrunner.h"
+
+#include "common/fuzzymatcher.h"
+#include "common/textmatcher.h"
+
+#include <QBitArray>
+#include <QMetaObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegExp>
+#include <QRunnable>
+#include <QThreadPool>
+
+#include <atomic>
+
+namespace {
+
+/// Number of items matched in single task.
+const int chunkSize = 512;
+
+int lastJobId = 0;
+
+} // namespace
+
+/**
+ * Data shared by filter tasks.
+ *
+ * Texts are not modified after tasks are started. Each task writes only
+ * its own result.
+ */
+struct ItemFilterJob {
+    int id = 0;
+    QVector<QStringList> texts;
+    std::vector<QBitArray> results;
+
+    /// Best scored item and its score for each chunk (only for fuzzy filter).
+    std::vector<int> bestMatches;
+    std::vector<int> bestScores;
+    std::atomic<bool> cancelled{false};
+
+    QMutex receiverMutex;
+    ItemFilterRunner *receiver = nullptr;
+};
+
+namespace {
+
+class ItemFilterTask : public QRunnable
+{
+public:
+    ItemFilterTask(
+            const std::shared_ptr<ItemFilterJob> &job, const QRegExp &re,
+            const FuzzyMatcher &fuzzyMatcher, int chunk)
+        : m_job(job)
+        , m_matcher( copyRegExp(re) )
+        , m_fuzzyMatcher(fuzzyMatcher)
+        , m_chunk(chunk)
+    {
+    }
+
+    void run() override
+    {
+        const QVector<QStringList> &texts = m_job->texts;
+        const int first = m_chunk * chunkSize;
+        const int count = qMin(chunkSize, texts.size() - first);
+
+        QBitArray matches(count);
+        int bestMatch = -1;
+        int bestScore = -1;
+        for (int i = 0; i < count; ++i) {
+            if (m_job->cancelled)
+                return;
+
+            if ( m_fuzzyMatcher.isEmpty() ) {
+                if ( m_matcher.matchesAny(texts[first + i]) )
+                    matches.setBit(i);
+            } else {
+                // Item matches fuzzy filter only if it has a score.
+                const int score = m_fuzzyMatcher.score(texts[first + i]);
+                if (score >= 0)
+                    matches.setBit(i);
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestMatch = first + i;
+                }
+            }
+        }
+
+        m_job->results[m_chunk] = matches;
+        m_job->bestMatches[m_chunk] = bestMatch;
+        m_job->bestScores[m_chunk] = bestScore;
+
+        QMutexLocker lock(&m_job->receiverMutex);
+        if (m_job->receiver) {
+            QMetaObject::invokeMethod(
+                        m_job->receiver, "onChunkFinished", Qt::QueuedConnection,
+                        Q_ARG(int, m_job->id), Q_ARG(int, m_chunk) );
+        }
+    }
+
+private:
+    static QRegExp copyRegExp(const QRegExp &re)
+    {
+        QRegExp copy(re.pattern(), re.caseSensitivity(), re.patternSyntax());
+        copy.setMinimal( re.isMinimal() );
+        return copy;
+    }
+
+    std::shared_ptr<ItemFilterJob> m_job;
+    TextMatcher m_matcher;
+    FuzzyMatcher m_fuzzyMatcher;
+    int m_chunk;
+};
+
+} // namespace
+
+ItemFilterRunner::ItemFilterRunner(QObject *parent)
+    : QObject(parent)
+    , m_job()
+    , m_finishedChunks()
+    , m_nextChunk(0)
+{
+}
+
+ItemFilterRunner::~ItemFilterRunner()
+{
+    cancel();
+}
+
+void ItemFilterRunner::start(const QRegExp &re, const QVector<QStringList> &texts, bool scoreFuzzyMatches)
+{
+    cancel();
+
+    const int chunkCount = (texts.size() + chunkSize - 1) / chunkSize;
+    if (chunkCount == 0) {
+        emit finished();
+        return;
+    }
+
+    m_job = std::make_shared<ItemFilterJob>();
+    m_job->id = ++lastJobId;
+    m_job->texts = texts;
+    m_job->results.resize(chunkCount);
+    m_job->bestMatches.assign(chunkCount, -1);
+    m_job->bestScores.assign(chunkCount, -1);
+    m_job->receiver = this;
+
+    m_finishedChunks.assign(chunkCount, false);
+    m_nextChunk = 0;
+
+    // Tasks are started in order so first items are matched first.
+    // Regular expression is copied here since copying QRegExp in multiple threads is not safe.
+    const FuzzyMatcher fuzzyMatcher = FuzzyMatcher::fromRegExp( scoreFuzzyMatches ? re : QRegExp() );
+    for (int chunk = 0; chunk < chunkCount; ++chunk)
+        QThreadPool::globalInstance()->start( new ItemFilterTask(m_job, re, fuzzyMatcher, chunk) );
+}
+
+void ItemFilterRunner::cancel()
+{
+    if (!m_job)
+        return;
+
+    m_job->cancelled = true;
+    {
+        QMutexLocker lock(&m_job->receiverMutex);
+        m_job->receiver = nullptr;
+    }
+    m_job.reset();
+    m_finishedChunks.clear();
+}
+
+bool ItemFilterRunner::isRunning() const
+{
+    return m_job != nullptr;
+}
+
+void ItemFilterRunner::onChunkFinished(int jobId, int chunk)
+{
+    if (!m_job || m_job->id != jobId)
+        return;
+
+    m_finishedChunks[chunk] = true;
+
+    // Keep the job alive even if canceled from a slot connected to filtered().
+    const auto job = m_job;
+    while ( m_nextChunk < static_cast<int>(m_finishedChunks.size()) && m_finishedChunks[m_nextChunk] ) {
+        const int first = m_nextChunk * chunkSize;
+        const int finishedChunk = m_nextChunk;
+        ++m_nextChunk;
+        emit filtered(first, job->results[finishedChunk]);
+        if (m_job != job)
+            return;
+
+        if (job->bestMatches[finishedChunk] != -1) {
+            emit bestMatchFound(job->bestMatches[finishedChunk], job->bestScores[finishedChunk]);
+            if (m_job != job)
+                return;
+        }
+    }
+
+    if ( m_nextChunk == static_cast<int>(m_finishedChunks.size()) ) {
+        m_job.reset();
+        m_finishedChunks.clear();
+        emit finished();
+    }
+}
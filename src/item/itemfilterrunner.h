@@ -0,0 +1,89 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMFILTERRUNNER_H
+#define ITEMFILTERRUNNER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+class QBitArray;
+class QRegExp;
+struct ItemFilterJob;
+
+/**
+ * Matches copies of item texts with regular expression in worker threads.
+ *
+ * Items are split into chunks which are processed in parallel (in global
+ * QThreadPool). Results are emitted in order starting from the first item.
+ */
+class ItemFilterRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ItemFilterRunner(QObject *parent = nullptr);
+
+    ~ItemFilterRunner();
+
+    /**
+     * Start matching items with @a re (cancels current filtering).
+     *
+     * Item matches if any of its @a texts matches.
+     *
+     * If @a scoreFuzzyMatches is true and @a re was created by FuzzyMatcher::regExp(),
+     * matching items are also scored and bestMatchFound() is emitted.
+     */
+    void start(const QRegExp &re, const QVector<QStringList> &texts, bool scoreFuzzyMatches = false);
+
+    /** Stop filtering (no more results are emitted). */
+    void cancel();
+
+    bool isRunning() const;
+
+signals:
+    /**
+     * Emitted with results for consecutive items starting with item at @a first.
+     * Bit is set for each matching item.
+     */
+    void filtered(int first, const QBitArray &matches);
+
+    /**
+     * Emitted after filtered() with the best scored @a item from the results
+     * (only for fuzzy filter, first item wins if scores are same).
+     */
+    void bestMatchFound(int item, int score);
+
+    /** Emitted after all results are emitted. */
+    void finished();
+
+private slots:
+    void onChunkFinished(int jobId, int chunk);
+
+private:
+    std::shared_ptr<ItemFilterJob> m_job;
+    std::vector<bool> m_finishedChunks;
+    int m_nextChunk;
+};
+
+#endif // ITEMFILTERRUNNER_H
@@ -0,0 +1,256 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemjournal.h"
+
+#include "common/contenttype.h"
+#include "item/serialize.h"
+
+#include <QAbstractItemModel>
+#include <QDataStream>
+#include <QIODevice>
+
+namespace {
+
+enum ChangeType {
+    ItemsInserted = 1,
+    ItemsRemoved = 2,
+    ItemsMoved = 3,
+    ItemChanged = 4
+};
+
+QVariantMap itemData(const QAbstractItemModel &model, int row)
+{
+    return model.data( model.index(row, 0), contentType::data ).toMap();
+}
+
+bool moveRows(QAbstractItemModel *model, int row, int count, int destinationRow)
+{
+    if ( row < 0 || count <= 0 || destinationRow < 0 || row + count > model->rowCount() )
+        return false;
+
+#if QT_VERSION < 0x050000
+    // Move items one by one using ClipboardModel::moveRow() slot.
+    for (int i = 0; i < count; ++i) {
+        const int from = destinationRow < row ? row + i : row;
+        const int to = destinationRow < row ? destinationRow + i : destinationRow;
+        if ( !QMetaObject::invokeMethod(model, "moveRow", Q_ARG(int, from), Q_ARG(int, to)) )
+            return false;
+    }
+    return true;
+#else
+    return model->moveRows(QModelIndex(), row, count, QModelIndex(), destinationRow);
+#endif
+}
+
+} // namespace
+
+ItemJournal::ItemJournal(QAbstractItemModel *model)
+    : QObject()
+    , m_model(model)
+    , m_changes()
+{
+    connect( model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+             SLOT(onRowsInserted(QModelIndex,int,int)) );
+    connect( model, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+             SLOT(onRowsRemoved(QModelIndex,int,int)) );
+    connect( model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+             SLOT(onRowsMoved(QModelIndex,int,int,QModelIndex,int)) );
+    connect( model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+             SLOT(onDataChanged(QModelIndex,QModelIndex)) );
+}
+
+bool ItemJournal::save(QIODevice *file)
+{
+    if (!m_model)
+        return false;
+
+    // Saving all items is cheaper than applying too many changes later.
+    if ( m_changes.size() > m_model->rowCount() )
+        return false;
+
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    for (const auto &change : m_changes) {
+        stream << static_cast<qint8>(change.type) << static_cast<qint32>(change.row);
+
+        if (change.type == ItemsInserted) {
+            stream << static_cast<qint32>( change.items.size() );
+            for (const auto &data : change.items)
+                serializeData(&stream, data, true);
+        } else if (change.type == ItemsRemoved) {
+            stream << static_cast<qint32>(change.count);
+        } else if (change.type == ItemsMoved) {
+            stream << static_cast<qint32>(change.count)
+                   << static_cast<qint32>(change.destinationRow);
+        } else if (change.type == ItemChanged) {
+            serializeData( &stream, change.items.value(0), true );
+        }
+    }
+
+    if ( stream.status() != QDataStream::Ok )
+        return false;
+
+    clear();
+    return true;
+}
+
+void ItemJournal::clear()
+{
+    m_changes.clear();
+}
+
+bool ItemJournal::load(QAbstractItemModel *model, QIODevice *file)
+{
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    qint8 type;
+    qint32 row;
+    qint32 count;
+    qint32 destinationRow;
+
+    while ( !stream.atEnd() ) {
+        stream >> type >> row;
+        if ( stream.status() != QDataStream::Ok || row < 0 )
+            return false;
+
+        if (type == ItemsInserted) {
+            stream >> count;
+            if ( stream.status() != QDataStream::Ok || count <= 0 || row > model->rowCount() )
+                return false;
+
+            // Read whole record first so a truncated record is not applied.
+            QList<QVariantMap> items;
+            for (int i = 0; i < count; ++i) {
+                QVariantMap data;
+                deserializeData(&stream, &data);
+                if ( stream.status() != QDataStream::Ok )
+                    return false;
+                items.append(data);
+            }
+
+            if ( !model->insertRows(row, count) )
+                return false;
+
+            for (int i = 0; i < count; ++i)
+                model->setData( model->index(row + i, 0), items[i], contentType::data );
+        } else if (type == ItemsRemoved) {
+            stream >> count;
+            if ( stream.status() != QDataStream::Ok || !model->removeRows(row, count) )
+                return false;
+        } else if (type == ItemsMoved) {
+            stream >> count >> destinationRow;
+            if ( stream.status() != QDataStream::Ok || !moveRows(model, row, count, destinationRow) )
+                return false;
+        } else if (type == ItemChanged) {
+            QVariantMap data;
+            deserializeData(&stream, &data);
+            if ( stream.status() != QDataStream::Ok || row >= model->rowCount() )
+                return false;
+
+            model->setData( model->index(row, 0), data, contentType::data );
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ItemJournal::onRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if ( parent.isValid() || !m_model )
+        return;
+
+    Change change;
+    change.type = ItemsInserted;
+    change.row = first;
+    for (int row = first; row <= last; ++row)
+        change.items.append( itemData(*m_model, row) );
+
+    append(change);
+}
+
+void ItemJournal::onRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    if ( parent.isValid() )
+        return;
+
+    Change change;
+    change.type = ItemsRemoved;
+    change.row = first;
+    change.count = last - first + 1;
+
+    append(change);
+}
+
+void ItemJournal::onRowsMoved(
+        const QModelIndex &parent, int first, int last,
+        const QModelIndex &destination, int destinationRow)
+{
+    if ( parent.isValid() || destination.isValid() )
+        return;
+
+    Change change;
+    change.type = ItemsMoved;
+    change.row = first;
+    change.count = last - first + 1;
+    change.destinationRow = destinationRow;
+
+    append(change);
+}
+
+void ItemJournal::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if ( !m_model || topLeft.parent().isValid() )
+        return;
+
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        Change change;
+        change.type = ItemChanged;
+        change.row = row;
+        change.items.append( itemData(*m_model, row) );
+
+        append(change);
+    }
+}
+
+void ItemJournal::append(const Change &change)
+{
+    if ( change.type == ItemChanged && !m_changes.isEmpty() ) {
+        Change &last = m_changes.last();
+
+        // Keep only the latest data of repeatedly changed item.
+        if (last.type == ItemChanged && last.row == change.row) {
+            last.items = change.items;
+            return;
+        }
+
+        // Update data of recently inserted item (e.g. after QAbstractItemModel::insertRows()).
+        const int insertedRow = change.row - last.row;
+        if ( last.type == ItemsInserted && insertedRow >= 0 && insertedRow < last.items.size() ) {
+            last.items[insertedRow] = change.items.value(0);
+            return;
+        }
+    }
+
+    m_changes.append(change);
+}
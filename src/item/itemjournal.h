@@ -0,0 +1,88 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMJOURNAL_H
+#define ITEMJOURNAL_H
+
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QVariantMap>
+
+class QAbstractItemModel;
+class QIODevice;
+class QModelIndex;
+
+/**
+ * Records changes in model so these can be appended to a journal file
+ * instead of saving all items again.
+ *
+ * Journal can be later applied on items loaded from last saved tab file.
+ */
+class ItemJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ItemJournal(QAbstractItemModel *model);
+
+    /**
+     * Append recorded changes to @a file and forget them.
+     *
+     * @return false if saving all items is cheaper or changes cannot be saved
+     */
+    bool save(QIODevice *file);
+
+    /**
+     * Forget recorded changes (e.g. after all items were saved).
+     */
+    void clear();
+
+    /**
+     * Apply changes from journal @a file on @a model.
+     *
+     * Model signals should be blocked so the changes are not recorded again.
+     *
+     * @return true only if all changes were applied
+     */
+    static bool load(QAbstractItemModel *model, QIODevice *file);
+
+private slots:
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsMoved(const QModelIndex &parent, int first, int last,
+                     const QModelIndex &destination, int destinationRow);
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+private:
+    struct Change {
+        int type = 0;
+        int row = 0;
+        int count = 0;
+        int destinationRow = 0;
+        QList<QVariantMap> items;
+    };
+
+    void append(const Change &change);
+
+    QPointer<QAbstractItemModel> m_model;
+    QList<Change> m_changes;
+};
+
+#endif // ITEMJOURNAL_H
@@ -0,0 +1,429 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itempayload.h"
+
+#include "common/log.h"
+#include "item/itemblobstore.h"
+#include "item/itemdata.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QList>
+#include <QMutexLocker>
+
+/**
+ * Tab file mapped into memory.
+ *
+ * Mapping is shared by all payload files for unchanged tab file and kept until
+ * there are no users and all referenced data are released (i.e. no other
+ * QByteArray shares the data with the ones in views).
+ */
+struct ItemPayloadMapping {
+    QFile file;
+    uchar *data = nullptr;
+    qint64 size = 0;
+    qint64 lastModified = 0;
+    int users = 0;
+    QList<QByteArray> views;
+    int viewCountToRelease = 64;
+};
+
+namespace {
+
+QMutex payloadFilesMutex;
+QList<ItemPayloadFile*> payloadFiles;
+QList<ItemPayloadMapping*> mappings;
+
+/// Forget data no longer used outside the mapping.
+void releaseViews(ItemPayloadMapping *mapping)
+{
+    for (int i = mapping->views.size() - 1; i >= 0; --i) {
+        if ( mapping->views[i].isDetached() )
+            mapping->views.removeAt(i);
+    }
+
+    mapping->viewCountToRelease = qMax(64, 2 * mapping->views.size());
+}
+
+/// Unmap files without any users and referenced data (expects locked payloadFilesMutex).
+void releaseUnusedMappingsLocked()
+{
+    for (int i = mappings.size() - 1; i >= 0; --i) {
+        ItemPayloadMapping *mapping = mappings[i];
+        if (mapping->users > 0)
+            continue;
+
+        releaseViews(mapping);
+        if ( mapping->views.isEmpty() ) {
+            mapping->file.unmap(mapping->data);
+            mappings.removeAt(i);
+            delete mapping;
+        }
+    }
+}
+
+/// Map file or return existing mapping (expects locked payloadFilesMutex).
+ItemPayloadMapping *acquireMapping(const QString &fileName)
+{
+#ifdef Q_OS_WIN
+    // Mapped file couldn't be replaced when saving items.
+    Q_UNUSED(fileName);
+    return nullptr;
+#else
+    const QFileInfo fileInfo(fileName);
+    const qint64 lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    // Unmap old files before mapping a new one.
+    releaseUnusedMappingsLocked();
+
+    for (auto mapping : mappings) {
+        if ( mapping->file.fileName() == fileName
+             && mapping->size == fileInfo.size()
+             && mapping->lastModified == lastModified )
+        {
+            ++mapping->users;
+            return mapping;
+        }
+    }
+
+    auto mapping = new ItemPayloadMapping();
+    mapping->file.setFileName(fileName);
+    if ( mapping->file.open(QIODevice::ReadOnly) ) {
+        mapping->size = mapping->file.size();
+        mapping->data = mapping->file.map(0, mapping->size);
+    }
+
+    if (mapping->data == nullptr) {
+        log( QString("Failed to map item data file \"%1\": %2")
+             .arg(fileName, mapping->file.errorString()), LogWarning );
+        delete mapping;
+        return nullptr;
+    }
+
+    mapping->lastModified = lastModified;
+    mapping->users = 1;
+    mappings.append(mapping);
+
+    return mapping;
+#endif
+}
+
+/// Return true if any instance uses the file (expects locked payloadFilesMutex).
+bool isPayloadFileUsed(const QString &fileName)
+{
+    for (auto payloadFile : payloadFiles) {
+        if ( payloadFile->fileName() == fileName )
+            return true;
+    }
+
+    return false;
+}
+
+void releaseMapping(ItemPayloadMapping *mapping)
+{
+    QMutexLocker lock(&payloadFilesMutex);
+    --mapping->users;
+    releaseUnusedMappingsLocked();
+}
+
+} // namespace
+
+ItemPayloadFile::ItemPayloadFile(const QString &fileName, bool map)
+    : m_mutex()
+    , m_fileName(fileName)
+    , m_map(map)
+    , m_mapping(nullptr)
+    , m_temporary(false)
+{
+    QMutexLocker lock(&payloadFilesMutex);
+    payloadFiles.append(this);
+}
+
+ItemPayloadFile::~ItemPayloadFile()
+{
+    bool remove;
+    {
+        QMutexLocker lock(&payloadFilesMutex);
+        payloadFiles.removeOne(this);
+        // Other instances can use the same file (e.g. tab loaded again).
+        remove = m_temporary && !isPayloadFileUsed(m_fileName);
+    }
+
+    if (m_mapping)
+        releaseMapping(m_mapping);
+
+    if (remove)
+        QFile::remove(m_fileName);
+}
+
+void ItemPayloadFile::rename(const QString &oldFileName, const QString &newFileName)
+{
+    QMutexLocker lock(&payloadFilesMutex);
+    for (auto payloadFile : payloadFiles) {
+        if ( payloadFile->fileName() == oldFileName )
+            payloadFile->setFileName(newFileName);
+    }
+}
+
+bool ItemPayloadFile::retire(const QString &oldFileName, const QString &newFileName)
+{
+    QMutexLocker lock(&payloadFilesMutex);
+
+    bool used = false;
+    for (auto payloadFile : payloadFiles) {
+        if ( payloadFile->fileName() == oldFileName ) {
+            payloadFile->setFileName(newFileName);
+            payloadFile->setTemporary();
+            used = true;
+        }
+    }
+
+    return used;
+}
+
+bool ItemPayloadFile::isUsed(const QString &fileName)
+{
+    QMutexLocker lock(&payloadFilesMutex);
+    return isPayloadFileUsed(fileName);
+}
+
+void ItemPayloadFile::releaseUnusedMappings()
+{
+    QMutexLocker lock(&payloadFilesMutex);
+    releaseUnusedMappingsLocked();
+}
+
+int ItemPayloadFile::mappedFileCount()
+{
+    QMutexLocker lock(&payloadFilesMutex);
+    return mappings.size();
+}
+
+void ItemPayloadFile::setTemporary()
+{
+    QMutexLocker lock(&m_mutex);
+    m_temporary = true;
+}
+
+QString ItemPayloadFile::fileName() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_fileName;
+}
+
+bool ItemPayloadFile::mappedData(qint64 offset, qint32 size, QByteArray *bytes) const
+{
+    QMutexLocker lock(&payloadFilesMutex);
+
+    // Map file when data are requested first time.
+    if (m_map && m_mapping == nullptr) {
+        m_mapping = acquireMapping( fileName() );
+        m_map = m_mapping != nullptr;
+    }
+
+    if (m_mapping == nullptr || offset < 0 || size < 0 || offset + size > m_mapping->size)
+        return false;
+
+    *bytes = QByteArray::fromRawData(
+                reinterpret_cast<const char*>(m_mapping->data + offset), size );
+
+    m_mapping->views.append(*bytes);
+    if (m_mapping->views.size() >= m_mapping->viewCountToRelease)
+        releaseViews(m_mapping);
+
+    return true;
+}
+
+void ItemPayloadFile::setFileName(const QString &fileName)
+{
+    QMutexLocker lock(&m_mutex);
+    m_fileName = fileName;
+}
+
+bool ItemEncodedCache::find(const QString &format, ItemEncodedFormat *encoded) const
+{
+    QMutexLocker lock(&m_mutex);
+    const auto it = m_formats.constFind(format);
+    if ( it == m_formats.constEnd() )
+        return false;
+
+    *encoded = it.value();
+    return true;
+}
+
+void ItemEncodedCache::insert(const QString &format, const ItemEncodedFormat &encoded)
+{
+    QMutexLocker lock(&m_mutex);
+    m_formats.insert(format, encoded);
+}
+
+qint64 ItemEncodedCache::byteCount(const ItemData &decoded) const
+{
+    QMutexLocker lock(&m_mutex);
+
+    qint64 result = 0;
+    for (auto it = m_formats.constBegin(); it != m_formats.constEnd(); ++it) {
+        const QByteArray &bytes = it.value().bytes;
+        const QByteArray *decodedBytes = decoded.find( it.key() );
+        if ( decodedBytes == nullptr || decodedBytes->constData() != bytes.constData() )
+            result += bytes.size();
+    }
+
+    return result;
+}
+
+namespace {
+
+bool readStoredPayload(QIODevice *device, const ItemPayload &payload, QByteArray *storedBytes)
+{
+    if ( !device->seek(payload.offset) )
+        return false;
+
+    *storedBytes = device->read(payload.size);
+    return storedBytes->size() == payload.size;
+}
+
+/// Return how the data are stored (data in blob files are not copied).
+ItemEncodedFormat encodedPayload(const ItemPayload &payload, const QByteArray &storedBytes)
+{
+    ItemEncodedFormat encoded;
+    encoded.payload.codec = payload.codec;
+    if ( payload.blobHash.isEmpty() ) {
+        encoded.bytes = storedBytes;
+    } else {
+        encoded.payload.offset = payload.offset;
+        encoded.payload.size = payload.size;
+        encoded.payload.blobHash = payload.blobHash;
+    }
+
+    return encoded;
+}
+
+/// Remember how the data are stored.
+void cacheEncodedPayload(
+        const QString &format, const ItemPayload &payload, const QByteArray &storedBytes,
+        ItemEncodedCache *cache)
+{
+    if (cache)
+        cache->insert( format, encodedPayload(payload, storedBytes) );
+}
+
+/// Open file for reading (tab file can be moved away meanwhile, see ItemPayloadFile::retire()).
+bool openPayloadFile(const ItemPayloadFile &payloadFile, QFile *file)
+{
+    if ( file->open(QIODevice::ReadOnly) )
+        return true;
+
+    const QString fileName = payloadFile.fileName();
+    if ( fileName == file->fileName() )
+        return false;
+
+    file->setFileName(fileName);
+    return file->open(QIODevice::ReadOnly);
+}
+
+} // namespace
+
+bool readPayload(QIODevice *device, const ItemPayload &payload, QByteArray *bytes)
+{
+    QByteArray storedBytes;
+    return readStoredPayload(device, payload, &storedBytes)
+        && decodeData(payload.codec, storedBytes, bytes);
+}
+
+bool loadPayloads(const ItemPayloads &payloads, QVariantMap *data, ItemEncodedCache *cache)
+{
+    QFile file;
+    bool result = true;
+
+    for ( auto it = payloads.constBegin(); it != payloads.constEnd(); ++it ) {
+        const ItemPayload &payload = it.value();
+
+        QByteArray bytes;
+        if ( payload.codec == CodecNone && payload.file->mappedData(payload.offset, payload.size, &bytes) ) {
+            data->insert( it.key(), payload.blobHash.isEmpty() ? bytes : internBlob(bytes, payload.blobHash) );
+            cacheEncodedPayload(it.key(), payload, bytes, cache);
+            continue;
+        }
+
+        const QString fileName = payload.file->fileName();
+
+        if ( file.fileName() != fileName ) {
+            file.close();
+            file.setFileName(fileName);
+            if ( !openPayloadFile(*payload.file, &file) ) {
+                log( QString("Failed to open item data file \"%1\": %2")
+                     .arg(file.fileName(), file.errorString()), LogError );
+                return false;
+            }
+        }
+
+        QByteArray storedBytes;
+        if ( readStoredPayload(&file, payload, &storedBytes)
+             && decodeData(payload.codec, storedBytes, &bytes) )
+        {
+            data->insert( it.key(), payload.blobHash.isEmpty() ? bytes : internBlob(bytes, payload.blobHash) );
+            cacheEncodedPayload(it.key(), payload, storedBytes, cache);
+        } else {
+            log( QString("Failed to read item data (format \"%1\") from file \"%2\"")
+                 .arg(it.key(), fileName), LogError );
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+bool readEncodedPayloads(const ItemPayloads &payloads, ItemEncodedFormats *encodedFormats)
+{
+    QFile file;
+
+    for ( auto it = payloads.constBegin(); it != payloads.constEnd(); ++it ) {
+        const ItemPayload &payload = it.value();
+
+        QByteArray storedBytes;
+        if ( payload.blobHash.isEmpty()
+             && !payload.file->mappedData(payload.offset, payload.size, &storedBytes) )
+        {
+            const QString fileName = payload.file->fileName();
+            if ( file.fileName() != fileName ) {
+                file.close();
+                file.setFileName(fileName);
+                if ( !openPayloadFile(*payload.file, &file) ) {
+                    log( QString("Failed to open item data file \"%1\": %2")
+                         .arg(file.fileName(), file.errorString()), LogError );
+                    return false;
+                }
+            }
+
+            if ( !readStoredPayload(&file, payload, &storedBytes) ) {
+                log( QString("Failed to read item data (format \"%1\") from file \"%2\"")
+                     .arg(it.key(), fileName), LogError );
+                return false;
+            }
+        }
+
+        encodedFormats->insert( it.key(), encodedPayload(payload, storedBytes) );
+    }
+
+    return true;
+}
@@ -0,0 +1,184 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMPAYLOAD_H
+#define ITEMPAYLOAD_H
+
+#include "item/itemcodec.h"
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVariantMap>
+
+#include <memory>
+
+class QByteArray;
+class ItemData;
+class QIODevice;
+struct ItemPayloadMapping;
+
+/**
+ * Tab file from which item data are loaded on demand.
+ *
+ * File is opened only while reading. If the tab file is replaced while
+ * items still use it, the old file is kept under other name until no
+ * longer used (see retire()).
+ *
+ * All existing instances are updated when the tab file is renamed.
+ *
+ * Optionally, the file can be mapped into memory so uncompressed data are
+ * not copied but only referenced (see mappedData()). Mapping is kept while
+ * any such data are in use (even after the file is replaced or removed).
+ */
+class ItemPayloadFile
+{
+public:
+    explicit ItemPayloadFile(const QString &fileName, bool map = false);
+
+    ~ItemPayloadFile();
+
+    /** Update file name for items loaded from renamed tab file. */
+    static void rename(const QString &oldFileName, const QString &newFileName);
+
+    /**
+     * Update file name for items loaded from tab file moved away before it's
+     * replaced and remove the file once no longer used (see setTemporary()).
+     *
+     * @return false if no items use the file
+     */
+    static bool retire(const QString &oldFileName, const QString &newFileName);
+
+    /** Return true if any items use data from @a fileName. */
+    static bool isUsed(const QString &fileName);
+
+    /**
+     * Unmap files which are no longer used by any instance and whose data
+     * are no longer referenced (call after item data are released).
+     */
+    static void releaseUnusedMappings();
+
+    /** Return number of files currently mapped into memory. */
+    static int mappedFileCount();
+
+    QString fileName() const;
+
+    /** Remove the file when it's no longer used. */
+    void setTemporary();
+
+    /**
+     * Reference uncompressed data in mapped file.
+     *
+     * Returned data are copied only when modified.
+     *
+     * @return true only if file is mapped and data were referenced
+     */
+    bool mappedData(qint64 offset, qint32 size, QByteArray *bytes) const;
+
+private:
+    void setFileName(const QString &fileName);
+
+    mutable QMutex m_mutex;
+    QString m_fileName;
+    mutable bool m_map;
+    mutable ItemPayloadMapping *m_mapping;
+    bool m_temporary;
+};
+
+using ItemPayloadFilePtr = std::shared_ptr<ItemPayloadFile>;
+
+/**
+ * Reference to data of single format in tab file.
+ */
+struct ItemPayload {
+    ItemPayloadFilePtr file;
+    qint64 offset = 0;
+    qint32 size = 0;
+    /// Codec for stored data (see ItemCodec).
+    int codec = CodecNone;
+    /// Content hash if data are stored in blob file (see itemblobstore.h).
+    QByteArray blobHash;
+    /// Hash of decoded data (see hashFormatData()) or 0 if unknown.
+    quint64 hash = 0;
+};
+
+/// Maps format to its data in tab file.
+using ItemPayloads = QMap<QString, ItemPayload>;
+
+/**
+ * Data of single format as saved in tab file.
+ */
+struct ItemEncodedFormat {
+    /// Codec, and offset and size if data are in blob file (file is not set).
+    ItemPayload payload;
+    /// Encoded data (empty if data are in blob file).
+    QByteArray bytes;
+};
+
+/// Maps format to its encoded data.
+using ItemEncodedFormats = QMap<QString, ItemEncodedFormat>;
+
+/**
+ * Encoded data of item formats so unchanged items are not encoded again when saving.
+ *
+ * Item creates new cache whenever its data change. Copies of the item share
+ * the cache so it can be filled when saving the copies in another thread.
+ */
+class ItemEncodedCache
+{
+public:
+    bool find(const QString &format, ItemEncodedFormat *encoded) const;
+
+    void insert(const QString &format, const ItemEncodedFormat &encoded);
+
+    /// Return size of encoded data except data shared with @a decoded (uncompressed data).
+    qint64 byteCount(const ItemData &decoded) const;
+
+private:
+    mutable QMutex m_mutex;
+    ItemEncodedFormats m_formats;
+};
+
+using ItemEncodedCachePtr = std::shared_ptr<ItemEncodedCache>;
+
+/**
+ * Read data of single format from @a device.
+ * @return true only if successful
+ */
+bool readPayload(QIODevice *device, const ItemPayload &payload, QByteArray *bytes);
+
+/**
+ * Load data of all formats in @a payloads to @a data.
+ *
+ * Encoded data are added to @a cache if provided.
+ *
+ * @return true only if all data were loaded
+ */
+bool loadPayloads(const ItemPayloads &payloads, QVariantMap *data, ItemEncodedCache *cache = nullptr);
+
+/**
+ * Read data of all formats in @a payloads as stored in files (without decoding).
+ *
+ * Data in blob files are only referenced (see ItemEncodedFormat).
+ *
+ * @return true only if all data were read
+ */
+bool readEncodedPayloads(const ItemPayloads &payloads, ItemEncodedFormats *encodedFormats);
+
+#endif // ITEMPAYLOAD_H
@@ -0,0 +1,195 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemsavequeue.h"
+
+#include "common/log.h"
+#include "item/clipboardmodel.h"
+#include "item/itemstore.h"
+
+#include <QMetaObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+struct ItemSaveState {
+    QMutex mutex;
+    QWaitCondition finishedCondition;
+    bool finished = false;
+    bool ok = false;
+};
+
+namespace {
+
+/// Tabs are saved one after another so blob files are not written concurrently.
+QThreadPool *saveThreadPool()
+{
+    static QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    return &pool;
+}
+
+class SaveItemsTask : public QRunnable
+{
+public:
+    SaveItemsTask(
+            ItemSaveQueue *queue, const QString &tabName, const QVector<ClipboardItem> &items,
+            const ItemSaverPtr &saver, const std::shared_ptr<ItemSaveState> &state)
+        : m_queue(queue)
+        , m_tabName(tabName)
+        , m_items(items)
+        , m_saver(saver)
+        , m_state(state)
+    {
+    }
+
+    void run() override
+    {
+        const bool ok = saveAllItems(m_tabName, m_items, m_saver);
+
+        // Saver must be destroyed in main thread.
+        m_saver.reset();
+        m_items.clear();
+
+        QMutexLocker lock(&m_state->mutex);
+        m_state->ok = ok;
+        m_state->finished = true;
+        QMetaObject::invokeMethod(m_queue, "onSaveFinished", Qt::QueuedConnection);
+        m_state->finishedCondition.wakeAll();
+    }
+
+private:
+    ItemSaveQueue *m_queue;
+    QString m_tabName;
+    QVector<ClipboardItem> m_items;
+    ItemSaverPtr m_saver;
+    std::shared_ptr<ItemSaveState> m_state;
+};
+
+} // namespace
+
+ItemSaveQueue::ItemSaveQueue(QObject *parent)
+    : QObject(parent)
+    , m_model()
+    , m_saver()
+    , m_runningSaver()
+    , m_state()
+    , m_savePending(false)
+    , m_saveAllItems(false)
+{
+}
+
+ItemSaveQueue::~ItemSaveQueue()
+{
+    waitForSaved();
+}
+
+bool ItemSaveQueue::save(ClipboardModel *model, const ItemSaverPtr &saver)
+{
+    if ( isSaving() ) {
+        m_model = model;
+        m_saver = saver;
+        m_savePending = true;
+        return true;
+    }
+
+    if ( !m_saveAllItems && saveItemChanges(*model, saver) )
+        return true;
+
+    if ( !saver->prepareSaveItemsInBackground() )
+        return saveNow(model, saver);
+
+    COPYQ_LOG( QString("Tab \"%1\": Saving items in background").arg(model->tabName()) );
+
+    m_saveAllItems = false;
+    m_runningSaver = saver;
+    m_state = std::make_shared<ItemSaveState>();
+    saveThreadPool()->start( new SaveItemsTask(this, model->tabName(), model->items(), saver, m_state) );
+
+    return true;
+}
+
+bool ItemSaveQueue::waitForSaved()
+{
+    if ( !isSaving() )
+        return true;
+
+    bool ok = finishSave();
+
+    if (m_savePending) {
+        m_savePending = false;
+        const ItemSaverPtr saver = m_saver;
+        m_saver = nullptr;
+        if (m_model)
+            ok = saveNow(m_model, saver) && ok;
+    }
+
+    return ok;
+}
+
+void ItemSaveQueue::onSaveFinished()
+{
+    // Save could be already finished in waitForSaved().
+    if ( !isSaving() )
+        return;
+
+    finishSave();
+
+    if (m_savePending) {
+        m_savePending = false;
+        const ItemSaverPtr saver = m_saver;
+        m_saver = nullptr;
+        if (m_model)
+            save(m_model, saver);
+    }
+}
+
+bool ItemSaveQueue::saveNow(ClipboardModel *model, const ItemSaverPtr &saver)
+{
+    if ( !m_saveAllItems && saveItemChanges(*model, saver) )
+        return true;
+
+    m_saveAllItems = !saveAllItems(*model, saver);
+    return !m_saveAllItems;
+}
+
+bool ItemSaveQueue::finishSave()
+{
+    bool ok;
+    {
+        QMutexLocker lock(&m_state->mutex);
+        while (!m_state->finished)
+            m_state->finishedCondition.wait(&m_state->mutex);
+        ok = m_state->ok;
+    }
+
+    m_state = nullptr;
+    m_runningSaver = nullptr;
+
+    // Changes recorded before the items were copied are lost so all items need to be saved.
+    if (!ok)
+        m_saveAllItems = true;
+
+    emit saved(ok);
+
+    return ok;
+}
@@ -0,0 +1,92 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMSAVEQUEUE_H
+#define ITEMSAVEQUEUE_H
+
+#include "item/itemwidget.h"
+
+#include <QObject>
+#include <QPointer>
+
+#include <memory>
+
+class ClipboardModel;
+struct ItemSaveState;
+
+/**
+ * Saves items of a tab, bigger saves are done in background.
+ *
+ * Changes since last save are saved immediately (see saveItemChanges()).
+ * If all items need to be saved and saver allows it, copy of item data is
+ * saved in another thread.
+ *
+ * Only single save per tab runs at a time. Save requested meanwhile starts
+ * after the running one finishes and saves items current at that time
+ * (multiple requests are merged into one).
+ */
+class ItemSaveQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ItemSaveQueue(QObject *parent = nullptr);
+
+    ~ItemSaveQueue();
+
+    /**
+     * Save items or start saving them in background.
+     * @return false only if saving failed
+     */
+    bool save(ClipboardModel *model, const ItemSaverPtr &saver);
+
+    /**
+     * Wait for running save to finish and save pending changes.
+     *
+     * Should be called before the tab file is used otherwise (e.g. renamed or removed)
+     * and before items are unloaded.
+     *
+     * @return false only if saving failed
+     */
+    bool waitForSaved();
+
+    /** Return true if items are being saved in background. */
+    bool isSaving() const { return m_state != nullptr; }
+
+signals:
+    /** Emitted when saving in background finishes. */
+    void saved(bool ok);
+
+private slots:
+    void onSaveFinished();
+
+private:
+    bool saveNow(ClipboardModel *model, const ItemSaverPtr &saver);
+
+    bool finishSave();
+
+    QPointer<ClipboardModel> m_model;
+    ItemSaverPtr m_saver;
+    ItemSaverPtr m_runningSaver;
+    std::shared_ptr<ItemSaveState> m_state;
+    bool m_savePending;
+    bool m_saveAllItems;
+};
+
+#endif // ITEMSAVEQUEUE_H
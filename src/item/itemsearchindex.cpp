@@ -0,0 +1,428 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemsearchindex.h"
+
+#include "common/log.h"
+
+#include <QAbstractItemModel>
+#include <QBitArray>
+#include <QRegExp>
+#include <QStringList>
+
+#include <algorithm>
+
+namespace {
+
+/// Longer texts are not indexed so the index doesn't grow too much.
+const int maxIndexedTextLength = 16 * 1024;
+
+/// Removed items are forgotten only if there are more of them.
+const int minRemovedCountToCompact = 1024;
+
+quint64 trigramAt(const QString &lowerText, int i)
+{
+    return (static_cast<quint64>(lowerText[i].unicode()) << 32)
+            | (static_cast<quint64>(lowerText[i + 1].unicode()) << 16)
+            | static_cast<quint64>(lowerText[i + 2].unicode());
+}
+
+/// Lower case characters one by one as QRegExp does for case-insensitive matching.
+QString toLowerChars(const QString &text)
+{
+    QString lowerText = text;
+    for (auto &c : lowerText)
+        c = c.toLower();
+    return lowerText;
+}
+
+/// Append trigrams of text to @a trigrams (sorted and without duplicates).
+void addTrigrams(const QString &text, QVector<quint64> *trigrams)
+{
+    const QString lowerText = toLowerChars(text);
+    for (int i = 0; i + 2 < lowerText.size(); ++i)
+        trigrams->append( trigramAt(lowerText, i) );
+
+    std::sort( trigrams->begin(), trigrams->end() );
+    trigrams->erase( std::unique(trigrams->begin(), trigrams->end()), trigrams->end() );
+}
+
+/// Skip to end of character class starting at @a i (returns false if there is no end).
+bool skipCharacterClass(const QString &pattern, int *i)
+{
+    int j = *i + 1;
+    if ( j < pattern.size() && pattern[j] == '^' )
+        ++j;
+    // Closing bracket right after opening one is part of the class.
+    if ( j < pattern.size() && pattern[j] == ']' )
+        ++j;
+
+    for ( ; j < pattern.size(); ++j ) {
+        if (pattern[j] == '\\') {
+            ++j;
+        } else if (pattern[j] == ']') {
+            *i = j;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Skip to end of group starting at @a i (returns false if there is no end).
+bool skipGroup(const QString &pattern, int *i)
+{
+    int depth = 0;
+    for (int j = *i; j < pattern.size(); ++j) {
+        const QChar c = pattern[j];
+        if (c == '\\') {
+            ++j;
+        } else if (c == '[') {
+            if ( !skipCharacterClass(pattern, &j) )
+                return false;
+        } else if (c == '(') {
+            ++depth;
+        } else if (c == ')') {
+            --depth;
+            if (depth == 0) {
+                *i = j;
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Add substrings which must be in any text matching regular expression @a pattern.
+ *
+ * Only simple parts of the expression are used, i.e. characters not in groups
+ * and not followed by optional quantifier.
+ *
+ * @return false if there can be matching text without any such substring
+ *         (e.g. alternatives on top level or unsupported syntax)
+ */
+bool addRequiredSubstrings(const QString &pattern, QStringList *substrings)
+{
+    QString substring;
+    const auto addSubstring = [&]() {
+        if (substring.size() >= 3)
+            substrings->append(substring);
+        substring.clear();
+    };
+
+    for (int i = 0; i < pattern.size(); ++i) {
+        const QChar c = pattern[i];
+
+        if (c == '\\') {
+            if (++i == pattern.size())
+                return false;
+
+            const QChar escaped = pattern[i];
+            // Character codes (e.g. \x0041, \0101) are not supported.
+            if ( escaped == 'x' || escaped.isDigit() )
+                return false;
+
+            // Character classes, assertions and special characters (e.g. \w, \b, \n).
+            if ( escaped.isLetter() )
+                addSubstring();
+            else
+                substring.append(escaped);
+        } else if (c == '[') {
+            addSubstring();
+            if ( !skipCharacterClass(pattern, &i) )
+                return false;
+        } else if (c == '(') {
+            addSubstring();
+            if ( !skipGroup(pattern, &i) )
+                return false;
+        } else if (c == '|' || c == ')') {
+            return false;
+        } else if (c == '*' || c == '?' || c == '{') {
+            // Previous character is optional.
+            substring.chop(1);
+            addSubstring();
+            if (c == '{') {
+                i = pattern.indexOf('}', i);
+                if (i == -1)
+                    return false;
+            }
+        } else if (c == '+' || c == '.' || c == '^' || c == '$') {
+            addSubstring();
+        } else {
+            substring.append(c);
+        }
+    }
+
+    addSubstring();
+
+    return true;
+}
+
+bool addRequiredSubstrings(const QRegExp &re, QStringList *substrings)
+{
+    switch ( re.patternSyntax() ) {
+    case QRegExp::RegExp:
+    case QRegExp::RegExp2:
+        return addRequiredSubstrings(re.pattern(), substrings);
+    case QRegExp::FixedString:
+        substrings->append( re.pattern() );
+        return true;
+    default:
+        return false;
+    }
+}
+
+/// Remove items from @a ids which are not in @a otherIds (both sorted).
+void intersect(QVector<int> *ids, const QVector<int> &otherIds)
+{
+    const auto end = std::set_intersection(
+                ids->begin(), ids->end(), otherIds.begin(), otherIds.end(), ids->begin() );
+    ids->erase( end, ids->end() );
+}
+
+} // namespace
+
+ItemSearchIndex::ItemSearchIndex(
+        QAbstractItemModel *model, const TextFunction &searchableText, QObject *parent)
+    : QObject(parent)
+    , m_model(model)
+    , m_searchableText(searchableText)
+    , m_built(false)
+    , m_rowIds()
+    , m_alive()
+    , m_removedCount(0)
+    , m_trigramItems()
+    , m_unindexedItems()
+{
+    connect( model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+             this, SLOT(onRowsInserted(QModelIndex,int,int)) );
+    connect( model, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+             this, SLOT(onRowsRemoved(QModelIndex,int,int)) );
+    connect( model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)),
+             this, SLOT(onRowsMoved(QModelIndex,int,int,QModelIndex,int)) );
+    connect( model, SIGNAL(dataChanged(QModelIndex,QModelIndex)),
+             this, SLOT(onDataChanged(QModelIndex,QModelIndex)) );
+    connect( model, SIGNAL(modelReset()),
+             this, SLOT(invalidate()) );
+    connect( model, SIGNAL(layoutChanged()),
+             this, SLOT(invalidate()) );
+}
+
+bool ItemSearchIndex::findCandidateRows(const QRegExp &re, QBitArray *rows)
+{
+    QStringList substrings;
+    if ( re.isEmpty() || !addRequiredSubstrings(re, &substrings) )
+        return false;
+
+    QVector<quint64> trigrams;
+    for (const auto &substring : substrings)
+        addTrigrams(substring, &trigrams);
+
+    if ( trigrams.isEmpty() )
+        return false;
+
+    if ( !m_built || static_cast<int>(m_rowIds.size()) != m_model->rowCount() )
+        build();
+
+    // Intersect smallest lists first.
+    QVector<const QVector<int>*> itemLists;
+    for (const auto trigram : trigrams) {
+        const auto it = m_trigramItems.constFind(trigram);
+        if ( it == m_trigramItems.constEnd() ) {
+            itemLists.clear();
+            break;
+        }
+        itemLists.append( &it.value() );
+    }
+
+    std::sort( itemLists.begin(), itemLists.end(),
+               [](const QVector<int> *lhs, const QVector<int> *rhs) {
+                   return lhs->size() < rhs->size();
+               } );
+
+    QVector<int> candidates;
+    if ( !itemLists.isEmpty() ) {
+        candidates = *itemLists[0];
+        for (int i = 1; i < itemLists.size() && !candidates.isEmpty(); ++i)
+            intersect(&candidates, *itemLists[i]);
+    }
+
+    std::vector<bool> isCandidate( m_alive.size(), false );
+    for (const int id : candidates)
+        isCandidate[id] = true;
+    for (const int id : m_unindexedItems)
+        isCandidate[id] = true;
+
+    rows->fill( false, static_cast<int>(m_rowIds.size()) );
+    for (int row = 0; row < static_cast<int>(m_rowIds.size()); ++row) {
+        if ( isCandidate[m_rowIds[row]] )
+            rows->setBit(row);
+    }
+
+    return true;
+}
+
+void ItemSearchIndex::invalidate()
+{
+    m_built = false;
+    m_rowIds.clear();
+    m_alive.clear();
+    m_removedCount = 0;
+    m_trigramItems.clear();
+    m_unindexedItems.clear();
+}
+
+void ItemSearchIndex::onRowsInserted(const QModelIndex &, int first, int last)
+{
+    if (!m_built)
+        return;
+
+    std::vector<int> ids;
+    ids.reserve(last - first + 1);
+    for (int row = first; row <= last; ++row)
+        ids.push_back( addItem(row) );
+
+    m_rowIds.insert( m_rowIds.begin() + first, ids.begin(), ids.end() );
+}
+
+void ItemSearchIndex::onRowsRemoved(const QModelIndex &, int first, int last)
+{
+    if (!m_built)
+        return;
+
+    const auto begin = m_rowIds.begin() + first;
+    const auto end = m_rowIds.begin() + last + 1;
+    for (auto it = begin; it != end; ++it)
+        removeItem(*it);
+
+    m_rowIds.erase(begin, end);
+
+    compactIfNeeded();
+}
+
+void ItemSearchIndex::onRowsMoved(
+        const QModelIndex &, int sourceStart, int sourceEnd,
+        const QModelIndex &, int destinationRow)
+{
+    if (!m_built)
+        return;
+
+    const auto start = m_rowIds.begin() + sourceStart;
+    const auto end = m_rowIds.begin() + sourceEnd + 1;
+    const auto destination = m_rowIds.begin() + destinationRow;
+
+    if (sourceStart < destinationRow)
+        std::rotate(start, end, destination);
+    else
+        std::rotate(destination, start, end);
+}
+
+void ItemSearchIndex::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (!m_built)
+        return;
+
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row) {
+        removeItem(m_rowIds[row]);
+        m_rowIds[row] = addItem(row);
+    }
+
+    compactIfNeeded();
+}
+
+void ItemSearchIndex::build()
+{
+    invalidate();
+
+    const int rowCount = m_model->rowCount();
+    COPYQ_LOG( QString("Indexing %1 items for search").arg(rowCount) );
+
+    m_alive.reserve(rowCount);
+    for (int row = 0; row < rowCount; ++row)
+        m_rowIds.push_back( addItem(row) );
+
+    m_built = true;
+}
+
+int ItemSearchIndex::addItem(int row)
+{
+    const int id = static_cast<int>( m_alive.size() );
+    m_alive.push_back(true);
+
+    const QString text = m_searchableText( m_model->index(row, 0) );
+    if (text.size() > maxIndexedTextLength) {
+        m_unindexedItems.append(id);
+        return id;
+    }
+
+    QVector<quint64> trigrams;
+    addTrigrams(text, &trigrams);
+    for (const auto trigram : trigrams)
+        m_trigramItems[trigram].append(id);
+
+    return id;
+}
+
+void ItemSearchIndex::removeItem(int id)
+{
+    m_alive[id] = false;
+    ++m_removedCount;
+}
+
+void ItemSearchIndex::compactIfNeeded()
+{
+    const int aliveCount = static_cast<int>(m_alive.size()) - m_removedCount;
+    if (m_removedCount < minRemovedCountToCompact || m_removedCount < aliveCount)
+        return;
+
+    // Assign new IDs in the same order so the lists stay sorted.
+    std::vector<int> newIds( m_alive.size(), -1 );
+    int newId = 0;
+    for (int id = 0; id < static_cast<int>(m_alive.size()); ++id) {
+        if (m_alive[id])
+            newIds[id] = newId++;
+    }
+
+    const auto updateIds = [&](QVector<int> *ids) {
+        int i = 0;
+        for (const int id : *ids) {
+            if (newIds[id] != -1)
+                (*ids)[i++] = newIds[id];
+        }
+        ids->resize(i);
+    };
+
+    for (auto it = m_trigramItems.begin(); it != m_trigramItems.end(); ) {
+        updateIds( &it.value() );
+        if ( it.value().isEmpty() )
+            it = m_trigramItems.erase(it);
+        else
+            ++it;
+    }
+
+    updateIds(&m_unindexedItems);
+
+    for (auto &id : m_rowIds)
+        id = newIds[id];
+
+    m_alive.assign(newId, true);
+    m_removedCount = 0;
+}
@@ -0,0 +1,103 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMSEARCHINDEX_H
+#define ITEMSEARCHINDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+class QAbstractItemModel;
+class QBitArray;
+class QModelIndex;
+class QRegExp;
+class QString;
+
+/**
+ * Trigram index of searchable item text for fast filtering.
+ *
+ * Index maps each three consecutive characters (case-insensitive) to items
+ * containing them. Items which cannot match a filter are found by looking up
+ * trigrams of substrings which must be in any matching text.
+ *
+ * Index is built when first needed and updated when model changes.
+ */
+class ItemSearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** Returns text searched by filter for item (see ItemFactory::searchableText()). */
+    using TextFunction = std::function<QString (const QModelIndex &)>;
+
+    ItemSearchIndex(
+            QAbstractItemModel *model, const TextFunction &searchableText,
+            QObject *parent = nullptr);
+
+    /**
+     * Set bits in @a rows for items which can match @a re.
+     *
+     * @return false if any item can match (index cannot be used for the expression)
+     */
+    bool findCandidateRows(const QRegExp &re, QBitArray *rows);
+
+public slots:
+    /** Drop index (it's built again when needed). */
+    void invalidate();
+
+private slots:
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsMoved(const QModelIndex &sourceParent, int sourceStart, int sourceEnd,
+                     const QModelIndex &destinationParent, int destinationRow);
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+private:
+    void build();
+
+    /** Index item and return its new ID. */
+    int addItem(int row);
+
+    void removeItem(int id);
+
+    /** Forget removed items if there are too many. */
+    void compactIfNeeded();
+
+    QAbstractItemModel *m_model;
+    TextFunction m_searchableText;
+    bool m_built;
+
+    /// Item ID for each row (IDs increase so lists of IDs are always sorted).
+    std::deque<int> m_rowIds;
+    /// False for removed items.
+    std::vector<bool> m_alive;
+    int m_removedCount;
+
+    /// Maps trigram to sorted IDs of items (can contain removed items).
+    QHash<quint64, QVector<int>> m_trigramItems;
+    /// Items with too long text which are not indexed (always candidates).
+    QVector<int> m_unindexedItems;
+};
+
+#endif // ITEMSEARCHINDEX_H
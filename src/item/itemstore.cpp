@@ -22,14 +22,28 @@
 #include "common/common.h"
 #include "common/config.h"
 #include "common/log.h"
+#include "item/itemblobstore.h"
 #include "item/itemfactory.h"
+#include "item/itempayload.h"
 #include "item/clipboardmodel.h"
+#include "item/serialize.h"
 
+#include <QBuffer>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
 
 namespace {
 
+const char journalFileHeader[] = "CopyQ_tab_journal";
+const char searchIndexFileHeader[] = "CopyQ_tab_search_index";
+
+/// Journal is compacted (all items saved again) if it grows bigger than the tab file or this size.
+const qint64 minJournalSizeToCompact = 512 * 1024;
+
 /// @return File name for data file with items.
 QString itemFileName(const QString &id)
 {
@@ -38,6 +52,78 @@ QString itemFileName(const QString &id)
     return getConfigurationFilePath("_tab_") + part + QString(".dat");
 }
 
+/// @return File name for items removed from full tab.
+QString archiveFileName(const QString &tabFileName)
+{
+    return tabFileName + ".archive";
+}
+
+/// @return File name for journal with changes since the data file was saved.
+QString journalFileName(const QString &tabFileName)
+{
+    return tabFileName + ".journal";
+}
+
+/// @return Template for file name of replaced data file still used by items.
+QString retiredFileTemplate(const QString &tabFileName)
+{
+    return tabFileName + ".old-XXXXXX";
+}
+
+/// @return File name for texts to search in unloaded tab.
+QString searchIndexFileName(const QString &tabFileName)
+{
+    return tabFileName + ".search";
+}
+
+void writeJournalHeader(QDataStream *stream, const QFileInfo &tabFileInfo)
+{
+    *stream << QString(journalFileHeader)
+            << static_cast<qint64>( tabFileInfo.size() )
+            << static_cast<qint64>( tabFileInfo.lastModified().toMSecsSinceEpoch() );
+}
+
+/// @return true only if journal was created for current data file.
+bool readJournalHeader(QDataStream *stream, const QFileInfo &tabFileInfo)
+{
+    QString header;
+    qint64 size;
+    qint64 lastModified;
+    *stream >> header >> size >> lastModified;
+
+    return stream->status() == QDataStream::Ok
+            && header == journalFileHeader
+            && size == tabFileInfo.size()
+            && lastModified == tabFileInfo.lastModified().toMSecsSinceEpoch();
+}
+
+void writeSearchIndexHeader(QDataStream *stream, const QString &tabFileName)
+{
+    const QFileInfo tabFileInfo(tabFileName);
+    *stream << QString(searchIndexFileHeader)
+            << static_cast<qint64>( tabFileInfo.size() )
+            << static_cast<qint64>( tabFileInfo.lastModified().toMSecsSinceEpoch() )
+            << static_cast<qint64>( QFileInfo(journalFileName(tabFileName)).size() );
+}
+
+/// @return true only if search index was created for current data file and journal.
+bool readSearchIndexHeader(QDataStream *stream, const QString &tabFileName)
+{
+    QString header;
+    qint64 size;
+    qint64 lastModified;
+    qint64 journalSize;
+    *stream >> header >> size >> lastModified >> journalSize;
+
+    const QFileInfo tabFileInfo(tabFileName);
+    return stream->status() == QDataStream::Ok
+            && header == searchIndexFileHeader
+            && tabFileInfo.exists()
+            && size == tabFileInfo.size()
+            && lastModified == tabFileInfo.lastModified().toMSecsSinceEpoch()
+            && journalSize == QFileInfo(journalFileName(tabFileName)).size();
+}
+
 bool createItemDirectory()
 {
     QDir settingsDir( settingsDirectoryPath() );
@@ -52,6 +138,34 @@ bool createItemDirectory()
     return true;
 }
 
+/// @return Changes from journal or empty array if journal is missing or outdated.
+QByteArray readJournalChanges(const QString &tabFileName)
+{
+    QFile journalFile( journalFileName(tabFileName) );
+    if ( !journalFile.open(QIODevice::ReadOnly) )
+        return QByteArray();
+
+    QDataStream stream(&journalFile);
+    stream.setVersion(QDataStream::Qt_4_7);
+    if ( !readJournalHeader(&stream, QFileInfo(tabFileName)) )
+        return QByteArray();
+
+    return journalFile.readAll();
+}
+
+bool writeJournalChanges(const QString &tabFileName, const QByteArray &changes)
+{
+    QFile journalFile( journalFileName(tabFileName) );
+    if ( !journalFile.open(QIODevice::WriteOnly) )
+        return false;
+
+    QDataStream stream(&journalFile);
+    stream.setVersion(QDataStream::Qt_4_7);
+    writeJournalHeader( &stream, QFileInfo(tabFileName) );
+
+    return journalFile.write(changes) == changes.size() && journalFile.flush();
+}
+
 void printItemFileError(
         const QString &action, const QString &id, const QString &fileName, const QFile &file)
 {
@@ -97,8 +211,252 @@ ItemSaverPtr loadItems(
     return loader;
 }
 
+/**
+ * Remove old tab file before it's replaced.
+ *
+ * If items still use data from the file, it's moved and removed only after
+ * the items no longer use it (see ItemPayloadFile::retire()).
+ */
+bool retireTabFile(const QString &tabName, const QString &tabFileName)
+{
+    QFile tabFile(tabFileName);
+    if ( !tabFile.exists() )
+        return true;
+
+    if ( !ItemPayloadFile::isUsed(tabFileName) ) {
+        if ( !tabFile.remove() ) {
+            printSaveItemFileError(tabName, tabFileName, tabFile);
+            return false;
+        }
+        return true;
+    }
+
+    // Get unique file name (temporary file is removed at the end of the block).
+    QString retiredFileName;
+    {
+        QTemporaryFile retiredFile( retiredFileTemplate(tabFileName) );
+        if ( !retiredFile.open() ) {
+            printSaveItemFileError(tabName, retiredFile.fileName(), retiredFile);
+            return false;
+        }
+        retiredFileName = retiredFile.fileName();
+    }
+
+    if ( !tabFile.rename(retiredFileName) ) {
+        printSaveItemFileError(tabName, retiredFileName, tabFile);
+        return false;
+    }
+
+    if ( !ItemPayloadFile::retire(tabFileName, retiredFileName) )
+        QFile::remove(retiredFileName);
+
+    return true;
+}
+
+/// Remove tab files replaced while items used them if these are no longer used (e.g. after crash).
+void removeRetiredTabFiles(const QString &tabFileName)
+{
+    const QFileInfo tabFileInfo(tabFileName);
+    const QDir dir = tabFileInfo.dir();
+    const QString nameFilter = QFileInfo( retiredFileTemplate(tabFileName) ).fileName()
+            .replace("XXXXXX", "*");
+
+    for ( const auto &fileName : dir.entryList(QStringList(nameFilter), QDir::Files) ) {
+        const QString filePath = dir.absoluteFilePath(fileName);
+        if ( !ItemPayloadFile::isUsed(filePath) )
+            QFile::remove(filePath);
+    }
+}
+
+/// Read content hashes of blob files referenced from tab file.
+bool readTabFileBlobHashes(const QString &fileName, QSet<QByteArray> *hashes)
+{
+    QFile file(fileName);
+    return file.open(QIODevice::ReadOnly) && readBlobHashes(&file, hashes);
+}
+
+/// Remove blob files which are not referenced from any tab file.
+void removeUnusedBlobFiles()
+{
+    const QFileInfo tabFilePrefix( getConfigurationFilePath("_tab_") );
+    const QDir dir = tabFilePrefix.dir();
+    const QStringList nameFilters = QStringList()
+            << tabFilePrefix.fileName() + "*.dat"
+            << tabFilePrefix.fileName() + "*.dat.tmp";
+
+    QStringList fileNames;
+    for ( const auto &fileName : dir.entryList(nameFilters, QDir::Files) )
+        fileNames.append( dir.absoluteFilePath(fileName) );
+
+    removeUnusedBlobs(fileNames, readTabFileBlobHashes);
+}
+
+bool saveAllItemsToFile(
+        const QString &tabName, const QString &tabFileName,
+        const ClipboardModel &model, const ItemSaverPtr &saver)
+{
+    // Blob files referenced from new file must not be removed before its references are set.
+    const BlobSaveGuard blobSaveGuard;
+
+    // Save to temp file.
+    QFile tmpFile( tabFileName + ".tmp" );
+    if ( !tmpFile.open(QIODevice::WriteOnly) ) {
+        printSaveItemFileError(tabName, tabFileName, tmpFile);
+        return false;
+    }
+
+    COPYQ_LOG( QString("Tab \"%1\": Saving %2 items").arg(tabName).arg(model.rowCount()) );
+
+    if ( !saver->saveItems(model, &tmpFile) ) {
+        COPYQ_LOG( QString("Tab \"%1\": Failed to save items!").arg(tabName) );
+        return false;
+    }
+
+    // 1. Safely flush all data to temporary file.
+    tmpFile.flush();
+
+    // 2. Remove old tab file (or keep it while items use it).
+    if ( !retireTabFile(tabName, tabFileName) )
+        return false;
+
+    // 3. Overwrite previous file.
+    if ( !tmpFile.rename(tabFileName) ) {
+        printSaveItemFileError(tabName, tabFileName, tmpFile);
+        return false;
+    }
+
+    // 4. Remove journal with changes which are now in the new file
+    //    and search index with texts of old items.
+    //    (Journal header is checked when loading in case this fails.)
+    QFile::remove( journalFileName(tabFileName) );
+    QFile::remove( searchIndexFileName(tabFileName) );
+
+    // 5. Update references to data shared with other tabs.
+    QSet<QByteArray> blobHashes;
+    removeBlobReferences(tabFileName + ".tmp");
+    if ( readTabFileBlobHashes(tabFileName, &blobHashes) )
+        setBlobReferences(tabFileName, blobHashes);
+    else
+        removeBlobReferences(tabFileName);
+
+    COPYQ_LOG( QString("Tab \"%1\": Items saved").arg(tabName) );
+
+    return true;
+}
+
+bool saveAllItems(
+        const QString &tabName, const QString &tabFileName,
+        const ClipboardModel &model, const ItemSaverPtr &saver)
+{
+    if ( !saveAllItemsToFile(tabName, tabFileName, model, saver) )
+        return false;
+
+    // Remove data no longer referenced by this or other tabs.
+    removeUnusedBlobFiles();
+
+    return true;
+}
+
+/**
+ * Append changes since last save to journal file.
+ *
+ * @return false if all items need to be saved instead
+ */
+bool saveItemChanges(
+        const QString &tabName, const QString &tabFileName,
+        const ClipboardModel &model, const ItemSaverPtr &saver)
+{
+    // Save all items if there is no data file or last attempt to save them failed.
+    const QFileInfo tabFileInfo(tabFileName);
+    if ( !tabFileInfo.exists() || QFile::exists(tabFileName + ".tmp") )
+        return false;
+
+    QFile journalFile( journalFileName(tabFileName) );
+
+    // Compact journal if it's too big.
+    const qint64 journalSize = journalFile.size();
+    if ( journalSize > qMax(tabFileInfo.size(), minJournalSizeToCompact) ) {
+        COPYQ_LOG( QString("Tab \"%1\": Compacting journal").arg(tabName) );
+        return false;
+    }
+
+    QBuffer changes;
+    changes.open(QIODevice::WriteOnly);
+    if ( !saver->saveChanges(model, &changes) )
+        return false;
+
+    const QByteArray bytes = changes.data();
+    if ( bytes.isEmpty() )
+        return true;
+
+    // Search index would contain texts of removed and changed items.
+    QFile::remove( searchIndexFileName(tabFileName) );
+
+    if ( !journalFile.open(QIODevice::ReadWrite) ) {
+        printSaveItemFileError(tabName, journalFile.fileName(), journalFile);
+        return false;
+    }
+
+    QDataStream stream(&journalFile);
+    stream.setVersion(QDataStream::Qt_4_7);
+    if (journalSize == 0) {
+        writeJournalHeader(&stream, tabFileInfo);
+    } else if ( !readJournalHeader(&stream, tabFileInfo) ) {
+        COPYQ_LOG( QString("Tab \"%1\": Replacing outdated journal").arg(tabName) );
+        return false;
+    }
+
+    if ( !journalFile.seek(journalFile.size())
+         || journalFile.write(bytes) != bytes.size()
+         || !journalFile.flush() )
+    {
+        printSaveItemFileError(tabName, journalFile.fileName(), journalFile);
+        return false;
+    }
+
+    COPYQ_LOG( QString("Tab \"%1\": Changes saved").arg(tabName) );
+
+    return true;
+}
+
+/**
+ * Apply changes from journal file to items loaded from data file.
+ *
+ * @return false if all items need to be saved again
+ */
+bool loadItemChanges(
+        const QString &tabName, const QString &tabFileName,
+        ClipboardModel &model, const ItemSaverPtr &saver)
+{
+    QFile journalFile( journalFileName(tabFileName) );
+    if ( !journalFile.exists() )
+        return true;
+
+    if ( !journalFile.open(QIODevice::ReadOnly) ) {
+        printLoadItemFileError(tabName, journalFile.fileName(), journalFile);
+        return false;
+    }
+
+    QDataStream stream(&journalFile);
+    stream.setVersion(QDataStream::Qt_4_7);
+    if ( !readJournalHeader(&stream, QFileInfo(tabFileName)) ) {
+        log( QString("Tab \"%1\": Ignoring outdated journal").arg(tabName), LogWarning );
+        return false;
+    }
+
+    COPYQ_LOG( QString("Tab \"%1\": Applying changes from journal").arg(tabName) );
+
+    if ( !saver->loadChanges(&model, &journalFile) ) {
+        log( QString("Tab \"%1\": Failed to apply all changes from journal").arg(tabName), LogWarning );
+        return false;
+    }
+
+    return true;
+}
+
 ItemSaverPtr createTab(
-        const QString &tabName, ClipboardModel &model, ItemFactory *itemFactory)
+        const QString &tabName, const QString &tabFileName,
+        ClipboardModel &model, ItemFactory *itemFactory)
 {
     COPYQ_LOG( QString("Tab \"%1\": Creating new tab").arg(tabName) );
 
@@ -108,7 +466,7 @@ ItemSaverPtr createTab(
         return nullptr;
     }
 
-    if ( !saveItems(model, saver) )
+    if ( !saveAllItems(tabName, tabFileName, model, saver) )
         return nullptr;
 
     return saver;
@@ -124,6 +482,8 @@ ItemSaverPtr loadItems(ClipboardModel &model, ItemFactory *itemFactory)
     const QString tabName = model.property("tabName").toString();
     const QString tabFileName = itemFileName(tabName);
 
+    removeRetiredTabFiles(tabFileName);
+
     // If tab file doesn't exist, try to restore data from temporary file.
     if ( !QFile::exists(tabFileName) ) {
         QFile tmpFile(tabFileName + ".tmp");
@@ -141,13 +501,18 @@ ItemSaverPtr loadItems(ClipboardModel &model, ItemFactory *itemFactory)
     // Load file with items or create new file.
     auto saver = QFile::exists(tabFileName)
             ? loadItems(tabName, tabFileName, model, itemFactory)
-            : createTab(tabName, model, itemFactory);
+            : createTab(tabName, tabFileName, model, itemFactory);
 
     if (!saver) {
         model.removeRows(0, model.rowCount());
         return nullptr;
     }
 
+    // Apply changes saved after the data file was written.
+    // Model signals are expected to be blocked here so the changes are not recorded again.
+    if ( !loadItemChanges(tabName, tabFileName, model, saver) )
+        saveAllItems(tabName, tabFileName, model, saver);
+
     model.setDisabled(false);
 
     COPYQ_LOG( QString("Tab \"%1\": %2 items loaded").arg(tabName).arg(model.rowCount()) );
@@ -156,6 +521,11 @@ ItemSaverPtr loadItems(ClipboardModel &model, ItemFactory *itemFactory)
 }
 
 bool saveItems(const ClipboardModel &model, const ItemSaverPtr &saver)
+{
+    return saveItemChanges(model, saver) || saveAllItems(model, saver);
+}
+
+bool saveItemChanges(const ClipboardModel &model, const ItemSaverPtr &saver)
 {
     const QString tabName = model.property("tabName").toString();
     const QString tabFileName = itemFileName(tabName);
@@ -163,48 +533,109 @@ bool saveItems(const ClipboardModel &model, const ItemSaverPtr &saver)
     if ( !createItemDirectory() )
         return false;
 
-    // Save to temp file.
-    QFile tmpFile( tabFileName + ".tmp" );
-    if ( !tmpFile.open(QIODevice::WriteOnly) ) {
-        printSaveItemFileError(tabName, tabFileName, tmpFile);
+    return saveItemChanges(tabName, tabFileName, model, saver);
+}
+
+bool saveAllItems(const ClipboardModel &model, const ItemSaverPtr &saver)
+{
+    const QString tabName = model.property("tabName").toString();
+    const QString tabFileName = itemFileName(tabName);
+
+    if ( !createItemDirectory() )
         return false;
-    }
 
-    COPYQ_LOG( QString("Tab \"%1\": Saving %2 items").arg(tabName).arg(model.rowCount()) );
+    return saveAllItems(tabName, tabFileName, model, saver);
+}
 
-    if ( !saver->saveItems(model, &tmpFile) ) {
-        COPYQ_LOG( QString("Tab \"%1\": Failed to save items!").arg(tabName) );
+bool saveAllItems(
+        const QString &tabName, const QVector<ClipboardItem> &items, const ItemSaverPtr &saver)
+{
+    if ( !createItemDirectory() )
+        return false;
+
+    ClipboardModel model;
+    model.setTabName(tabName);
+    model.setMaxItems( items.size() );
+    model.insertItems(items, 0);
+
+    return saveAllItems(tabName, itemFileName(tabName), model, saver);
+}
+
+bool saveItemSearchIndex(const QString &tabName, const QVector<QStringList> &texts)
+{
+    const QString tabFileName = itemFileName(tabName);
+    QFile file( searchIndexFileName(tabFileName) );
+    if ( !file.open(QIODevice::WriteOnly) ) {
+        printSaveItemFileError(tabName, file.fileName(), file);
         return false;
     }
 
-    // 1. Safely flush all data to temporary file.
-    tmpFile.flush();
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_7);
+    writeSearchIndexHeader(&stream, tabFileName);
+    stream << texts;
 
-    // 2. Remove old tab file.
-    {
-        QFile oldTabFile(tabFileName);
-        if (oldTabFile.exists() && !oldTabFile.remove()) {
-            printSaveItemFileError(tabName, tabFileName, oldTabFile);
-            return false;
-        }
+    if ( stream.status() != QDataStream::Ok || !file.flush() ) {
+        printSaveItemFileError(tabName, file.fileName(), file);
+        file.remove();
+        return false;
     }
 
-    // 3. Overwrite previous file.
-    if ( !tmpFile.rename(tabFileName) ) {
-        printSaveItemFileError(tabName, tabFileName, tmpFile);
+    COPYQ_LOG( QString("Tab \"%1\": Search index saved").arg(tabName) );
+
+    return true;
+}
+
+bool loadItemSearchIndex(const QString &tabName, QVector<QStringList> *texts)
+{
+    const QString tabFileName = itemFileName(tabName);
+    QFile file( searchIndexFileName(tabFileName) );
+    if ( !file.open(QIODevice::ReadOnly) )
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_7);
+    if ( !readSearchIndexHeader(&stream, tabFileName) ) {
+        COPYQ_LOG( QString("Tab \"%1\": Search index is outdated").arg(tabName) );
         return false;
     }
 
-    COPYQ_LOG( QString("Tab \"%1\": Items saved").arg(tabName) );
+    stream >> *texts;
+    if ( stream.status() != QDataStream::Ok ) {
+        log( QString("Tab \"%1\": Failed to read search index").arg(tabName), LogWarning );
+        texts->clear();
+        return false;
+    }
 
     return true;
 }
 
+bool hasItemSearchIndex(const QString &tabName)
+{
+    const QString tabFileName = itemFileName(tabName);
+    QFile file( searchIndexFileName(tabFileName) );
+    if ( !file.open(QIODevice::ReadOnly) )
+        return false;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_7);
+    return readSearchIndexHeader(&stream, tabFileName);
+}
+
+ItemArchivePtr createItemArchive(const QString &tabName)
+{
+    return std::make_shared<ItemArchive>( archiveFileName(itemFileName(tabName)) );
+}
+
 void removeItems(const QString &tabName)
 {
     const QString tabFileName = itemFileName(tabName);
     QFile::remove(tabFileName);
     QFile::remove(tabFileName + ".tmp");
+    QFile::remove( journalFileName(tabFileName) );
+    QFile::remove( archiveFileName(tabFileName) );
+    QFile::remove( searchIndexFileName(tabFileName) );
+    removeRetiredTabFiles(tabFileName);
 }
 
 void moveItems(const QString &oldId, const QString &newId)
@@ -212,11 +643,32 @@ void moveItems(const QString &oldId, const QString &newId)
     const QString oldFileName = itemFileName(oldId);
     const QString newFileName = itemFileName(newId);
 
+    // Journal is valid only for the original data file so it needs to be recreated.
+    const QByteArray changes = readJournalChanges(oldFileName);
+
     if ( oldFileName != newFileName && QFile::copy(oldFileName, newFileName) ) {
         QFile::remove(oldFileName);
+        QFile::remove( journalFileName(oldFileName) );
+        ItemPayloadFile::rename(oldFileName, newFileName);
+        if ( !changes.isEmpty() )
+            writeJournalChanges(newFileName, changes);
     } else {
         COPYQ_LOG( QString("Failed to move items from \"%1\" (tab \"%2\") to \"%3\" (tab \"%4\")")
                    .arg(oldFileName).arg(oldId)
                    .arg(newFileName).arg(newId) );
     }
+
+    const QString oldArchiveFileName = archiveFileName(oldFileName);
+    const QString newArchiveFileName = archiveFileName(newFileName);
+    if ( oldFileName != newFileName && QFile::exists(oldArchiveFileName) ) {
+        QFile::remove(newArchiveFileName);
+        if ( !QFile::rename(oldArchiveFileName, newArchiveFileName) ) {
+            log( QString("Failed to move archived items from \"%1\" to \"%2\"")
+                 .arg(oldArchiveFileName, newArchiveFileName), LogError );
+        }
+    }
+
+    // Search index is valid only for the original data file (it's saved again when tab is unloaded).
+    if (oldFileName != newFileName)
+        QFile::remove( searchIndexFileName(oldFileName) );
 }
@@ -19,8 +19,13 @@
 #ifndef ITEMSTORE_H
 #define ITEMSTORE_H
 
+#include "item/itemarchive.h"
 #include "item/itemwidget.h"
 
+#include <QStringList>
+#include <QVector>
+
+class ClipboardItem;
 class ClipboardModel;
 class ItemFactory;
 class QString;
@@ -33,10 +38,51 @@ ItemSaverPtr loadItems(ClipboardModel &model //!< Model for items.
 bool saveItems(const ClipboardModel &model //!< Model containing items to save.
         , const ItemSaverPtr &saver);
 
+/**
+ * Save only changes made since items were last saved or loaded.
+ * @return false if all items need to be saved instead
+ */
+bool saveItemChanges(const ClipboardModel &model, const ItemSaverPtr &saver);
+
+/** Save all items to configuration file. */
+bool saveAllItems(const ClipboardModel &model, const ItemSaverPtr &saver);
+
+/**
+ * Save all items from copy of items (see ClipboardModel::items()).
+ *
+ * Can be called from other thread if ItemSaverInterface::prepareSaveItemsInBackground()
+ * returned true.
+ */
+bool saveAllItems(
+        const QString &tabName, const QVector<ClipboardItem> &items, const ItemSaverPtr &saver);
+
 /** Save items with other plugin with higher priority than current one (@a loader). */
 bool saveItemsWithOther(ClipboardModel &model //!< Model containing items to save.
         , const ItemSaverPtr &oldSaver, ItemFactory *itemFactory);
 
+/**
+ * Save texts to search in items (see ItemFactory::searchableTexts()) so the
+ * tab can be searched without loading it.
+ *
+ * Should be called after items are saved and before the tab is unloaded,
+ * only if the saver stores plain data (see ItemSaverInterface::storesPlainData()).
+ * The index is removed when the tab file or its journal change.
+ */
+bool saveItemSearchIndex(const QString &tabName, const QVector<QStringList> &texts);
+
+/**
+ * Load texts saved with saveItemSearchIndex().
+ * @return false if the index is missing or outdated
+ */
+bool loadItemSearchIndex(const QString &tabName, QVector<QStringList> *texts);
+
+/** Return true if search index is valid for current tab file. */
+bool hasItemSearchIndex(const QString &tabName);
+
+/** Return archive for items removed from full tab (see ItemArchive). */
+ItemArchivePtr createItemArchive(const QString &tabName //!< See ClipboardBrowser::getID().
+        );
+
 /** Remove configuration file for items. */
 void removeItems(const QString &tabName //!< See ClipboardBrowser::getID().
         );
@@ -0,0 +1,67 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "itemtabsearch.h"
+
+#include <algorithm>
+
+ItemTabSearch::ItemTabSearch(const QRegExp &re)
+    : m_matcher(re)
+    , m_fuzzyMatcher( FuzzyMatcher::fromRegExp(re) )
+    , m_tabCount(0)
+    , m_results()
+{
+}
+
+void ItemTabSearch::addTab(const QString &tabName, const QVector<QStringList> &texts)
+{
+    const int tabIndex = m_tabCount++;
+
+    for (int row = 0; row < texts.size(); ++row) {
+        const QStringList &itemTexts = texts[row];
+        if ( !m_matcher.matchesAny(itemTexts) )
+            continue;
+
+        const int score = m_fuzzyMatcher.isEmpty() ? 0 : m_fuzzyMatcher.score(itemTexts);
+        const ItemTabSearchResult result = {tabName, row, score};
+        const Result tabResult = {tabIndex, result};
+        m_results.append(tabResult);
+    }
+}
+
+QVector<ItemTabSearchResult> ItemTabSearch::results(int maxCount) const
+{
+    QVector<Result> sortedResults = m_results;
+    std::stable_sort( sortedResults.begin(), sortedResults.end(), [](const Result &lhs, const Result &rhs) {
+        if (lhs.result.score != rhs.result.score)
+            return lhs.result.score > rhs.result.score;
+        if (lhs.result.row != rhs.result.row)
+            return lhs.result.row < rhs.result.row;
+        return lhs.tabIndex < rhs.tabIndex;
+    });
+
+    const int count = maxCount < 0 ? sortedResults.size() : qMin(maxCount, sortedResults.size());
+    QVector<ItemTabSearchResult> results;
+    results.reserve(count);
+    for (int i = 0; i < count; ++i)
+        results.append(sortedResults[i].result);
+
+    return results;
+}
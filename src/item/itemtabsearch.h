@@ -0,0 +1,69 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ITEMTABSEARCH_H
+#define ITEMTABSEARCH_H
+
+#include "common/fuzzymatcher.h"
+#include "common/textmatcher.h"
+
+#include <QRegExp>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct ItemTabSearchResult {
+    QString tabName;
+    int row;
+    int score;
+};
+
+/**
+ * Searches items in multiple tabs and merges results.
+ *
+ * Item matches if any of its texts (see ItemFactory::searchableTexts())
+ * contains match for the filter expression. Results are ranked by fuzzy
+ * match score if the expression was created by FuzzyMatcher::regExp(),
+ * then by row (newer items first) and order in which tabs were added.
+ */
+class ItemTabSearch
+{
+public:
+    explicit ItemTabSearch(const QRegExp &re);
+
+    /** Search items of a tab given by texts of each item. */
+    void addTab(const QString &tabName, const QVector<QStringList> &texts);
+
+    /** Return best results (all if @a maxCount is negative). */
+    QVector<ItemTabSearchResult> results(int maxCount = -1) const;
+
+private:
+    struct Result {
+        int tabIndex;
+        ItemTabSearchResult result;
+    };
+
+    TextMatcher m_matcher;
+    FuzzyMatcher m_fuzzyMatcher;
+    int m_tabCount;
+    QVector<Result> m_results;
+};
+
+#endif // ITEMTABSEARCH_H
@@ -277,6 +277,26 @@ bool ItemSaverInterface::saveItems(const QAbstractItemModel &, QIODevice *)
     return false;
 }
 
+bool ItemSaverInterface::prepareSaveItemsInBackground()
+{
+    return false;
+}
+
+bool ItemSaverInterface::storesPlainData() const
+{
+    return false;
+}
+
+bool ItemSaverInterface::saveChanges(const QAbstractItemModel &, QIODevice *)
+{
+    return false;
+}
+
+bool ItemSaverInterface::loadChanges(QAbstractItemModel *, QIODevice *)
+{
+    return false;
+}
+
 bool ItemSaverInterface::canRemoveItems(const QList<QModelIndex> &, QString *)
 {
     return true;
@@ -331,9 +351,9 @@ ItemSaverPtr ItemLoaderInterface::transformSaver(const ItemSaverPtr &saver, QAbs
     return saver;
 }
 
-bool ItemLoaderInterface::matches(const QModelIndex &, const QRegExp &) const
+QString ItemLoaderInterface::searchableText(const QModelIndex &) const
 {
-    return false;
+    return QString();
 }
 
 QObject *ItemLoaderInterface::tests(const TestInterfacePtr &) const
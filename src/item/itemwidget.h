@@ -45,7 +45,7 @@ using ItemLoaderPtr = std::shared_ptr<ItemLoaderInterface>;
 class ItemSaverInterface;
 using ItemSaverPtr = std::shared_ptr<ItemSaverInterface>;
 
-#define COPYQ_PLUGIN_ITEM_LOADER_ID "org.CopyQ.ItemPlugin.ItemLoader/1.0"
+#define COPYQ_PLUGIN_ITEM_LOADER_ID "org.CopyQ.ItemPlugin.ItemLoader/1.1"
 
 #if QT_VERSION < 0x050000
 #   define Q_PLUGIN_METADATA(x)
@@ -190,6 +190,43 @@ public:
      */
     virtual bool saveItems(const QAbstractItemModel &model, QIODevice *file);
 
+    /**
+     * Prepare to save copy of current items in another thread.
+     *
+     * Called in main thread just before the copy is created. If true is returned,
+     * saveItems() is later called in another thread with model containing the copy
+     * and it must not access anything else than the model and the file.
+     *
+     * @return true only if items can be saved in another thread (default is false)
+     */
+    virtual bool prepareSaveItemsInBackground();
+
+    /**
+     * Return true only if items are saved unencrypted in tab data file.
+     *
+     * Only then can other files with item data (search index and archive of
+     * removed items) be created for the tab.
+     *
+     * @return true only if item data can be stored in plain form (default is false)
+     */
+    virtual bool storesPlainData() const;
+
+    /**
+     * Save only changes made to items since they were last saved or loaded.
+     *
+     * Changes are appended to journal @a file which can already contain changes
+     * from previous calls. Nothing should be written if there are no new changes.
+     *
+     * @return true only if changes were saved, false to save all items with saveItems()
+     */
+    virtual bool saveChanges(const QAbstractItemModel &model, QIODevice *file);
+
+    /**
+     * Apply changes saved with saveChanges() to loaded items.
+     * @return true only if all changes were applied
+     */
+    virtual bool loadChanges(QAbstractItemModel *model, QIODevice *file);
+
     /**
      * Called before items are deleted by user.
      * @return true if items can be removed, false to cancel the removal
@@ -318,10 +355,14 @@ public:
     virtual ItemSaverPtr transformSaver(const ItemSaverPtr &loader, QAbstractItemModel *model);
 
     /**
-     * Return true if regular expression matches items content.
-     * Returns false by default.
+     * Return item text to search in when filtering items.
+     *
+     * Item matches filter if text from any loader matches. Texts are cached
+     * until item data change.
+     *
+     * Returns empty string by default.
      */
-    virtual bool matches(const QModelIndex &index, const QRegExp &re) const;
+    virtual QString searchableText(const QModelIndex &index) const;
 
     /**
      * Return object with tests.
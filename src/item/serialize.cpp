@@ -19,23 +19,27 @@
 
 #include "serialize.h"
 
-#include "common/contenttype.h"
 #include "common/log.h"
 #include "common/mimetypes.h"
+#include "item/encodeditem.h"
+#include "item/itemcodec.h"
 
-#include <QAbstractItemModel>
 #include <QByteArray>
 #include <QDataStream>
 #include <QIODevice>
-#include <QList>
 #include <QObject>
-#include <QPair>
-#include <QStringList>
+#include <QVector>
 
 #include <cstring>
 
 namespace {
 
+/// Marks item data with compression flag for each format.
+const qint32 itemMarkerV2 = -2;
+
+/// Marks item data with codec for each format (used only if needed).
+const qint32 itemMarkerV3 = -3;
+
 template <typename Fn>
 bool mimeIdApply(Fn fn)
 {
@@ -55,6 +59,41 @@ bool mimeIdApply(Fn fn)
         || fn(11, "video/");
 }
 
+QString compressMime(const QString &mime)
+{
+    QString compressedMime;
+    const bool found = mimeIdApply(
+        [&mime, &compressedMime](int mimeId, const char *mimePrefix) {
+            if ( mime.startsWith(mimePrefix) ) {
+                const auto prefixSize = static_cast<int>( strlen(mimePrefix) );
+                compressedMime = QString::number(mimeId, 16) + mime.mid(prefixSize);
+                return true;
+            }
+            return false;
+        });
+
+    if (found)
+        return compressedMime;
+
+    return "0" + mime;
+}
+
+/// Read codec or compression flag (if @a hasCodec is false).
+int readCodec(QDataStream *stream, bool hasCodec)
+{
+    if (hasCodec) {
+        quint8 codec;
+        *stream >> codec;
+        return codec;
+    }
+
+    bool compressed;
+    *stream >> compressed;
+    return compressed ? CodecZlib : CodecNone;
+}
+
+} // namespace
+
 QString decompressMime(const QString &mime)
 {
     bool ok;
@@ -78,117 +117,113 @@ QString decompressMime(const QString &mime)
     return mime.mid(1);
 }
 
-QString compressMime(const QString &mime)
+bool readEncodedItem(QDataStream *stream, EncodedItem *item)
 {
-    QString compressedMime;
-    const bool found = mimeIdApply(
-        [&mime, &compressedMime](int mimeId, const char *mimePrefix) {
-            if ( mime.startsWith(mimePrefix) ) {
-                const auto prefixSize = static_cast<int>( strlen(mimePrefix) );
-                compressedMime = QString::number(mimeId, 16) + mime.mid(prefixSize);
-                return true;
-            }
+    qint32 length;
+    *stream >> length;
+    if ( stream->status() != QDataStream::Ok )
+        return false;
+
+    // Deprecated format starts with number of formats and has only zlib compressed data.
+    const bool deprecated = length >= 0;
+    const bool hasCodec = length == itemMarkerV3;
+    if (!deprecated) {
+        if (length != itemMarkerV2 && length != itemMarkerV3) {
+            stream->setStatus(QDataStream::ReadCorruptData);
             return false;
-        });
+        }
+        *stream >> length;
+    }
 
-    if (found)
-        return compressedMime;
+    EncodedFormat format;
+    format.mimeCompressed = !deprecated;
+    for (qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i) {
+        *stream >> format.mime;
+        if (deprecated) {
+            *stream >> format.bytes;
+            format.codec = format.bytes.isEmpty() ? CodecNone : CodecZlib;
+        } else {
+            format.codec = readCodec(stream, hasCodec);
+            *stream >> format.bytes;
+        }
+        item->append(format);
+    }
 
-    return "0" + mime;
+    return stream->status() == QDataStream::Ok;
 }
 
-bool shouldCompress(const QByteArray &bytes, const QString &mime)
+bool decodeItem(const EncodedItem &item, QVariantMap *data)
 {
-    return bytes.size() > 256
-            && ( !mime.startsWith("image/") || mime.contains("bmp") || mime.contains("xml") || mime.contains("svg") );
-}
+    QByteArray bytes;
+    for (const auto &format : item) {
+        if ( !decodeData(format.codec, format.bytes, &bytes) )
+            return false;
 
-bool deserializeDataV2(QDataStream *out, QVariantMap *data)
-{
-    qint32 size;
-    *out >> size;
-
-    QString mime;
-    QByteArray tmpBytes;
-    bool compress;
-    for (qint32 i = 0; i < size && out->status() == QDataStream::Ok; ++i) {
-        *out >> mime >> compress >> tmpBytes;
-        if(compress) {
-            tmpBytes = qUncompress(tmpBytes);
-            if ( tmpBytes.isEmpty() ) {
-                out->setStatus(QDataStream::ReadCorruptData);
-                break;
-            }
-        }
-        mime = decompressMime(mime);
-        data->insert(mime, tmpBytes);
+        const QString mime = format.mimeCompressed ? decompressMime(format.mime) : format.mime;
+        data->insert(mime, bytes);
     }
 
-    return out->status() == QDataStream::Ok;
+    return true;
 }
 
-} // namespace
-
-void serializeData(QDataStream *stream, const QVariantMap &data)
+void serializeData(QDataStream *stream, const QVariantMap &data, bool tabFileFormat)
 {
-    *stream << static_cast<qint32>(-2);
+    QVector<ItemCodec> codecs;
+    QVector<QByteArray> storedBytes;
+    codecs.reserve( data.size() );
+    storedBytes.reserve( data.size() );
+
+    // Older format with just compression flag is used unless other codecs are needed.
+    bool hasCodec = false;
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        const QByteArray bytes = it.value().toByteArray();
+        int level;
+        QByteArray encodedBytes;
+        ItemCodec codec = codecForData(bytes, it.key(), &level, &encodedBytes);
+        if (!tabFileFormat && codec != CodecNone && codec != CodecZlib) {
+            codec = CodecZlib;
+            level = -1;
+            encodedBytes.clear();
+        }
+        codecs.append(codec);
+        storedBytes.append( codec == CodecNone || encodedBytes.isEmpty()
+                            ? encodeData(codec, bytes, level) : encodedBytes );
+        hasCodec = hasCodec || (codec != CodecNone && codec != CodecZlib);
+    }
+
+    *stream << (hasCodec ? itemMarkerV3 : itemMarkerV2);
 
     const qint32 size = data.size();
     *stream << size;
 
-    QByteArray bytes;
-    for (const auto &mime : data.keys()) {
-        bytes = data[mime].toByteArray();
-        bool compress = shouldCompress(bytes, mime);
-        *stream << compressMime(mime) << compress << ( compress ? qCompress(bytes) : bytes );
+    int i = 0;
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it, ++i) {
+        *stream << compressMime(it.key());
+        if (hasCodec)
+            *stream << static_cast<quint8>(codecs[i]);
+        else
+            *stream << (codecs[i] == CodecZlib);
+        *stream << storedBytes[i];
     }
 }
 
 void deserializeData(QDataStream *stream, QVariantMap *data)
 {
     try {
-        qint32 length;
-
-        *stream >> length;
-        if ( stream->status() != QDataStream::Ok )
-            return;
-
-        if (length == -2) {
-            deserializeDataV2(stream, data);
-            return;
-        }
-
-        if (length < 0) {
+        EncodedItem item;
+        if ( readEncodedItem(stream, &item) && !decodeItem(item, data) )
             stream->setStatus(QDataStream::ReadCorruptData);
-            return;
-        }
-
-        // Deprecated format.
-        // TODO: Data should be saved again in new format.
-        QString mime;
-        QByteArray tmpBytes;
-        for (qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i) {
-            *stream >> mime >> tmpBytes;
-            if( !tmpBytes.isEmpty() ) {
-                tmpBytes = qUncompress(tmpBytes);
-                if ( tmpBytes.isEmpty() ) {
-                    stream->setStatus(QDataStream::ReadCorruptData);
-                    break;
-                }
-            }
-            data->insert(mime, tmpBytes);
-        }
     } catch (const std::exception &e) {
         log( QObject::tr("Data deserialization failed: %1").arg(e.what()), LogError );
         stream->setStatus(QDataStream::ReadCorruptData);
     }
 }
 
-QByteArray serializeData(const QVariantMap &data)
+QByteArray serializeData(const QVariantMap &data, bool tabFileFormat)
 {
     QByteArray bytes;
     QDataStream out(&bytes, QIODevice::WriteOnly);
-    serializeData(&out, data);
+    serializeData(&out, data, tabFileFormat);
     return bytes;
 }
 
@@ -198,59 +233,3 @@ bool deserializeData(QVariantMap *data, const QByteArray &bytes)
     deserializeData(&out, data);
     return out.status() == QDataStream::Ok;
 }
-
-bool serializeData(const QAbstractItemModel &model, QDataStream *stream)
-{
-    qint32 length = model.rowCount();
-    *stream << length;
-
-    for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i)
-        serializeData( stream, model.data(model.index(i, 0), contentType::data).toMap() );
-
-    return stream->status() == QDataStream::Ok;
-}
-
-bool deserializeData(QAbstractItemModel *model, QDataStream *stream, bool readAllItems)
-{
-    qint32 length;
-    *stream >> length;
-
-    if ( stream->status() != QDataStream::Ok )
-        return false;
-
-    if (length < 0) {
-        stream->setStatus(QDataStream::ReadCorruptData);
-        return false;
-    }
-
-    if (!readAllItems) {
-        // Limit the loaded number of items to model's maximum.
-        const QVariant maxItems = model->property("maxItems");
-        Q_ASSERT( maxItems.isValid() );
-        length = qMin( length, maxItems.toInt() ) - model->rowCount();
-    }
-
-    if ( length != 0 && !model->insertRows(0, length) )
-        return false;
-
-    for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i) {
-        QVariantMap data;
-        deserializeData(stream, &data);
-        model->setData( model->index(i, 0), data, contentType::data );
-    }
-
-    return stream->status() == QDataStream::Ok;
-}
-
-bool serializeData(const QAbstractItemModel &model, QIODevice *file)
-{
-    QDataStream stream(file);
-    stream.setVersion(QDataStream::Qt_4_7);
-    return serializeData(model, &stream);
-}
-
-bool deserializeData(QAbstractItemModel *model, QIODevice *file)
-{
-    QDataStream stream(file);
-    return deserializeData(model, &stream);
-}
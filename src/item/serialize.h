@@ -20,6 +20,7 @@
 #ifndef SERIALIZE_H
 #define SERIALIZE_H
 
+#include <QSet>
 #include <QVariantMap>
 
 class QAbstractItemModel;
@@ -27,14 +28,32 @@ class QByteArray;
 class QDataStream;
 class QIODevice;
 
-void serializeData(QDataStream *out, const QVariantMap &data);
+/**
+ * Serialize item data.
+ *
+ * Data can be compressed with all codecs (see ItemCodec) only if @a tabFileFormat
+ * is true, otherwise only with zlib so data can be read by older versions (e.g.
+ * data for other processes, exported or dragged items).
+ */
+void serializeData(QDataStream *out, const QVariantMap &data, bool tabFileFormat = false);
 void deserializeData(QDataStream *stream, QVariantMap *data);
-QByteArray serializeData(const QVariantMap &data);
+QByteArray serializeData(const QVariantMap &data, bool tabFileFormat = false);
 bool deserializeData(QVariantMap *data, const QByteArray &bytes);
 
+/*
+ * Saving and loading models and tab files (implemented in serializemodel.cpp)
+ * is available only in the application, not in plugins, since it uses
+ * process-wide item data stores (see ClipboardModel).
+ */
 bool serializeData(const QAbstractItemModel &model, QDataStream *stream);
 bool deserializeData(QAbstractItemModel *model, QDataStream *stream, bool readAllItems = false);
 bool serializeData(const QAbstractItemModel &model, QIODevice *file);
 bool deserializeData(QAbstractItemModel *model, QIODevice *file);
 
+/**
+ * Add content hashes of data saved in blob files by serializeData() to @a hashes.
+ * @return false if the file is empty or truncated, or if it has items saved with blobs but it's corrupted
+ */
+bool readBlobHashes(QIODevice *file, QSet<QByteArray> *hashes);
+
 #endif // SERIALIZE_H
@@ -0,0 +1,699 @@
+/*
+    Copyright (c) 2017, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "serialize.h"
+
+#include "common/common.h"
+#include "common/contenttype.h"
+#include "common/log.h"
+#include "item/clipboardmodel.h"
+#include "item/encodeditem.h"
+#include "item/itemblobstore.h"
+#include "item/itemcodec.h"
+#include "item/itempayload.h"
+
+#include <QAbstractItemModel>
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QIODevice>
+#include <QObject>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include <memory>
+
+namespace {
+
+/// Marks tab file with item data followed by item index (data are loaded on demand).
+const qint32 indexedTabFileMarker = -3;
+
+/// Same as indexedTabFileMarker but bigger data can be stored in blob files.
+const qint32 blobTabFileMarker = -4;
+
+/// Same as blobTabFileMarker but with codec (see ItemCodec) instead of compression flag.
+const qint32 codecTabFileMarker = -5;
+
+/// Same as codecTabFileMarker but formats are stored only once in index and referenced by ID.
+const qint32 formatDictionaryTabFileMarker = -6;
+
+/// Same as formatDictionaryTabFileMarker but with 64-bit item hash and hash of each format.
+const qint32 formatHashTabFileMarker = -7;
+
+/// Decode items in multiple threads only if there is enough data.
+const qint64 minBytesToDecodeInParallel = 512 * 1024;
+
+/// Maximum number of items read from stream before they are decoded and added to model.
+const int maxItemsInDecodeSlice = 4096;
+
+/// Items are decoded and added to model after reading this much encoded data.
+const qint64 maxBytesInDecodeSlice = 64 * 1024 * 1024;
+
+/// Items to decode shared by all threads.
+struct DecodeItemsContext {
+    QVector<EncodedItem> items;
+    QVector<QVariantMap> dataList;
+    int sliceSize = 0;
+    int sliceCount = 0;
+    QAtomicInt nextSlice;
+    QAtomicInt failedCount;
+    QSemaphore decodedSlices;
+};
+
+using DecodeItemsContextPtr = std::shared_ptr<DecodeItemsContext>;
+
+/// Decode remaining slices of items (called from multiple threads).
+void decodeItemSlices(DecodeItemsContext *context)
+{
+    for ( int slice = context->nextSlice.fetchAndAddOrdered(1);
+          slice < context->sliceCount;
+          slice = context->nextSlice.fetchAndAddOrdered(1) )
+    {
+        const QVector<EncodedItem> &items = context->items;
+        const int from = slice * context->sliceSize;
+        const int to = qMin(from + context->sliceSize, items.size());
+        for (int i = from; i < to; ++i) {
+            QVariantMap &data = context->dataList[i];
+            if ( !decodeItem(items[i], &data) ) {
+                context->failedCount.fetchAndAddOrdered(1);
+                continue;
+            }
+
+            // Calculate content hash of bigger data here so it's fast to add items to model.
+            for (auto it = data.begin(); it != data.end(); ++it) {
+                const QByteArray bytes = it.value().toByteArray();
+                if (bytes.size() >= minBlobSize)
+                    it.value() = internBlob(bytes);
+            }
+        }
+
+        context->decodedSlices.release();
+    }
+}
+
+class DecodeItemsWorker : public QRunnable
+{
+public:
+    explicit DecodeItemsWorker(const DecodeItemsContextPtr &context)
+        : m_context(context)
+    {
+    }
+
+    void run() override
+    {
+        decodeItemSlices( m_context.get() );
+    }
+
+private:
+    DecodeItemsContextPtr m_context;
+};
+
+/**
+ * Decode items in contiguous slices using thread pool.
+ *
+ * Current thread decodes slices too, so items are decoded even if other threads are busy.
+ */
+bool decodeItems(const QVector<EncodedItem> &items, qint64 encodedSize, QVector<QVariantMap> *dataList)
+{
+    const auto context = std::make_shared<DecodeItemsContext>();
+    context->items = items;
+    context->dataList.resize( items.size() );
+
+    const int threadCount = encodedSize < minBytesToDecodeInParallel
+            ? 1 : qMax(1, QThread::idealThreadCount());
+    context->sliceCount = qMin( items.size(), threadCount * 4 );
+    context->sliceSize = context->sliceCount > 0
+            ? (items.size() + context->sliceCount - 1) / context->sliceCount : 0;
+
+    for (int i = 1; i < qMin(threadCount, context->sliceCount); ++i)
+        QThreadPool::globalInstance()->start( new DecodeItemsWorker(context) );
+
+    decodeItemSlices( context.get() );
+    context->decodedSlices.acquire(context->sliceCount);
+
+    if ( context->failedCount.fetchAndAddOrdered(0) != 0 )
+        return false;
+
+    *dataList = context->dataList;
+    return true;
+}
+
+/// Limit the loaded number of items to model's maximum.
+qint32 itemCountToLoad(const QAbstractItemModel &model, qint32 length)
+{
+    const QVariant maxItems = model.property("maxItems");
+    Q_ASSERT( maxItems.isValid() );
+    return qMin( length, maxItems.toInt() ) - model.rowCount();
+}
+
+/**
+ * Encode data of single format for saving in tab file.
+ *
+ * Bigger data are saved in blob file instead if @a useBlobs is true.
+ */
+bool encodeFormat(const QString &mime, const QByteArray &bytes, bool useBlobs, ItemEncodedFormat *encoded)
+{
+    int level;
+    QByteArray encodedBytes;
+    const ItemCodec codec = codecForData(bytes, mime, &level, &encodedBytes);
+
+    if (useBlobs && bytes.size() >= minBlobSize)
+        return saveBlob(blobHash(bytes), bytes, codec, level, &encoded->payload);
+
+    encoded->payload.codec = codec;
+    encoded->bytes = codec == CodecNone || encodedBytes.isEmpty()
+            ? encodeData(codec, bytes, level) : encodedBytes;
+    return true;
+}
+
+/// Return true if any data are referenced in blob file which no longer exists.
+bool hasMissingBlob(const ItemEncodedFormats &storedData)
+{
+    for (const auto &encoded : storedData) {
+        if ( !encoded.payload.blobHash.isEmpty() && !hasBlob(encoded.payload.blobHash) )
+            return true;
+    }
+
+    return false;
+}
+
+/**
+ * Save items in indexed format.
+ *
+ * Data of all formats are written first and index is written at the end.
+ * Header contains offset of the index so items can be loaded without reading any data.
+ *
+ * Bigger data are saved in shared blob files instead (only if saving to a file).
+ *
+ * Data of items unchanged since last save or load are not encoded again
+ * (see ClipboardItem::encodedCache()) and data not loaded yet are copied
+ * without decoding them, unless they reference missing blob file.
+ *
+ * Format:
+ *   qint32 -7, qint32 item count, qint64 index offset,
+ *   data of formats,
+ *   index: qint32 format count, for each format: QString MIME,
+ *          for each item: quint64 hash, qint32 format count,
+ *          for each format: qint32 format ID (position in the format list), quint8 codec,
+ *                           qint64 offset, qint32 size,
+ *                           QByteArray blob hash (empty if data are in the tab file),
+ *                           quint64 hash of decoded data (see hashFormatData())
+ *
+ * Offsets are relative to the beginning of the header (or blob file).
+ *
+ * Older formats:
+ *   -6: same as -7 but quint32 item hash (different algorithm) and no hash of formats
+ *   -5: compressed MIME (see compressMime()) instead of format ID, no format list
+ *   -4: same as -5 but bool compressed (zlib) instead of codec
+ *   -3: same as -4 but without blob hash
+ */
+bool serializeIndexedData(const QAbstractItemModel &model, QIODevice *file)
+{
+    const qint64 start = file->pos();
+    const bool useBlobs = qobject_cast<QFile*>(file) != nullptr;
+    const auto clipboardModel = qobject_cast<const ClipboardModel*>(&model);
+
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    const qint32 length = model.rowCount();
+    stream << formatHashTabFileMarker << length << static_cast<qint64>(0);
+
+    QByteArray index;
+    QDataStream indexStream(&index, QIODevice::WriteOnly);
+    indexStream.setVersion(QDataStream::Qt_4_7);
+
+    QVector<QString> formats;
+    QHash<QString, qint32> formatIds;
+
+    const auto writeFormat = [&](const QString &mime, const ItemEncodedFormat &encoded, quint64 formatHash) {
+        auto formatId = formatIds.constFind(mime);
+        if ( formatId == formatIds.constEnd() ) {
+            formatId = formatIds.insert( mime, static_cast<qint32>(formats.size()) );
+            formats.append(mime);
+        }
+
+        const ItemPayload &payload = encoded.payload;
+        if ( !payload.blobHash.isEmpty() ) {
+            indexStream << formatId.value() << static_cast<quint8>(payload.codec)
+                        << payload.offset << payload.size << payload.blobHash << formatHash;
+            return true;
+        }
+
+        const qint64 offset = file->pos() - start;
+        if ( file->write(encoded.bytes) != encoded.bytes.size() )
+            return false;
+
+        indexStream << formatId.value() << static_cast<quint8>(payload.codec) << offset
+                    << static_cast<qint32>(encoded.bytes.size()) << QByteArray() << formatHash;
+        return true;
+    };
+
+    for (qint32 i = 0; i < length && stream.status() == QDataStream::Ok; ++i) {
+        const QModelIndex itemIndex = model.index(i, 0);
+
+        // Cache is used only for tab files since other devices don't use blob files.
+        // Data not loaded yet are copied from file as stored without keeping them in memory.
+        QVariantMap data;
+        ItemEncodedFormats storedData;
+        ItemEncodedCachePtr cache;
+        if (clipboardModel && useBlobs) {
+            clipboardModel->dataToSave(i, &data, &storedData);
+            cache = clipboardModel->encodedCache(i);
+
+            // Blob files can be removed since items were loaded, so such data are
+            // loaded (possibly still mapped in memory) and encoded again.
+            if ( hasMissingBlob(storedData) ) {
+                data = clipboardModel->readItemData(i);
+                storedData.clear();
+            }
+        } else if (clipboardModel) {
+            data = clipboardModel->readItemData(i);
+        } else {
+            data = model.data(itemIndex, contentType::data).toMap();
+        }
+
+        const quint64 itemHash = model.data(itemIndex, contentType::hash).toULongLong();
+
+        indexStream << itemHash << static_cast<qint32>( data.size() + storedData.size() );
+
+        for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+            const QString &mime = it.key();
+
+            ItemEncodedFormat encoded;
+            const bool cached = cache && cache->find(mime, &encoded)
+                    && ( encoded.payload.blobHash.isEmpty() || hasBlob(encoded.payload.blobHash) );
+            if (!cached) {
+                if ( !encodeFormat(mime, it.value().toByteArray(), useBlobs, &encoded) )
+                    return false;
+                if (cache)
+                    cache->insert(mime, encoded);
+            }
+
+            const quint64 formatHash = clipboardModel
+                    ? clipboardModel->formatHash(i, mime)
+                    : hashFormatData( it.value().toByteArray() );
+
+            if ( !writeFormat(mime, encoded, formatHash) )
+                return false;
+        }
+
+        for (auto it = storedData.constBegin(); it != storedData.constEnd(); ++it) {
+            if ( !writeFormat(it.key(), it.value(), clipboardModel->formatHash(i, it.key())) )
+                return false;
+        }
+    }
+
+    const qint64 indexOffset = file->pos() - start;
+
+    stream << static_cast<qint32>( formats.size() );
+    for (const auto &format : formats)
+        stream << format;
+
+    if ( stream.status() != QDataStream::Ok || file->write(index) != index.size() )
+        return false;
+
+    const qint64 end = file->pos();
+    if ( !file->seek(start + 2 * static_cast<qint64>(sizeof(qint32))) )
+        return false;
+
+    stream << indexOffset;
+
+    return file->seek(end) && stream.status() == QDataStream::Ok;
+}
+
+bool isIndexedTabFileMarker(qint32 marker)
+{
+    return marker == indexedTabFileMarker
+        || marker == blobTabFileMarker
+        || marker == codecTabFileMarker
+        || marker == formatDictionaryTabFileMarker
+        || marker == formatHashTabFileMarker;
+}
+
+/**
+ * Read header of indexed format (except the leading marker) and seek to the index.
+ *
+ * Reads list of formats at the beginning of the index if the format has it.
+ *
+ * @return true only if successful
+ */
+bool readIndexHeader(
+        QIODevice *file, QDataStream *stream, qint64 start, qint32 marker,
+        qint32 *length, qint64 *indexOffset, QVector<QString> *formats)
+{
+    *stream >> *length >> *indexOffset;
+
+    if ( stream->status() != QDataStream::Ok )
+        return false;
+
+    if ( *length < 0 || *indexOffset < 0 || start + *indexOffset > file->size()
+         || !file->seek(start + *indexOffset) )
+    {
+        stream->setStatus(QDataStream::ReadCorruptData);
+        return false;
+    }
+
+    if (marker != formatDictionaryTabFileMarker && marker != formatHashTabFileMarker)
+        return true;
+
+    qint32 formatCount;
+    *stream >> formatCount;
+    if (formatCount < 0)
+        stream->setStatus(QDataStream::ReadCorruptData);
+
+    QString format;
+    for (qint32 i = 0; i < formatCount && stream->status() == QDataStream::Ok; ++i) {
+        *stream >> format;
+        formats->append(format);
+    }
+
+    return stream->status() == QDataStream::Ok;
+}
+
+/**
+ * Read single item from index.
+ *
+ * Payloads stored in the tab file reference @a payloadFile.
+ *
+ * Formats are shared with @a formats if the index contains format list.
+ *
+ * Item hash is 0 for older formats since it was computed differently.
+ */
+bool readIndexedItem(
+        QDataStream *stream, qint32 marker, qint64 start, qint64 indexOffset,
+        const QVector<QString> &formats, const ItemPayloadFilePtr &payloadFile, bool map,
+        quint64 *itemHash, ItemPayloads *payloads)
+{
+    const bool hasHashes = marker == formatHashTabFileMarker;
+    const bool hasFormatIds = marker == formatDictionaryTabFileMarker || hasHashes;
+    const bool hasCodec = marker == codecTabFileMarker || hasFormatIds;
+
+    if (hasHashes) {
+        *stream >> *itemHash;
+    } else {
+        quint32 oldItemHash;
+        *stream >> oldItemHash;
+        *itemHash = 0;
+    }
+
+    qint32 formatCount;
+    *stream >> formatCount;
+
+    QString mime;
+    qint32 formatId;
+    qint64 offset;
+    qint32 size;
+    QByteArray hash;
+    quint64 formatHash = 0;
+
+    for (qint32 j = 0; j < formatCount && stream->status() == QDataStream::Ok; ++j) {
+        if (hasFormatIds) {
+            *stream >> formatId;
+            if (formatId < 0 || formatId >= formats.size()) {
+                stream->setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+            mime = formats[formatId];
+        } else {
+            *stream >> mime;
+            mime = decompressMime(mime);
+        }
+
+        const int codec = readCodec(stream, hasCodec);
+        *stream >> offset >> size;
+        if (marker != indexedTabFileMarker)
+            *stream >> hash;
+        if (hasHashes)
+            *stream >> formatHash;
+
+        if ( offset < 0 || size < 0 || (hash.isEmpty() && offset + size > indexOffset) ) {
+            stream->setStatus(QDataStream::ReadCorruptData);
+            break;
+        }
+
+        ItemPayload payload;
+        if ( hash.isEmpty() ) {
+            payload.file = payloadFile;
+            payload.offset = start + offset;
+        } else {
+            payload.file = blobPayloadFile(hash, map);
+            payload.offset = offset;
+            payload.blobHash = hash;
+        }
+        payload.size = size;
+        payload.codec = codec;
+        payload.hash = formatHash;
+        payloads->insert(mime, payload);
+    }
+
+    return stream->status() == QDataStream::Ok;
+}
+
+/**
+ * Load items saved with serializeIndexedData() (except the leading marker).
+ *
+ * If possible, items only reference data in the file and load them when requested.
+ */
+bool deserializeIndexedData(QAbstractItemModel *model, QIODevice *file, qint64 start, qint32 marker)
+{
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    qint32 length;
+    qint64 indexOffset;
+    QVector<QString> formats;
+    if ( !readIndexHeader(file, &stream, start, marker, &length, &indexOffset, &formats) )
+        return false;
+
+    length = itemCountToLoad(*model, length);
+
+    // Data are loaded later only for files opened by ClipboardModel.
+    auto clipboardModel = qobject_cast<ClipboardModel*>(model);
+    auto tabFile = qobject_cast<QFile*>(file);
+    const bool map = clipboardModel && clipboardModel->mapItemData();
+    ItemPayloadFilePtr payloadFile;
+    if (clipboardModel && tabFile && !tabFile->fileName().isEmpty())
+        payloadFile = std::make_shared<ItemPayloadFile>(tabFile->fileName(), map);
+
+    // Items are added to ClipboardModel at once.
+    QVector<ClipboardItem> items;
+    if (clipboardModel)
+        items.reserve(length);
+    else if ( length != 0 && !model->insertRows(0, length) )
+        return false;
+
+    for (qint32 i = 0; i < length; ++i) {
+        quint64 itemHash;
+        ItemPayloads payloads;
+        if ( !readIndexedItem(&stream, marker, start, indexOffset, formats, payloadFile, map, &itemHash, &payloads) )
+            return false;
+
+        if (payloadFile) {
+            ClipboardItem item;
+            item.setPayloads(payloads, itemHash);
+            items.append(item);
+        } else {
+            const qint64 pos = file->pos();
+
+            QVariantMap data;
+            ItemPayloads blobPayloads;
+            QByteArray bytes;
+            for (auto it = payloads.constBegin(); it != payloads.constEnd(); ++it) {
+                if ( it.value().file ) {
+                    blobPayloads.insert( it.key(), it.value() );
+                } else if ( readPayload(file, it.value(), &bytes) ) {
+                    data.insert(it.key(), bytes);
+                } else {
+                    stream.setStatus(QDataStream::ReadCorruptData);
+                    return false;
+                }
+            }
+
+            if ( !loadPayloads(blobPayloads, &data) || !file->seek(pos) )
+                return false;
+
+            if (clipboardModel) {
+                ClipboardItem item;
+                item.setData(data);
+                items.append(item);
+            } else {
+                model->setData( model->index(i, 0), data, contentType::data );
+            }
+        }
+    }
+
+    if (clipboardModel)
+        clipboardModel->insertItems(items, 0);
+
+    return stream.status() == QDataStream::Ok;
+}
+
+} // namespace
+
+bool serializeData(const QAbstractItemModel &model, QDataStream *stream)
+{
+    qint32 length = model.rowCount();
+    *stream << length;
+
+    for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i)
+        serializeData( stream, model.data(model.index(i, 0), contentType::data).toMap() );
+
+    return stream->status() == QDataStream::Ok;
+}
+
+bool deserializeData(QAbstractItemModel *model, QDataStream *stream, bool readAllItems)
+{
+    qint32 length;
+    *stream >> length;
+
+    if ( stream->status() != QDataStream::Ok )
+        return false;
+
+    if (length < 0) {
+        stream->setStatus(QDataStream::ReadCorruptData);
+        return false;
+    }
+
+    if (!readAllItems)
+        length = itemCountToLoad(*model, length);
+
+    if (length < 0)
+        return false;
+
+    // Read items sequentially in bounded slices, decode each slice in parallel
+    // and add it to model at once. Item count from stream is not trusted to
+    // allocate memory upfront.
+    auto clipboardModel = qobject_cast<ClipboardModel*>(model);
+    qint32 row = 0;
+    try {
+        while (row < length) {
+            QVector<EncodedItem> items;
+            qint64 encodedSize = 0;
+            while ( row + items.size() < length
+                    && items.size() < maxItemsInDecodeSlice
+                    && encodedSize < maxBytesInDecodeSlice )
+            {
+                EncodedItem item;
+                if ( !readEncodedItem(stream, &item) )
+                    return false;
+                for (const auto &format : item)
+                    encodedSize += format.bytes.size();
+                items.append(item);
+            }
+
+            QVector<QVariantMap> dataList;
+            if ( !decodeItems(items, encodedSize, &dataList) ) {
+                stream->setStatus(QDataStream::ReadCorruptData);
+                return false;
+            }
+
+            if (clipboardModel) {
+                clipboardModel->insertItems(dataList, row);
+            } else {
+                if ( !model->insertRows(row, dataList.size()) )
+                    return false;
+
+                for (int i = 0; i < dataList.size(); ++i)
+                    model->setData( model->index(row + i, 0), dataList[i], contentType::data );
+            }
+
+            row += dataList.size();
+        }
+    } catch (const std::exception &e) {
+        log( QObject::tr("Data deserialization failed: %1").arg(e.what()), LogError );
+        stream->setStatus(QDataStream::ReadCorruptData);
+        return false;
+    }
+
+    return true;
+}
+
+bool serializeData(const QAbstractItemModel &model, QIODevice *file)
+{
+    if ( !file->isSequential() )
+        return serializeIndexedData(model, file);
+
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+    return serializeData(model, &stream);
+}
+
+bool deserializeData(QAbstractItemModel *model, QIODevice *file)
+{
+    const qint64 start = file->pos();
+
+    QDataStream stream(file);
+
+    qint32 marker;
+    stream >> marker;
+    if ( stream.status() != QDataStream::Ok )
+        return false;
+
+    if ( isIndexedTabFileMarker(marker) )
+        return deserializeIndexedData(model, file, start, marker);
+
+    // Older format starts with number of items.
+    if ( !file->seek(start) )
+        return false;
+
+    return deserializeData(model, &stream);
+}
+
+bool readBlobHashes(QIODevice *file, QSet<QByteArray> *hashes)
+{
+    const qint64 start = file->pos();
+
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    // Empty or incomplete file can be a tab file being saved.
+    qint32 marker;
+    stream >> marker;
+    if ( stream.status() != QDataStream::Ok )
+        return false;
+
+    // Other formats don't reference blob files.
+    if ( !isIndexedTabFileMarker(marker) || marker == indexedTabFileMarker )
+        return true;
+
+    qint32 length;
+    qint64 indexOffset;
+    QVector<QString> formats;
+    if ( !readIndexHeader(file, &stream, start, marker, &length, &indexOffset, &formats) )
+        return false;
+
+    for (qint32 i = 0; i < length; ++i) {
+        quint64 itemHash;
+        ItemPayloads payloads;
+        if ( !readIndexedItem(&stream, marker, start, indexOffset, formats, nullptr, false, &itemHash, &payloads) )
+            return false;
+
+        for (const auto &payload : payloads) {
+            if ( !payload.blobHash.isEmpty() )
+                hashes->insert(payload.blobHash);
+        }
+    }
+
+    return true;
+}
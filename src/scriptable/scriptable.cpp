@@ -174,6 +174,13 @@ QByteArray serializeScriptValue(const QScriptValue &value)
     return data;
 }
 
+/// Prints search result as tab name and row separated by tab character (e.g. on command line).
+QScriptValue searchResultToString(QScriptContext *context, QScriptEngine *)
+{
+    const QScriptValue result = context->thisObject();
+    return result.property("tab").toString() + '\t' + result.property("row").toString();
+}
+
 QString createScriptErrorMessage(const QString &text)
 {
     return "ScriptError: " + text;
@@ -1035,6 +1042,12 @@ QScriptValue Scriptable::info()
 #endif
                 );
 
+    if (m_proxy) {
+        const QVariantMap memoryUsage = m_proxy->itemMemoryUsage();
+        info.insert("item-data-in-memory", memoryUsage.value("resident").toString());
+        info.insert("item-data-in-files", memoryUsage.value("stored").toString());
+    }
+
     const QString name = arg(0);
     if (!name.isEmpty())
         return info.value(name);
@@ -1332,6 +1345,88 @@ void Scriptable::setItem()
         throwError(error);
 }
 
+QScriptValue Scriptable::fuzzyFind()
+{
+    m_skipArguments = 1;
+
+    if ( argumentCount() < 1 ) {
+        throwError(argumentError());
+        return QScriptValue();
+    }
+
+    return toScriptValue( m_proxy->browserFindFuzzy(arg(0)), this );
+}
+
+QScriptValue Scriptable::searchTabs()
+{
+    m_skipArguments = 1;
+
+    if ( argumentCount() < 1 ) {
+        throwError(argumentError());
+        return QScriptValue();
+    }
+
+    const auto results = m_proxy->searchTabs(arg(0));
+
+    const QScriptValue toString = engine()->newFunction(searchResultToString);
+    QScriptValue array = engine()->newArray();
+    for ( int i = 0; i < results.size(); ++i ) {
+        QScriptValue result = engine()->newObject();
+        result.setProperty( "tab", results[i].tabName );
+        result.setProperty( "row", results[i].row );
+        result.setProperty( "toString", toString, QScriptValue::SkipInEnumeration );
+        array.setProperty( static_cast<quint32>(i), result );
+    }
+
+    return array;
+}
+
+QScriptValue Scriptable::archiveSize()
+{
+    m_skipArguments = 0;
+    return m_proxy->browserArchiveSize();
+}
+
+QScriptValue Scriptable::archiveItem()
+{
+    m_skipArguments = 1;
+
+    int index;
+    if ( !toInt(argument(0), index) ) {
+        throwError(argumentError());
+        return QScriptValue();
+    }
+
+    return toScriptValue( m_proxy->browserArchivedItemData(index), this );
+}
+
+QScriptValue Scriptable::archiveFind()
+{
+    m_skipArguments = 1;
+
+    if ( argumentCount() < 1 ) {
+        throwError(argumentError());
+        return QScriptValue();
+    }
+
+    return toScriptValue( m_proxy->browserFindArchivedItems(arg(0)), this );
+}
+
+void Scriptable::archiveRestore()
+{
+    const QList<int> indexes = getRows();
+    m_skipArguments = indexes.size();
+
+    if ( indexes.isEmpty() ) {
+        throwError(argumentError());
+        return;
+    }
+
+    const auto error = m_proxy->browserRestoreArchivedItems(indexes);
+    if ( !error.isEmpty() )
+        throwError(error);
+}
+
 QScriptValue Scriptable::toBase64()
 {
     m_skipArguments = 1;
@@ -249,6 +249,15 @@ public slots:
     void setItem();
     void setitem() { setItem(); }
 
+    QScriptValue fuzzyFind();
+
+    QScriptValue searchTabs();
+
+    QScriptValue archiveSize();
+    QScriptValue archiveItem();
+    QScriptValue archiveFind();
+    void archiveRestore();
+
     QScriptValue toBase64();
     QScriptValue tobase64() { return toBase64(); }
     QScriptValue fromBase64();
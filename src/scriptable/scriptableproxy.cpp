@@ -22,6 +22,7 @@
 #include "common/commandstatus.h"
 #include "common/common.h"
 #include "common/contenttype.h"
+#include "common/fuzzymatcher.h"
 #include "common/log.h"
 #include "common/mimetypes.h"
 #include "common/settings.h"
@@ -30,6 +31,7 @@
 #include "gui/mainwindow.h"
 #include "gui/tabicons.h"
 #include "gui/windowgeometryguard.h"
+#include "item/clipboardmodel.h"
 #include "item/serialize.h"
 #include "platform/platformnativeinterface.h"
 #include "platform/platformwindow.h"
@@ -611,6 +613,27 @@ QStringList ScriptableProxy::tabs()
     return m_wnd->tabs();
 }
 
+QVector<ItemTabSearchResult> ScriptableProxy::searchTabs(const QString &pattern)
+{
+    INVOKE(searchTabs(pattern));
+    const QRegExp re(pattern, Qt::CaseInsensitive, QRegExp::RegExp2);
+    return m_wnd->searchTabs(re);
+}
+
+QVariantMap ScriptableProxy::itemMemoryUsage()
+{
+    INVOKE(itemMemoryUsage());
+
+    qint64 residentBytes;
+    qint64 storedBytes;
+    ClipboardModel::totalMemoryUsage(&residentBytes, &storedBytes);
+
+    QVariantMap result;
+    result["resident"] = residentBytes;
+    result["stored"] = storedBytes;
+    return result;
+}
+
 bool ScriptableProxy::toggleVisible()
 {
     INVOKE(toggleVisible());
@@ -714,10 +737,14 @@ QString ScriptableProxy::browserAdd(const QStringList &texts)
     if ( !c->allocateSpaceForNewItems(texts.size()) )
         return "Tab is full (cannot remove any items)";
 
-    for (const auto &text : texts) {
-        if ( !c->add(text) )
-            return "Failed to new add items";
-    }
+    // Last item is at the top.
+    QVector<QVariantMap> dataList;
+    dataList.reserve( texts.size() );
+    for (int i = texts.size() - 1; i >= 0; --i)
+        dataList.append( createDataMap(mimeText, texts[i]) );
+
+    if ( !c->add(dataList) )
+        return "Failed to new add items";
 
     return QString();
 }
@@ -762,6 +789,48 @@ QVariantMap ScriptableProxy::browserItemData(int arg1)
     return itemData(arg1);
 }
 
+int ScriptableProxy::browserArchiveSize()
+{
+    INVOKE(browserArchiveSize());
+    ClipboardBrowser *c = fetchBrowser();
+    return c ? c->archivedItemCount() : 0;
+}
+
+QVariantMap ScriptableProxy::browserArchivedItemData(int index)
+{
+    INVOKE(browserArchivedItemData(index));
+    ClipboardBrowser *c = fetchBrowser();
+    return c ? c->archivedItems(index, 1).value(0) : QVariantMap();
+}
+
+QList<int> ScriptableProxy::browserFindArchivedItems(const QString &pattern)
+{
+    INVOKE(browserFindArchivedItems(pattern));
+    ClipboardBrowser *c = fetchBrowser();
+    const QRegExp re(pattern, Qt::CaseInsensitive, QRegExp::RegExp2);
+    return c ? c->findArchivedItems(re) : QList<int>();
+}
+
+QList<int> ScriptableProxy::browserFindFuzzy(const QString &text)
+{
+    INVOKE(browserFindFuzzy(text));
+    ClipboardBrowser *c = fetchBrowser();
+    return c ? c->findFuzzy( FuzzyMatcher(text, Qt::CaseInsensitive) ) : QList<int>();
+}
+
+QString ScriptableProxy::browserRestoreArchivedItems(const QList<int> &indexes)
+{
+    INVOKE(browserRestoreArchivedItems(indexes));
+    ClipboardBrowser *c = fetchBrowser();
+    if (!c)
+        return QString("Invalid tab");
+
+    if ( !c->restoreArchivedItems(indexes) )
+        return QString("Failed to restore archived items");
+
+    return QString();
+}
+
 void ScriptableProxy::setCurrentTab(const QString &tabName)
 {
     INVOKE2(setCurrentTab(tabName));
@@ -21,6 +21,7 @@
 #define SCRIPTABLEPROXY_H
 
 #include "gui/clipboardbrowser.h"
+#include "item/itemtabsearch.h"
 
 #include <QClipboard>
 #include <QList>
@@ -99,6 +100,12 @@ public:
     void browserEditNew(const QString &arg1, bool changeClipboard);
 
     QStringList tabs();
+
+    /** Return items matching @a pattern in all tabs, best matches first. */
+    QVector<ItemTabSearchResult> searchTabs(const QString &pattern);
+
+    /** Return size of item data in memory ("resident") and in files ("stored"). */
+    QVariantMap itemMemoryUsage();
     bool toggleVisible();
     bool toggleMenu(const QString &tabName, int maxItemCount);
     bool toggleMenu();
@@ -126,6 +133,12 @@ public:
     QByteArray browserItemData(int arg1, const QString &arg2);
     QVariantMap browserItemData(int arg1);
 
+    int browserArchiveSize();
+    QVariantMap browserArchivedItemData(int index);
+    QList<int> browserFindArchivedItems(const QString &pattern);
+    QList<int> browserFindFuzzy(const QString &text);
+    QString browserRestoreArchivedItems(const QList<int> &indexes);
+
     void setCurrentTab(const QString &tabName);
 
     void setTab(const QString &tabName);
@@ -39,8 +39,10 @@ HEADERS += \
     common/command.h \
     common/common.h \
     common/contenttype.h \
+    common/fuzzymatcher.h \
     common/option.h \
     common/server.h \
+    common/textmatcher.h \
     gui/aboutdialog.h \
     gui/actiondialog.h \
     gui/actionhandler.h \
@@ -80,6 +82,7 @@ HEADERS += \
     item/itemfactory.h \
     item/itemwidget.h \
     item/serialize.h \
+    item/encodeditem.h \
     platform/dummy/dummyplatform.h \
     platform/platformnativeinterface.h \
     ../qt/bytearrayclass.h \
@@ -122,7 +125,18 @@ HEADERS += \
     gui/logdialog.h \
     common/appconfig.h \
     gui/tabicons.h \
+    item/itemarchive.h \
     item/itemstore.h \
+    item/itemblobstore.h \
+    item/itemcodec.h \
+    item/itemdata.h \
+    item/itemfiltermatches.h \
+    item/itemfilterrunner.h \
+    item/itemjournal.h \
+    item/itempayload.h \
+    item/itemsavequeue.h \
+    item/itemsearchindex.h \
+    item/itemtabsearch.h \
     gui/theme.h \
     gui/menuitems.h
 SOURCES += \
@@ -136,9 +150,11 @@ SOURCES += \
     common/client_server.cpp \
     common/clientsocket.cpp \
     common/common.cpp \
+    common/fuzzymatcher.cpp \
     common/messagehandlerforqt.cpp \
     common/option.cpp \
     common/server.cpp \
+    common/textmatcher.cpp \
     gui/aboutdialog.cpp \
     gui/actiondialog.cpp \
     gui/actionhandler.cpp \
@@ -177,6 +193,7 @@ SOURCES += \
     item/itemfactory.cpp \
     item/itemwidget.cpp \
     item/serialize.cpp \
+    item/serializemodel.cpp \
     main.cpp \
     ../qt/bytearrayclass.cpp \
     ../qt/bytearrayprototype.cpp \
@@ -213,7 +230,18 @@ SOURCES += \
     gui/logdialog.cpp \
     common/appconfig.cpp \
     gui/tabicons.cpp \
+    item/itemarchive.cpp \
     item/itemstore.cpp \
+    item/itemblobstore.cpp \
+    item/itemcodec.cpp \
+    item/itemdata.cpp \
+    item/itemfiltermatches.cpp \
+    item/itemfilterrunner.cpp \
+    item/itemjournal.cpp \
+    item/itempayload.cpp \
+    item/itemsavequeue.cpp \
+    item/itemsearchindex.cpp \
+    item/itemtabsearch.cpp \
     gui/theme.cpp \
     gui/menuitems.cpp
 
@@ -23,15 +23,28 @@
 #include "app/remoteprocess.h"
 #include "common/client_server.h"
 #include "common/common.h"
+#include "common/contenttype.h"
+#include "common/fuzzymatcher.h"
 #include "common/mimetypes.h"
 #include "common/monitormessagecode.h"
+#include "common/textmatcher.h"
 #include "common/version.h"
+#include "item/clipboardmodel.h"
+#include "item/itemblobstore.h"
+#include "item/itemcodec.h"
+#include "item/itemdata.h"
 #include "item/itemfactory.h"
+#include "item/itemfiltermatches.h"
+#include "item/itemfilterrunner.h"
+#include "item/itempayload.h"
+#include "item/itemsearchindex.h"
+#include "item/itemtabsearch.h"
 #include "item/itemwidget.h"
 #include "item/serialize.h"
 #include "gui/configtabshortcuts.h"
 
 #include <QApplication>
+#include <QBitArray>
 #include <QClipboard>
 #include <QDebug>
 #include <QDir>
@@ -41,6 +54,7 @@
 #include <QMimeData>
 #include <QProcess>
 #include <QRegExp>
+#include <QSignalSpy>
 #include <QTemporaryFile>
 #include <QTest>
 #include <QTimerEvent>
@@ -526,6 +540,51 @@ QString keyNameFor(QKeySequence::StandardKey standardKey)
     return QKeySequence(standardKey).toString();
 }
 
+/// Container previously used in ClipboardModel (for comparison in benchmarks).
+class QListItemList {
+public:
+    void insert(int row, const ClipboardItem &item) { m_items.insert(row, item); }
+
+    void remove(int row, int count)
+    {
+        const auto from = m_items.begin() + row;
+        m_items.erase(from, from + count);
+    }
+
+    int size() const { return m_items.size(); }
+
+    void move(int from, int to)
+    {
+        const ClipboardItem item = m_items[from];
+        m_items.removeAt(from);
+        m_items.insert(to, item);
+    }
+
+private:
+    QList<ClipboardItem> m_items;
+};
+
+template <typename ItemList>
+void benchmarkItemList(int itemCount)
+{
+    ItemList items;
+    for (int i = 0; i < itemCount; ++i)
+        items.insert(0, ClipboardItem());
+
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i) {
+            // New item is added to the top and the last one is removed.
+            items.insert(0, ClipboardItem());
+            items.remove(items.size() - 1, 1);
+
+            // Older item is copied again.
+            items.move(items.size() * 3 / 4, 0);
+        }
+    }
+
+    QCOMPARE(items.size(), itemCount);
+}
+
 } // namespace
 
 Tests::Tests(const TestInterfacePtr &test, QObject *parent)
@@ -1208,11 +1267,18 @@ void Tests::configMaxitems()
     RUN("separator" << " " << "read" << "0" << "1", "F E");
     RUN("size", "2\n");
 
-    // Ading too many items fails.
-    RUN_EXPECT_ERROR("add" << "1" << "2" << "3", CommandException);
-    RUN("separator" << " " << "read" << "0" << "1", "F E");
+    // Only the newest items are added if there are too many.
+    RUN("add" << "1" << "2" << "3", "");
+    RUN("separator" << " " << "read" << "0" << "1", "3 2");
+    RUN("size", "2\n");
+
+    RUN("add" << "4" << "5" << "6" << "7" << "8", "");
+    RUN("separator" << " " << "read" << "0" << "1", "8 7");
     RUN("size", "2\n");
 
+    RUN("add" << "E" << "F", "");
+    RUN("separator" << " " << "read" << "0" << "1", "F E");
+
     // Single item in tabs.
     RUN("config" << "maxitems" << "1", "1\n");
     RUN("separator" << " " << "read" << "0", "F");
@@ -1239,6 +1305,35 @@ void Tests::configMaxitems()
     RUN("size", "0\n");
 }
 
+void Tests::archiveItems()
+{
+    RUN("config" << "archive_items" << "true", "true\n");
+    RUN("config" << "maxitems" << "3", "3\n");
+    RUN("add" << "A" << "B" << "C", "");
+    RUN("archiveSize", "0\n");
+
+    // Oldest items are archived.
+    RUN("add" << "D" << "E", "");
+    RUN("separator" << " " << "read" << "0" << "1" << "2", "E D C");
+    RUN("archiveSize", "2\n");
+    RUN("eval" << "str(archiveItem(0)[mimeText]) + str(archiveItem(1)[mimeText])", "BA\n");
+
+    RUN("add" << "F", "");
+    RUN("archiveSize", "3\n");
+    RUN("archiveFind" << "^[ac]$", "0\n2\n");
+
+    // Restored items are moved to the top and other items are archived.
+    RUN("archiveRestore" << "2", "");
+    RUN("separator" << " " << "read" << "0" << "1" << "2", "A F E");
+    RUN("archiveSize", "3\n");
+    RUN("eval" << "str(archiveItem(0)[mimeText]) + str(archiveItem(1)[mimeText]) + str(archiveItem(2)[mimeText])", "DCB\n");
+
+    // Items are not archived if disabled.
+    RUN("config" << "archive_items" << "false", "false\n");
+    RUN("add" << "G", "");
+    RUN("archiveSize", "3\n");
+}
+
 void Tests::keysAndFocusing()
 {
 #ifdef Q_OS_MAC
@@ -1624,6 +1719,61 @@ void Tests::importExportTab()
     RUN(args << "read" << "0" << "1" << "2" << "3", "012 abc def ghi");
 }
 
+void Tests::saveItemChanges()
+{
+    const auto args = Args("separator") << " ";
+
+    RUN(args << "add" << "C" << "B" << "A", "");
+
+    // All items are saved in tab file.
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN(args << "read" << "0" << "1" << "2", "A B C");
+
+    // Only changes are saved in journal.
+    RUN(args << "add" << "D" << "E", "");
+    RUN(args << "remove" << "3", "");
+    RUN(args << "change" << "1" << "text/plain" << "X", "");
+    RUN(args << "insert" << "2" << "Y", "");
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN(args << "read" << "0" << "1" << "2" << "3" << "4", "E X Y A C");
+    RUN(args << "size", "5\n");
+}
+
+void Tests::saveSameDataInMultipleTabs()
+{
+    const QString tab1 = testTab(1);
+    const QString tab2 = testTab(2);
+    const QString text = QString(10000, 'x');
+
+    RUN("tab" << tab1 << "add" << text, "");
+    RUN("tab" << tab2 << "add" << "A" << text, "");
+
+    // Make too many changes to save only changes so bigger data are saved in shared blob files.
+    for ( const auto &tab : QStringList() << tab1 << tab2 << tab2 ) {
+        RUN("tab" << tab << "add" << "X", "");
+        RUN("tab" << tab << "remove" << "0", "");
+    }
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN("tab" << tab1 << "read" << "0", text);
+    RUN("tab" << tab2 << "read" << "0" << "1", text + "\nA");
+
+    // Data are still available in other tab after removing one.
+    RUN("removetab" << tab1, "");
+    for (int i = 0; i < 3; ++i) {
+        RUN("tab" << tab2 << "add" << "X", "");
+        RUN("tab" << tab2 << "remove" << "0", "");
+    }
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN("tab" << tab2 << "read" << "0" << "1", text + "\nA");
+}
+
 void Tests::removeAllFoundItems()
 {
     auto args = Args("add");
@@ -1967,6 +2117,822 @@ void Tests::configTrayTabIsCurrent()
     WAIT_FOR_CLIPBOARD("B");
 }
 
+void Tests::itemDataHash()
+{
+    QVariantMap data;
+    data.insert( mimeText, QByteArray("Item") );
+    data.insert( mimeHtml, QByteArray("<b>Item</b>") );
+    data.insert( mimeWindowTitle, QByteArray("Window") );
+
+    QVariantMap otherData = data;
+    otherData.insert( mimeWindowTitle, QByteArray("Other window") );
+    QCOMPARE( hash(otherData), hash(data) );
+
+    otherData.insert( mimeText, QByteArray("Other item") );
+    QVERIFY( hash(otherData) != hash(data) );
+
+    // Swapped data in formats.
+    otherData.insert( mimeText, data.value(mimeHtml) );
+    otherData.insert( mimeHtml, data.value(mimeText) );
+    QVERIFY( hash(otherData) != hash(data) );
+
+    ClipboardModel model;
+    model.setMaxItems(10);
+    model.insertItems(QVector<QVariantMap>() << otherData << data, 0);
+    QCOMPARE( model.index(0).data(contentType::hash).toULongLong(), hash(otherData) );
+    QCOMPARE( model.findItem(hash(data)), 1 );
+
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    QVERIFY( serializeData(model, &file) );
+
+    // Hashes are loaded from tab file.
+    ClipboardModel loadedModel;
+    loadedModel.setMaxItems(10);
+    QVERIFY( file.seek(0) );
+    QVERIFY( deserializeData(&loadedModel, &file) );
+    QCOMPARE( loadedModel.findItem(hash(otherData)), 0 );
+    QCOMPARE( loadedModel.findItem(hash(data)), 1 );
+
+    // Hash is updated when data change.
+    QVariantMap changedData = data;
+    changedData.insert( mimeText, QByteArray("Changed item") );
+    QVERIFY( loadedModel.setData(loadedModel.index(1), changedData, contentType::data) );
+    QCOMPARE( loadedModel.findItem(hash(changedData)), 1 );
+    QCOMPARE( loadedModel.index(1).data(contentType::data).toMap(), changedData );
+}
+
+void Tests::batchModelChanges()
+{
+    qRegisterMetaType<QModelIndex>("QModelIndex");
+
+    ClipboardModel model;
+    model.setMaxItems(10);
+
+    QVector<QVariantMap> dataList;
+    for (int i = 0; i < 6; ++i)
+        dataList.append( createDataMap(mimeText, QString::number(i)) );
+
+    QSignalSpy insertedSpy(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+    model.insertItems(dataList, 0);
+    QCOMPARE( insertedSpy.count(), 1 );
+    QCOMPARE( model.rowCount(), 6 );
+
+    QMap<int, QVariantMap> changes;
+    changes.insert( 1, createDataMap(mimeText, QString("A")) );
+    changes.insert( 4, createDataMap(mimeText, QString("B")) );
+    changes.insert( 5, dataList[5] );
+    QSignalSpy changedSpy(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex)));
+    QCOMPARE( model.setItemsData(changes), 2 );
+    QCOMPARE( changedSpy.count(), 1 );
+    QCOMPARE( model.index(4).data(contentType::text).toString(), QString("B") );
+    QCOMPARE( model.findItem(hash(changes[1])), 1 );
+
+    // Consecutive rows are removed at once.
+    QSignalSpy removedSpy(&model, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+    model.removeItems(QList<int>() << 0 << 5 << 1 << 4 << 0);
+    QCOMPARE( removedSpy.count(), 2 );
+    QCOMPARE( model.rowCount(), 2 );
+    QCOMPARE( model.index(0).data(contentType::text).toString(), QString("2") );
+    QCOMPARE( model.index(1).data(contentType::text).toString(), QString("3") );
+    QCOMPARE( model.findItem(hash(dataList[3])), 1 );
+}
+
+void Tests::deserializeItemsInSlices()
+{
+    // More items than are decoded at once.
+    const int itemCount = 5000;
+
+    ClipboardModel model;
+    model.setMaxItems(itemCount);
+
+    QVector<QVariantMap> dataList;
+    for (int i = 0; i < itemCount; ++i)
+        dataList.append( createDataMap(mimeText, QString::number(i)) );
+    model.insertItems(dataList, 0);
+
+    QByteArray bytes;
+    {
+        QDataStream out(&bytes, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_4_7);
+        QVERIFY( serializeData(model, &out) );
+    }
+
+    // Items keep order.
+    ClipboardModel loadedModel;
+    loadedModel.setMaxItems(itemCount);
+    QDataStream in(bytes);
+    in.setVersion(QDataStream::Qt_4_7);
+    QVERIFY( deserializeData(&loadedModel, &in, true) );
+    QCOMPARE( loadedModel.rowCount(), itemCount );
+    QCOMPARE( loadedModel.index(0).data(contentType::text).toString(), QString("0") );
+    QCOMPARE( loadedModel.index(itemCount - 1).data(contentType::text).toString(), QString::number(itemCount - 1) );
+
+    // Invalid item count doesn't allocate memory for all items upfront.
+    QByteArray corruptedBytes = bytes;
+    corruptedBytes.replace( 0, 4, QByteArray("\x7f\xff\xff\xff", 4) );
+    ClipboardModel corruptedModel;
+    corruptedModel.setMaxItems(itemCount);
+    QDataStream corruptedIn(corruptedBytes);
+    corruptedIn.setVersion(QDataStream::Qt_4_7);
+    QVERIFY( !deserializeData(&corruptedModel, &corruptedIn, true) );
+    QVERIFY( corruptedModel.rowCount() <= itemCount );
+}
+
+void Tests::lzCodec()
+{
+    QByteArray random(64 * 1024, '\0');
+    quint32 seed = 1;
+    for (int i = 0; i < random.size(); ++i) {
+        seed = seed * 1103515245u + 12345u;
+        random[i] = static_cast<char>(seed >> 24);
+    }
+
+    const QList<QByteArray> inputs = QList<QByteArray>()
+            << QByteArray()
+            << QByteArray("a")
+            << QByteArray("abcd")
+            << QByteArray(100000, 'x')
+            << QByteArray("Lorem ipsum dolor sit amet. ").repeated(1000)
+            << random;
+
+    for (const auto &input : inputs) {
+        const QByteArray encoded = encodeData(CodecLz, input);
+        QByteArray decoded;
+        QVERIFY( decodeData(CodecLz, encoded, &decoded) );
+        QCOMPARE( decoded, input );
+
+        // Truncated data.
+        if ( !input.isEmpty() ) {
+            QVERIFY( !decodeData(CodecLz, encoded.left(encoded.size() - 1), &decoded) );
+            QVERIFY( !decodeData(CodecLz, encoded.left(3), &decoded) );
+        }
+    }
+
+    // Incompressible data don't grow much.
+    QVERIFY( encodeData(CodecLz, random).size() < random.size() + random.size() / 100 );
+
+    const QByteArray encoded = encodeData(CodecLz, inputs[4]);
+    QVERIFY( encoded.size() < inputs[4].size() / 10 );
+    QByteArray decoded;
+
+    // Wrong decoded size in header.
+    QByteArray corrupted = encoded;
+    corrupted[0] = static_cast<char>(corrupted[0] + 1);
+    QVERIFY( !decodeData(CodecLz, corrupted, &decoded) );
+
+    // Decoded size over the limit.
+    corrupted = encoded;
+    corrupted[3] = static_cast<char>(0x7F);
+    QVERIFY( !decodeData(CodecLz, corrupted, &decoded) );
+
+    // Decoded size bigger than data can expand to: size 256 MiB, single literal.
+    const char tooBigSize[] = {0, 0, 0, 0x10, 0x10, 'x'};
+    decoded.clear();
+    QVERIFY( !decodeData(CodecLz, QByteArray(tooBigSize, sizeof(tooBigSize)), &decoded) );
+    QVERIFY( decoded.isEmpty() );
+
+    // Match before beginning of data: size 8, token with no literals and match, offset 1.
+    const char invalidOffset[] = {8, 0, 0, 0, 0x04, 1, 0};
+    QVERIFY( !decodeData(CodecLz, QByteArray(invalidOffset, sizeof(invalidOffset)), &decoded) );
+
+    // Trailing garbage.
+    QVERIFY( !decodeData(CodecLz, encoded + QByteArray("xyz"), &decoded) );
+
+    // Codec is used only in tab files, other data can be read by older versions.
+    QVariantMap data;
+    data.insert( mimeText, inputs[4] );
+    qint32 marker;
+    QDataStream(serializeData(data)) >> marker;
+    QCOMPARE( marker, static_cast<qint32>(-2) );
+    QDataStream(serializeData(data, true)) >> marker;
+    QCOMPARE( marker, static_cast<qint32>(-3) );
+
+    QVariantMap deserialized;
+    QVERIFY( deserializeData(&deserialized, serializeData(data)) );
+    QCOMPARE( deserialized, data );
+    deserialized.clear();
+    QVERIFY( deserializeData(&deserialized, serializeData(data, true)) );
+    QCOMPARE( deserialized, data );
+}
+
+void Tests::spillItemData()
+{
+    const QByteArray image(64 * 1024, 'x');
+
+    ClipboardModel model;
+    model.setMaxItems(10);
+    {
+        QVariantMap data;
+        data.insert( mimeText, QByteArray("Item") );
+        data.insert( "image/png", QByteArray(image.constData(), image.size()) );
+        model.insertItems(QVector<QVariantMap>() << data, 0);
+    }
+
+    // Only data encoded for saving can be moved to spill file.
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    QVERIFY( serializeData(model, &file) );
+
+    qint64 residentBytes;
+    qint64 storedBytes;
+    model.memoryUsage(&residentBytes, &storedBytes);
+    QVERIFY( residentBytes >= image.size() );
+    QCOMPARE( storedBytes, Q_INT64_C(0) );
+
+    ClipboardModel::setMinIdleTimeToSpill(0);
+    model.setMemoryLimit(1);
+    model.releaseMemory();
+    ClipboardModel::setMinIdleTimeToSpill(10000);
+
+    // Neither decoded nor encoded data are kept in memory.
+    model.memoryUsage(&residentBytes, &storedBytes);
+    QCOMPARE( residentBytes, Q_INT64_C(0) );
+    QVERIFY( storedBytes > 0 );
+
+    // Shared data are released too (same data are not returned from memory).
+    const QByteArray imageCopy(image.constData(), image.size());
+    QCOMPARE( internBlob(imageCopy).constData(), imageCopy.constData() );
+
+    // Data are loaded again when needed.
+    const QVariantMap data = model.index(0).data(contentType::data).toMap();
+    QCOMPARE( data.value(mimeText).toByteArray(), QByteArray("Item") );
+    QCOMPARE( data.value("image/png").toByteArray(), image );
+}
+
+void Tests::itemFormatIds()
+{
+    const QString prefix("application/x-copyq-test-format-");
+    QCOMPARE( findItemFormatId(prefix + "missing"), -1 );
+    QCOMPARE( itemFormatName(-1), QString() );
+
+    // Ids stay valid when the table of formats grows.
+    QVector<int> ids;
+    for (int i = 0; i < 1000; ++i)
+        ids.append( itemFormatId(prefix + QString::number(i)) );
+
+    for (int i = 0; i < ids.size(); ++i) {
+        const QString format = prefix + QString::number(i);
+        QCOMPARE( itemFormatId(format), ids[i] );
+        QCOMPARE( findItemFormatId(format), ids[i] );
+        QCOMPARE( itemFormatName(ids[i]), format );
+    }
+}
+
+void Tests::mapItemData()
+{
+#ifdef Q_OS_WIN
+    SKIP("Item data are not mapped on Windows");
+#endif
+
+    // Uncompressed data small enough not to be saved in blob file.
+    const QByteArray image(1024, 'x');
+
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    {
+        ClipboardModel model;
+        model.setMaxItems(10);
+        QVariantMap data;
+        data.insert( "image/png", image );
+        model.insertItems(QVector<QVariantMap>() << data, 0);
+        QVERIFY( serializeData(model, &file) );
+    }
+
+    const int mappedFileCount = ItemPayloadFile::mappedFileCount();
+    QByteArray loadedImage;
+    {
+        ClipboardModel model;
+        model.setMaxItems(10);
+        model.setMapItemData(true);
+        QVERIFY( file.seek(0) );
+        QVERIFY( deserializeData(&model, &file) );
+        QCOMPARE( model.rowCount(), 1 );
+
+        // File is mapped only when data are requested.
+        QCOMPARE( ItemPayloadFile::mappedFileCount(), mappedFileCount );
+        loadedImage = model.index(0).data(contentType::data).toMap().value("image/png").toByteArray();
+        QCOMPARE( loadedImage, image );
+        QCOMPARE( ItemPayloadFile::mappedFileCount(), mappedFileCount + 1 );
+
+        // Mapping is shared by all items from the same file.
+        model.index(0).data(contentType::data);
+        QCOMPARE( ItemPayloadFile::mappedFileCount(), mappedFileCount + 1 );
+
+        model.removeRows( 0, model.rowCount() );
+    }
+
+    // Mapping is kept while any data reference it.
+    ItemPayloadFile::releaseUnusedMappings();
+    QCOMPARE( ItemPayloadFile::mappedFileCount(), mappedFileCount + 1 );
+    QCOMPARE( loadedImage, image );
+
+    loadedImage.clear();
+    ItemPayloadFile::releaseUnusedMappings();
+    QCOMPARE( ItemPayloadFile::mappedFileCount(), mappedFileCount );
+}
+
+void Tests::saveItemsWithMissingBlob()
+{
+#ifdef Q_OS_WIN
+    SKIP("Item data are not mapped on Windows");
+#endif
+
+    // Uncompressed data big enough to be saved in blob file.
+    const QByteArray image = QByteArray(2 * minBlobSize, 'x')
+            + QByteArray::number( QDateTime::currentMSecsSinceEpoch() );
+    const QByteArray hash = blobHash(image);
+
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    {
+        ClipboardModel model;
+        model.setMaxItems(10);
+        QVariantMap data;
+        data.insert( "image/png", image );
+        model.insertItems(QVector<QVariantMap>() << data, 0);
+        QVERIFY( serializeData(model, &file) );
+    }
+    QVERIFY( hasBlob(hash) );
+
+    // Data are not loaded in the model to save.
+    ClipboardModel model;
+    model.setMaxItems(10);
+    model.setMapItemData(true);
+    QVERIFY( file.seek(0) );
+    QVERIFY( deserializeData(&model, &file) );
+
+    // Blob file is mapped while loading same data elsewhere.
+    ClipboardModel otherModel;
+    otherModel.setMaxItems(10);
+    otherModel.setMapItemData(true);
+    QVERIFY( file.seek(0) );
+    QVERIFY( deserializeData(&otherModel, &file) );
+    QCOMPARE( otherModel.index(0).data(contentType::data).toMap().value("image/png").toByteArray(), image );
+
+    QVERIFY( QFile::remove(blobPayloadFile(hash, false)->fileName()) );
+    QVERIFY( !hasBlob(hash) );
+
+    // Data are saved again instead of referencing missing blob file.
+    QTemporaryFile newFile;
+    QVERIFY( newFile.open() );
+    QVERIFY( serializeData(model, &newFile) );
+    QVERIFY( hasBlob(hash) );
+
+    ClipboardModel loadedModel;
+    loadedModel.setMaxItems(10);
+    QVERIFY( newFile.seek(0) );
+    QVERIFY( deserializeData(&loadedModel, &newFile) );
+    QCOMPARE( loadedModel.index(0).data(contentType::data).toMap().value("image/png").toByteArray(), image );
+}
+
+void Tests::searchIndex()
+{
+    qRegisterMetaType<QModelIndex>("QModelIndex");
+
+    ClipboardModel model;
+    model.setMaxItems(10);
+
+    QVector<QVariantMap> dataList;
+    for ( const auto &text : QStringList() << "apple pie" << "Banana split" << "pineapple" << "cherry" )
+        dataList.append( createDataMap(mimeText, text) );
+    model.insertItems(dataList, 0);
+
+    ItemSearchIndex index(&model, [](const QModelIndex &modelIndex) {
+        return modelIndex.data(contentType::text).toString();
+    });
+
+    // Returns candidate rows or "all" if the index cannot be used.
+    const auto candidates = [&](const QString &pattern) {
+        QBitArray rows;
+        if ( !index.findCandidateRows(QRegExp(pattern, Qt::CaseInsensitive, QRegExp::RegExp2), &rows) )
+            return QString("all");
+
+        QStringList result;
+        for (int row = 0; row < rows.size(); ++row) {
+            if ( rows.testBit(row) )
+                result.append( QString::number(row) );
+        }
+        return result.join(",");
+    };
+
+    QCOMPARE( candidates("apple"), QString("0,2") );
+    QCOMPARE( candidates("APP"), QString("0,2") );
+    QCOMPARE( candidates("xyz"), QString() );
+    QCOMPARE( candidates("pine.*ple"), QString("2") );
+    QCOMPARE( candidates("ban\\w+ split"), QString("1") );
+    QCOMPARE( candidates("cherr?y"), QString("3") );
+
+    // Index cannot narrow these expressions.
+    QCOMPARE( candidates("ap"), QString("all") );
+    QCOMPARE( candidates("apple|cherry"), QString("all") );
+    QCOMPARE( candidates("\\x0061pple"), QString("all") );
+
+    model.insertItems( QVector<QVariantMap>() << createDataMap(mimeText, QString("crab apple")), 1 );
+    QCOMPARE( candidates("apple"), QString("0,1,3") );
+
+    model.removeItems( QList<int>() << 0 );
+    QCOMPARE( candidates("apple"), QString("0,2") );
+
+    model.moveRows( QModelIndex(), 3, 1, QModelIndex(), 0 );
+    QCOMPARE( candidates("cherry"), QString("0") );
+    QCOMPARE( candidates("apple"), QString("1,3") );
+
+    QMap<int, QVariantMap> changes;
+    changes.insert( 0, createDataMap(mimeText, QString("cherry apple")) );
+    model.setItemsData(changes);
+    QCOMPARE( candidates("apple"), QString("0,1,3") );
+}
+
+void Tests::filterRefinement()
+{
+    const auto isRefinement = [](const QString &previous, const QString &pattern) {
+        return isFilterRefinement(
+                    QRegExp(previous, Qt::CaseInsensitive, QRegExp::RegExp2),
+                    QRegExp(pattern, Qt::CaseInsensitive, QRegExp::RegExp2) );
+    };
+
+    QVERIFY( isRefinement("app", "appl") );
+    QVERIFY( isRefinement("app", "pineapple") );
+    QVERIFY( isRefinement("foo.*ba", "foo.*bar") );
+    QVERIFY( isRefinement("foo.*bar", "foo.*bar.*x") );
+    QVERIFY( isRefinement("a\\.b", "a\\.b\\.c") );
+    QVERIFY( isRefinement("[ab]+", "[ab]+c") );
+
+    QVERIFY( !isRefinement("", "a") );
+    QVERIFY( !isRefinement("appl", "app") );
+    QVERIFY( !isRefinement("app", "app?") );
+    QVERIFY( !isRefinement("a|b", "a|bc") );
+    QVERIFY( !isRefinement("\\x004", "\\x0041") );
+    QVERIFY( !isRefinement("text", "text/plain") );
+    QVERIFY( !isFilterRefinement(
+                 QRegExp("app", Qt::CaseInsensitive), QRegExp("appl", Qt::CaseSensitive)) );
+
+    qRegisterMetaType<QModelIndex>("QModelIndex");
+
+    ClipboardModel model;
+    model.setMaxItems(10);
+
+    QVector<QVariantMap> dataList;
+    for (int i = 0; i < 4; ++i)
+        dataList.append( createDataMap(mimeText, QString::number(i)) );
+    model.insertItems(dataList, 0);
+
+    const QRegExp re("abc", Qt::CaseInsensitive, QRegExp::FixedString);
+    const QRegExp refined("abcd", Qt::CaseInsensitive, QRegExp::FixedString);
+
+    // Rows 1 and 2 match and row 3 was not tested.
+    QBitArray rows(3);
+    rows.setBit(1);
+    rows.setBit(2);
+
+    ItemFilterMatches matches;
+    matches.setMatches(&model, re, rows);
+
+    QBitArray candidates;
+    QVERIFY( !matches.findCandidateRows(&model, QRegExp("ab", Qt::CaseInsensitive, QRegExp::FixedString), &candidates) );
+    QVERIFY( matches.findCandidateRows(&model, refined, &candidates) );
+    QCOMPARE( candidates.size(), 4 );
+    QVERIFY( !candidates.testBit(0) );
+    QVERIFY( candidates.testBit(1) );
+    QVERIFY( candidates.testBit(2) );
+    QVERIFY( candidates.testBit(3) );
+
+    model.removeItems( QList<int>() << 1 );
+    QVERIFY( matches.findCandidateRows(&model, refined, &candidates) );
+    QCOMPARE( candidates.size(), 3 );
+    QVERIFY( !candidates.testBit(0) );
+    QVERIFY( candidates.testBit(1) );
+    QVERIFY( candidates.testBit(2) );
+
+    // New items were not tested.
+    model.insertItems( QVector<QVariantMap>() << createDataMap(mimeText, QString("abcd")), 0 );
+    QVERIFY( matches.findCandidateRows(&model, refined, &candidates) );
+    QCOMPARE( candidates.size(), 4 );
+    QVERIFY( candidates.testBit(0) );
+    QVERIFY( !candidates.testBit(1) );
+    QVERIFY( candidates.testBit(2) );
+    QVERIFY( candidates.testBit(3) );
+
+    // Changed items were not tested.
+    model.setData( model.index(1), createDataMap(mimeText, QString("abcde")), contentType::data );
+    QVERIFY( matches.findCandidateRows(&model, refined, &candidates) );
+    QVERIFY( candidates.testBit(1) );
+
+    // Matches are forgotten if items are moved.
+    model.move(3, 0);
+    QVERIFY( !matches.findCandidateRows(&model, refined, &candidates) );
+}
+
+void Tests::filterInBackground()
+{
+    QVector<QStringList> texts;
+    for (int i = 0; i < 2000; ++i)
+        texts.append( QStringList() << QString("item %1").arg(i) << (i % 3 == 0 ? "note" : "") );
+
+    ItemFilterRunner runner;
+    QSignalSpy filteredSpy(&runner, SIGNAL(filtered(int,QBitArray)));
+    QSignalSpy finishedSpy(&runner, SIGNAL(finished()));
+
+    // Canceled filtering doesn't emit any results.
+    runner.start( QRegExp("item"), texts );
+    runner.cancel();
+    QVERIFY( !runner.isRunning() );
+
+    runner.start( QRegExp("NOTE|item 1.*5$", Qt::CaseInsensitive), texts );
+    QVERIFY( runner.isRunning() );
+
+    SleepTimer t(10000);
+    while ( finishedSpy.isEmpty() && t.sleep() ) {}
+
+    QCOMPARE( finishedSpy.count(), 1 );
+    QVERIFY( filteredSpy.count() > 1 );
+    QVERIFY( !runner.isRunning() );
+
+    // Results are emitted in order.
+    QBitArray matches(texts.size());
+    int nextItem = 0;
+    for (const auto &arguments : filteredSpy) {
+        QCOMPARE( arguments[0].toInt(), nextItem );
+        const QBitArray chunkMatches = arguments[1].toBitArray();
+        for (int i = 0; i < chunkMatches.size(); ++i)
+            matches.setBit( nextItem + i, chunkMatches.testBit(i) );
+        nextItem += chunkMatches.size();
+    }
+    QCOMPARE( nextItem, texts.size() );
+
+    for (int i = 0; i < texts.size(); ++i) {
+        const bool expected = i % 3 == 0 || QRegExp("1\\d*5").exactMatch(QString::number(i));
+        QCOMPARE( matches.testBit(i), expected );
+    }
+}
+
+void Tests::fuzzyMatch()
+{
+    const FuzzyMatcher matcher("cq fg", Qt::CaseInsensitive);
+
+    QVERIFY( matcher.score("CopyQ config") >= 0 );
+    QVERIFY( matcher.score("cqfg") >= 0 );
+    QCOMPARE( matcher.score("copy config"), -1 );
+    QCOMPARE( matcher.score("gfqc"), -1 );
+
+    // Word starts and consecutive characters are preferred.
+    QVERIFY( matcher.score("CopyQ config") > matcher.score("acquire a figure") );
+    QVERIFY( matcher.score("cq-fg") > matcher.score("c_____q_____f_____g") );
+    QVERIFY( matcher.score(QStringList() << "x" << "cq fg") == matcher.score("cq fg") );
+
+    // Matching case is preferred.
+    QVERIFY( matcher.score("cqfg") > matcher.score("CQFG") );
+
+    // Regular expression matches the same texts.
+    const QRegExp re = matcher.regExp();
+    QCOMPARE( re.pattern(), QString("c.*q.*f.*g") );
+    QVERIFY( re.indexIn("CopyQ config") != -1 );
+    QVERIFY( re.indexIn("copy config") == -1 );
+
+    QCOMPARE( FuzzyMatcher::fromRegExp(re).regExp().pattern(), re.pattern() );
+    QVERIFY( FuzzyMatcher::fromRegExp(FuzzyMatcher("a.*", Qt::CaseSensitive).regExp()).score("a.b*") >= 0 );
+    QVERIFY( FuzzyMatcher::fromRegExp(QRegExp("ab")).isEmpty() );
+    QVERIFY( FuzzyMatcher::fromRegExp(QRegExp("a.*b.*")).isEmpty() );
+}
+
+void Tests::searchableTextsCache()
+{
+    ClipboardModel model;
+    model.setMaxItems(10);
+    model.insertItems( QVector<QVariantMap>() << createDataMap(mimeText, QString("apple")), 0 );
+
+    int callCount = 0;
+    model.setSearchableTextsFunction([&](const QModelIndex &index) {
+        ++callCount;
+        return QStringList() << index.data(contentType::text).toString();
+    });
+
+    const auto texts = [&]() {
+        return model.index(0).data(contentType::searchableTexts).toStringList();
+    };
+
+    QCOMPARE( texts(), QStringList() << "apple" );
+    QCOMPARE( texts(), QStringList() << "apple" );
+    QCOMPARE( callCount, 1 );
+
+    // Changing data drops cached texts.
+    model.setData( model.index(0), createDataMap(mimeText, QString("pie")), contentType::data );
+    QCOMPARE( texts(), QStringList() << "pie" );
+    QCOMPARE( callCount, 2 );
+
+    model.invalidateSearchableTexts();
+    QCOMPARE( texts(), QStringList() << "pie" );
+    QCOMPARE( callCount, 3 );
+
+    // Big texts are not cached.
+    const QString bigText(1024 * 1024, 'x');
+    model.setData( model.index(0), createDataMap(mimeText, bigText), contentType::data );
+    QCOMPARE( texts(), QStringList() << bigText );
+    QCOMPARE( texts(), QStringList() << bigText );
+    QCOMPARE( callCount, 5 );
+}
+
+void Tests::textMatcher()
+{
+    const auto matches = [](const QRegExp &re, const QString &text) {
+        return TextMatcher(re).matches(text);
+    };
+
+    QVERIFY( TextMatcher(QRegExp("apple", Qt::CaseInsensitive)).isLiteral() );
+    QVERIFY( TextMatcher(QRegExp("a.b", Qt::CaseInsensitive, QRegExp::FixedString)).isLiteral() );
+    QVERIFY( !TextMatcher(QRegExp("a.b", Qt::CaseInsensitive)).isLiteral() );
+    QVERIFY( !TextMatcher(QRegExp("a\\.b", Qt::CaseInsensitive)).isLiteral() );
+    QVERIFY( !TextMatcher(QRegExp("a*", Qt::CaseInsensitive, QRegExp::Wildcard)).isLiteral() );
+
+    QVERIFY( matches(QRegExp("APPLE", Qt::CaseInsensitive), "pineapple pie") );
+    QVERIFY( !matches(QRegExp("APPLE", Qt::CaseSensitive), "pineapple pie") );
+    QVERIFY( matches(QRegExp("a.b", Qt::CaseInsensitive, QRegExp::FixedString), "x a.b y") );
+    QVERIFY( !matches(QRegExp("a.b", Qt::CaseInsensitive, QRegExp::FixedString), "acb") );
+    QVERIFY( matches(QRegExp("a.b", Qt::CaseInsensitive), "acb") );
+    QVERIFY( matches(QRegExp(), "anything") );
+
+    const QRegExp fuzzyRe = FuzzyMatcher("a.b", Qt::CaseInsensitive).regExp();
+    QVERIFY( TextMatcher(fuzzyRe).isFuzzy() );
+    QVERIFY( !TextMatcher(QRegExp("a.*b", Qt::CaseInsensitive, QRegExp::Wildcard)).isFuzzy() );
+    QVERIFY( !TextMatcher(QRegExp("a.*b+", Qt::CaseInsensitive)).isFuzzy() );
+    QVERIFY( matches(fuzzyRe, "xA\n.\nB") );
+    QVERIFY( !matches(fuzzyRe, "ab.") );
+    QVERIFY( !matches(fuzzyRe, "aXb") );
+
+    const TextMatcher matcher( QRegExp("pie") );
+    QVERIFY( matcher.matchesAny(QStringList() << "apple" << "pie") );
+    QVERIFY( !matcher.matchesAny(QStringList() << "apple" << "cherry") );
+    QVERIFY( !matcher.matchesAny(QStringList()) );
+}
+
+void Tests::searchTabs()
+{
+    const auto tab = testTab(1);
+    RUN("add" << "apple", "");
+    RUN("tab" << tab << "add" << "pineapple" << "x", "");
+
+    RUN("searchTabs" << "apple", QString(clipboardTabName) + "\t0\n" + tab + "\t1\n");
+    RUN("searchTabs" << "^x$", tab + "\t0\n");
+    RUN("eval" << "searchTabs('APPLE')[1].row", "1\n");
+
+    // Best fuzzy matches are first.
+    ItemTabSearch search( FuzzyMatcher("ab", Qt::CaseInsensitive).regExp() );
+    search.addTab( "1", QVector<QStringList>() << (QStringList() << "a_b") << (QStringList() << "xyz") );
+    search.addTab( "2", QVector<QStringList>() << (QStringList() << "ab") );
+
+    const QVector<ItemTabSearchResult> results = search.results();
+    QCOMPARE( results.size(), 2 );
+    QCOMPARE( results[0].tabName, QString("2") );
+    QCOMPARE( results[1].tabName, QString("1") );
+    QCOMPARE( results[1].row, 0 );
+    QCOMPARE( search.results(1).size(), 1 );
+}
+
+void Tests::benchmarkItemList_data()
+{
+    QTest::addColumn<int>("itemCount");
+    QTest::addColumn<bool>("qlist");
+
+    QTest::newRow("QList, 10k items") << 10000 << true;
+    QTest::newRow("QList, 100k items") << 100000 << true;
+    QTest::newRow("ClipboardItemList, 10k items") << 10000 << false;
+    QTest::newRow("ClipboardItemList, 100k items") << 100000 << false;
+}
+
+void Tests::benchmarkItemList()
+{
+    QFETCH(int, itemCount);
+    QFETCH(bool, qlist);
+
+    if (qlist)
+        benchmarkItemList<QListItemList>(itemCount);
+    else
+        benchmarkItemList<ClipboardItemList>(itemCount);
+}
+
+void Tests::benchmarkHistory_data()
+{
+    QTest::addColumn<int>("itemCount");
+    QTest::addColumn<QString>("operation");
+
+    // Bigger tabs are benchmarked last since these can be skipped.
+    for ( const int itemCount : {10000, 100000, 1000000} ) {
+        for ( const auto operation : {"open", "insert", "filter", "save"} ) {
+            const auto name = QString("%1, %2 items").arg(operation).arg(itemCount);
+            QTest::newRow(name.toUtf8().constData()) << itemCount << QString(operation);
+        }
+    }
+}
+
+void Tests::benchmarkHistory()
+{
+    QFETCH(int, itemCount);
+    QFETCH(QString, operation);
+
+    if ( itemCount > 100000 && qgetenv("COPYQ_TESTS_BENCHMARK_LARGE").isEmpty() )
+        SKIP("Set COPYQ_TESTS_BENCHMARK_LARGE=1 to benchmark bigger tabs");
+
+    ClipboardModel model;
+    model.setMaxItems(itemCount);
+
+    QVector<QVariantMap> dataList;
+    dataList.reserve(itemCount);
+    for (int i = 0; i < itemCount; ++i) {
+        QVariantMap data;
+        data.insert( mimeText, QByteArray("Item ") + QByteArray::number(i) );
+        dataList.append(data);
+    }
+    model.insertItems(dataList, 0);
+
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+
+    if (operation == "open") {
+        QVERIFY( serializeData(model, &file) );
+        QBENCHMARK {
+            ClipboardModel loadedModel;
+            loadedModel.setMaxItems(itemCount);
+            QVERIFY( file.seek(0) );
+            QVERIFY( deserializeData(&loadedModel, &file) );
+            QCOMPARE( loadedModel.rowCount(), itemCount );
+        }
+    } else if (operation == "insert") {
+        int i = 0;
+        QBENCHMARK {
+            // New unique item is added to full tab and the oldest one is removed.
+            QVariantMap data;
+            data.insert( mimeText, QByteArray("New item ") + QByteArray::number(++i) );
+            QCOMPARE( model.findItem(hash(data)), -1 );
+            model.insertItem(data, 0);
+            QVERIFY( model.removeRows(itemCount, 1) );
+        }
+    } else if (operation == "filter") {
+        QBENCHMARK {
+            int found = 0;
+            for (int row = 0; row < model.rowCount(); ++row) {
+                if ( model.index(row).data(contentType::text).toString().contains("999") )
+                    ++found;
+            }
+            QVERIFY(found > 0);
+        }
+    } else if (operation == "save") {
+        QBENCHMARK {
+            QVERIFY( file.resize(0) );
+            QVERIFY( file.seek(0) );
+            QVERIFY( serializeData(model, &file) );
+        }
+    }
+}
+
+void Tests::benchmarkFilter_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<bool>("useTextMatcher");
+
+    for ( const auto pattern : {"item 9999", "item 9+"} ) {
+        QTest::newRow( QString("QRegExp, %1").arg(pattern).toUtf8().constData() )
+                << QString(pattern) << false;
+        QTest::newRow( QString("TextMatcher, %1").arg(pattern).toUtf8().constData() )
+                << QString(pattern) << true;
+    }
+}
+
+void Tests::benchmarkFilter()
+{
+    QFETCH(QString, pattern);
+    QFETCH(bool, useTextMatcher);
+
+    const int itemCount = 10000;
+    const QString text = QString("Lorem ipsum dolor sit amet, consectetur adipiscing elit. ").repeated(4);
+
+    QVector<QStringList> texts;
+    texts.reserve(itemCount);
+    for (int i = 0; i < itemCount; ++i)
+        texts.append( QStringList() << text + "Item " + QString::number(i) << "notes" );
+
+    const QRegExp re(pattern, Qt::CaseInsensitive, QRegExp::RegExp2);
+    const TextMatcher matcher(re);
+
+    QBENCHMARK {
+        int found = 0;
+        for (const auto &itemTexts : texts) {
+            if (useTextMatcher) {
+                if ( matcher.matchesAny(itemTexts) )
+                    ++found;
+            } else {
+                for (const auto &itemText : itemTexts) {
+                    if ( re.indexIn(itemText) != -1 ) {
+                        ++found;
+                        break;
+                    }
+                }
+            }
+        }
+        QVERIFY(found > 0);
+    }
+}
+
 int Tests::run(const QStringList &arguments, QByteArray *stdoutData, QByteArray *stderrData, const QByteArray &in)
 {
     return m_test->run(arguments, stdoutData, stderrData, in);
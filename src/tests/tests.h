@@ -109,6 +109,7 @@ private slots:
     void chainingCommands();
 
     void configMaxitems();
+    void archiveItems();
 
     void keysAndFocusing();
 
@@ -137,6 +138,9 @@ private slots:
     void renameTab();
     void importExportTab();
 
+    void saveItemChanges();
+    void saveSameDataInMultipleTabs();
+
     void removeAllFoundItems();
 
     void nextPrevious();
@@ -159,6 +163,38 @@ private slots:
     void configMove();
     void configTrayTabIsCurrent();
 
+    void itemDataHash();
+    void batchModelChanges();
+    void deserializeItemsInSlices();
+    void lzCodec();
+    void spillItemData();
+    void itemFormatIds();
+    void mapItemData();
+    void saveItemsWithMissingBlob();
+
+    void searchIndex();
+
+    void filterRefinement();
+
+    void filterInBackground();
+
+    void fuzzyMatch();
+
+    void searchableTextsCache();
+
+    void textMatcher();
+
+    void searchTabs();
+
+    void benchmarkItemList_data();
+    void benchmarkItemList();
+
+    void benchmarkHistory_data();
+    void benchmarkHistory();
+
+    void benchmarkFilter_data();
+    void benchmarkFilter();
+
 private:
     void clearServerErrors();
     int run(const QStringList &arguments, QByteArray *stdoutData = nullptr,